@@ -2,11 +2,19 @@
 
 # usage example:
 # ./CompileShaders.sh skybox
+# ./CompileShaders.sh cull
 
 
 Shader_Name="$1"
-${VULKAN_SDK}/Bin/glslangValidator.exe -V ${Shader_Name}.vert
-${VULKAN_SDK}/Bin/glslangValidator.exe -V ${Shader_Name}.frag
+for Stage in vert frag comp
+do
+    if [ -f "${Shader_Name}.${Stage}" ]; then
+        ${VULKAN_SDK}/Bin/glslangValidator.exe -V ${Shader_Name}.${Stage}
+        mv ${Stage}.spv "${Shader_Name}_${Stage}.spv"
 
-mv vert.spv "${Shader_Name}_vert.spv"
-mv frag.spv "${Shader_Name}_frag.spv"
+        # stages reading bindless materials get a second variant, picked at runtime when the device supports it
+        if grep -q "VV_BINDLESS_MATERIALS" "${Shader_Name}.${Stage}"; then
+            ${VULKAN_SDK}/Bin/glslangValidator.exe -V -DVV_BINDLESS_MATERIALS ${Shader_Name}.${Stage} -o "${Shader_Name}_bindless_${Stage}.spv"
+        fi
+    fi
+done
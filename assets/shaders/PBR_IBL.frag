@@ -2,6 +2,9 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 #extension GL_ARB_shading_language_420pack : enable
+#ifdef VV_BINDLESS_MATERIALS
+#extension GL_EXT_nonuniform_qualifier : require // runtime sized texture array
+#endif
 
 #define MAX_LIGHTS 5
 #define ONE_OVER_PI 0.3183098861837906715377675267450
@@ -17,14 +20,47 @@ layout(set = 0, binding = 2) uniform LightData
     Light lights[MAX_LIGHTS];
 } lights;
 
+// per draw constants, see DrawConstants
 layout(push_constant) uniform PushConstants
 {
     uint total_mip_levels;
+    uint material_index;
 } constants;
 
+#ifdef VV_BINDLESS_MATERIALS
+struct MaterialData
+{
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    float shininess;
+    uint albedo_map;
+    uint normal_map;
+    uint roughness_map;
+    uint metalness_map;
+    uint emissiveness_map;
+    uint ambient_occlusion_map;
+    uint ambient_map;
+    uint diffuse_map;
+    uint specular_map;
+};
+
+// every material of the scene. the draw's material index is pushed with each bucket.
+layout(set = 1, binding = 0) readonly buffer MaterialBuffer
+{
+    MaterialData materials[];
+} material_buffer;
+
+layout(set = 1, binding = 1) uniform sampler2D textures[];
+
+#define albedo_map textures[material_buffer.materials[constants.material_index].albedo_map]
+#define roughness_map textures[material_buffer.materials[constants.material_index].roughness_map]
+#define metalness_map textures[material_buffer.materials[constants.material_index].metalness_map]
+#else
 layout (set = 1, binding = 0) uniform sampler2D albedo_map;
 layout (set = 1, binding = 1) uniform sampler2D roughness_map;
 layout (set = 1, binding = 2) uniform sampler2D metalness_map;
+#endif
 
 layout (set = 2, binding = 0) uniform samplerCube d_irradiance_map;
 layout (set = 2, binding = 1) uniform samplerCube s_irradiance_map;
@@ -10,11 +10,17 @@ layout(set = 0, binding = 0) uniform SceneUBO
     vec4 camera_position;
 } scene_ubo;
 
-layout(set = 0, binding = 1) uniform ModelUBO
+struct InstanceData
 {
     mat4 model;
     mat4 normal;
-} model_ubo;
+};
+
+// one entry per instance. gl_InstanceIndex already includes the firstInstance of the draw.
+layout(set = 0, binding = 1) readonly buffer InstanceBuffer
+{
+    InstanceData instances[];
+} instance_buffer;
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
@@ -27,15 +33,17 @@ layout(location = 3) out vec2 uv;
 
 out gl_PerVertex
 {
-    vec4 gl_Position;
+    invariant vec4 gl_Position; // matches the depth pre-pass
 };
 
 void main()
 {
-    vec4 frag_position = model_ubo.model * vec4(position, 1.0);
-    gl_Position = scene_ubo.projection * scene_ubo.view * frag_position;
+    InstanceData instance = instance_buffer.instances[gl_InstanceIndex];
+
+    vec4 frag_position = instance.model * vec4(position, 1.0);
+    gl_Position = scene_ubo.projection * scene_ubo.view * instance.model * vec4(position, 1.0);
     w_frag_position = frag_position.xyz;
     w_cam_position = vec3(scene_ubo.camera_position);
-    w_normal = (model_ubo.normal * vec4(normal, 1.0)).xyz;
+    w_normal = (instance.normal * vec4(normal, 1.0)).xyz;
     uv = tex_coord;
 }
\ No newline at end of file
@@ -0,0 +1,38 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+layout(set = 0, binding = 0) uniform SceneUBO 
+{
+    mat4 view;
+    mat4 projection;
+    vec4 camera_position;
+} scene_ubo;
+
+struct InstanceData
+{
+    mat4 model;
+    mat4 normal;
+};
+
+// one entry per instance. gl_InstanceIndex already includes the firstInstance of the draw.
+layout(set = 0, binding = 1) readonly buffer InstanceBuffer
+{
+    InstanceData instances[];
+} instance_buffer;
+
+layout(location = 0) in vec3 position;
+
+// the main pass tests against this depth with EQUAL. every model vertex shader computes gl_Position with the exact
+// same expression and declares it invariant, so both passes produce bit identical depth.
+out gl_PerVertex
+{
+    invariant vec4 gl_Position;
+};
+
+void main()
+{
+    InstanceData instance = instance_buffer.instances[gl_InstanceIndex];
+
+    gl_Position = scene_ubo.projection * scene_ubo.view * instance.model * vec4(position, 1.0);
+}
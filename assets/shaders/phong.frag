@@ -2,6 +2,9 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 #extension GL_ARB_shading_language_420pack : enable
+#ifdef VV_BINDLESS_MATERIALS
+#extension GL_EXT_nonuniform_qualifier : require // runtime sized texture array
+#endif
 
 #define MAX_LIGHTS 5
 
@@ -16,6 +19,43 @@ layout(set = 0, binding = 2) uniform LightData
     Light lights[MAX_LIGHTS];
 } lights;
 
+#ifdef VV_BINDLESS_MATERIALS
+// per draw constants, see DrawConstants. only the material index is read here.
+layout(push_constant) uniform PushConstants
+{
+    uint total_mip_levels;
+    uint material_index;
+} constants;
+
+struct MaterialData
+{
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    float shininess;
+    uint albedo_map;
+    uint normal_map;
+    uint roughness_map;
+    uint metalness_map;
+    uint emissiveness_map;
+    uint ambient_occlusion_map;
+    uint ambient_map;
+    uint diffuse_map;
+    uint specular_map;
+};
+
+// every material of the scene. the draw's material index is pushed with each bucket.
+layout(set = 1, binding = 0) readonly buffer MaterialBuffer
+{
+    MaterialData materials[];
+} material_buffer;
+
+layout(set = 1, binding = 1) uniform sampler2D textures[];
+
+#define properties material_buffer.materials[constants.material_index]
+#define diffuse_map textures[material_buffer.materials[constants.material_index].diffuse_map]
+#define specular_map textures[material_buffer.materials[constants.material_index].specular_map]
+#else
 layout(set = 1, binding = 0) uniform MaterialConstants
 {
     vec4 ambient;
@@ -26,6 +66,7 @@ layout(set = 1, binding = 0) uniform MaterialConstants
 
 layout(set = 1, binding = 1) uniform sampler2D diffuse_map;
 layout(set = 1, binding = 2) uniform sampler2D specular_map;
+#endif
 
 layout (location = 0) in vec3 frag_position;
 layout(location = 1) in vec2 tex_coord;
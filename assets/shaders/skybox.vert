@@ -10,11 +10,17 @@ layout(set = 0, binding = 0) uniform SceneUBO
     vec4 camera_position;
 } scene_ubo;
 
-layout(set = 0, binding = 1) uniform ModelUBO
+struct InstanceData
 {
     mat4 model;
     mat4 normal;
-} model_ubo;
+};
+
+// one entry per instance. gl_InstanceIndex already includes the firstInstance of the draw.
+layout(set = 0, binding = 1) readonly buffer InstanceBuffer
+{
+    InstanceData instances[];
+} instance_buffer;
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
@@ -10,11 +10,17 @@ layout(set = 0, binding = 0) uniform SceneUBO
     vec4 camera_position;
 } scene_ubo;
 
-layout(set = 0, binding = 1) uniform ModelUBO
+struct InstanceData
 {
     mat4 model;
     mat4 normal;
-} model_ubo;
+};
+
+// one entry per instance. gl_InstanceIndex already includes the firstInstance of the draw.
+layout(set = 0, binding = 1) readonly buffer InstanceBuffer
+{
+    InstanceData instances[];
+} instance_buffer;
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
@@ -24,11 +30,13 @@ layout(location = 0) out vec3 camera_position;
 
 out gl_PerVertex
 {
-    vec4 gl_Position;
+    invariant vec4 gl_Position; // matches the depth pre-pass
 };
 
 void main()
 {
-    gl_Position = scene_ubo.projection * scene_ubo.view * model_ubo.model * vec4(position, 1.0);
+    InstanceData instance = instance_buffer.instances[gl_InstanceIndex];
+
+    gl_Position = scene_ubo.projection * scene_ubo.view * instance.model * vec4(position, 1.0);
     camera_position = vec3(scene_ubo.camera_position);
 }
\ No newline at end of file
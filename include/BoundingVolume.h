@@ -0,0 +1,95 @@
+#ifndef VIRTUALVISTA_BOUNDINGVOLUME_H
+#define VIRTUALVISTA_BOUNDINGVOLUME_H
+
+#include <cfloat>
+#include <algorithm>
+
+#include "glm/glm.hpp"
+
+namespace vv
+{
+    struct AABB
+    {
+        glm::vec3 min = glm::vec3(FLT_MAX);
+        glm::vec3 max = glm::vec3(-FLT_MAX);
+
+        void expand(const glm::vec3 &point)
+        {
+            min = glm::min(min, point);
+            max = glm::max(max, point);
+        }
+
+        glm::vec3 getCenter() const
+        {
+            return (min + max) * 0.5f;
+        }
+
+        glm::vec3 getExtents() const
+        {
+            return (max - min) * 0.5f;
+        }
+
+        float getSurfaceArea() const
+        {
+            glm::vec3 size = max - min;
+            return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+        }
+
+        bool contains(const AABB &other) const
+        {
+            return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::greaterThanEqual(max, other.max));
+        }
+
+        static AABB merge(const AABB &a, const AABB &b)
+        {
+            AABB result;
+            result.min = glm::min(a.min, b.min);
+            result.max = glm::max(a.max, b.max);
+            return result;
+        }
+
+        /*
+         * Returns the box enclosing this one after transformation. Projects the extents onto the transformed axes
+         * instead of transforming all eight corners.
+         */
+        AABB transform(const glm::mat4 &transformation) const
+        {
+            glm::vec3 center = glm::vec3(transformation * glm::vec4(getCenter(), 1.0f));
+            glm::vec3 extents = getExtents();
+
+            glm::vec3 world_extents;
+            for (int i = 0; i < 3; ++i)
+                world_extents[i] = std::abs(transformation[0][i]) * extents.x +
+                                   std::abs(transformation[1][i]) * extents.y +
+                                   std::abs(transformation[2][i]) * extents.z;
+
+            AABB result;
+            result.min = center - world_extents;
+            result.max = center + world_extents;
+            return result;
+        }
+    };
+
+    struct BoundingSphere
+    {
+        glm::vec3 center = glm::vec3(0.0f);
+        float radius = 0.0f;
+
+        /*
+         * Returns the sphere enclosing this one after transformation. Non uniform scaling grows the radius by the
+         * largest axis scale.
+         */
+        BoundingSphere transform(const glm::mat4 &transformation) const
+        {
+            float scale = std::max(glm::length(glm::vec3(transformation[0])),
+                          std::max(glm::length(glm::vec3(transformation[1])), glm::length(glm::vec3(transformation[2]))));
+
+            BoundingSphere result;
+            result.center = glm::vec3(transformation * glm::vec4(center, 1.0f));
+            result.radius = radius * scale;
+            return result;
+        }
+    };
+}
+
+#endif // VIRTUALVISTA_BOUNDINGVOLUME_H
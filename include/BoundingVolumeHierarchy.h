@@ -0,0 +1,124 @@
+#ifndef VIRTUALVISTA_BOUNDINGVOLUMEHIERARCHY_H
+#define VIRTUALVISTA_BOUNDINGVOLUMEHIERARCHY_H
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "BoundingVolume.h"
+#include "Frustum.h"
+
+namespace vv
+{
+    /*
+     * Dynamic AABB tree. Leaves hold a slightly enlarged copy of their box so small movements don't touch the tree, and
+     * insertions keep it height balanced with tree rotations. Queries visit O(log n) nodes plus the leaves they report.
+     */
+	class BoundingVolumeHierarchy
+	{
+	public:
+        static const uint32_t null_proxy = 0xFFFFFFFF;
+
+		BoundingVolumeHierarchy();
+		~BoundingVolumeHierarchy();
+
+        /*
+         * Removes every leaf. Keeps the node storage around.
+         */
+        void clear();
+
+        /*
+         * Adds a leaf for box and returns its proxy id. user_data is what queries report back for the leaf.
+         */
+        uint32_t insert(const AABB &box, uint32_t user_data);
+
+        /*
+         * Removes a leaf. proxy may be handed out again by later insertions.
+         */
+        void remove(uint32_t proxy);
+
+        /*
+         * Updates the box of a leaf after its object moved. The leaf is only reinserted once box leaves the enlarged
+         * copy stored in the tree. Returns whether that happened.
+         */
+        bool refit(uint32_t proxy, const AABB &box);
+
+        uint32_t getUserData(uint32_t proxy) const;
+        const AABB& getBox(uint32_t proxy) const;
+
+        /*
+         * Returns the number of leaves.
+         */
+        uint32_t getLeafCount() const;
+
+        /*
+         * Returns the height of the tree. A single leaf has height 0.
+         */
+        uint32_t getHeight() const;
+
+        /*
+         * Collects the user data of leaves touching frustum. Leaves under nodes completely inside go to inside without
+         * being tested. intersecting gets leaves whose enlarged box straddles a plane. Their exact boxes still need a test.
+         */
+        void queryFrustum(const Frustum &frustum, std::vector<uint32_t> &inside, std::vector<uint32_t> &intersecting) const;
+
+        /*
+         * Collects the user data of leaves whose box touches sphere.
+         */
+        void querySphere(const BoundingSphere &sphere, std::vector<uint32_t> &results) const;
+
+        /*
+         * Finds the leaf whose box is hit first by the ray. direction does not need to be normalized. distance is measured
+         * in multiples of it. Returns false when nothing is hit before max_distance.
+         */
+        bool raycast(const glm::vec3 &origin, const glm::vec3 &direction, float max_distance, uint32_t &user_data, float &distance) const;
+
+	private:
+        struct Node
+        {
+            AABB box;                                   // enlarged for leaves
+            AABB tight_box;                             // leaves only. what the leaf was last given.
+            uint32_t parent         = null_proxy;       // next free node while on the free list
+            uint32_t left           = null_proxy;
+            uint32_t right          = null_proxy;
+            int32_t height          = -1;               // 0 for leaves, -1 while free
+            uint32_t user_data      = 0;
+
+            bool isLeaf() const { return left == null_proxy; }
+        };
+
+        std::vector<Node> _nodes;
+        uint32_t _root              = null_proxy;
+        uint32_t _free_list         = null_proxy;
+        uint32_t _leaf_count        = 0;
+
+        uint32_t allocateNode();
+        void freeNode(uint32_t index);
+
+        /*
+         * Finds the cheapest sibling by surface area heuristic and links leaf next to it.
+         */
+        void insertLeaf(uint32_t leaf);
+        void removeLeaf(uint32_t leaf);
+
+        /*
+         * Recomputes heights and boxes from index up to the root, rotating unbalanced nodes on the way.
+         */
+        void refitAncestors(uint32_t index);
+
+        /*
+         * Rotates the taller grandchild up if the children of index differ in height by more than one. Returns the node
+         * now at the position of index.
+         */
+        uint32_t balance(uint32_t index);
+
+        /*
+         * Appends the user data of every leaf below index.
+         */
+        void collectLeaves(uint32_t index, std::vector<uint32_t> &results) const;
+
+        static AABB enlarge(const AABB &box);
+	};
+}
+
+#endif // VIRTUALVISTA_BOUNDINGVOLUMEHIERARCHY_H
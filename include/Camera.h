@@ -50,6 +50,11 @@ namespace vv
          */
         glm::mat4 getProjectionMatrix(float aspect) const;
         glm::mat4 getViewMatrix() const;
+
+        /*
+         * Returns the distance of the far clipping plane.
+         */
+        float getFarPlane() const;
 		
 	private:
         float _fov_y;
@@ -0,0 +1,119 @@
+#ifndef VIRTUALVISTA_CULLINGPASS_H
+#define VIRTUALVISTA_CULLINGPASS_H
+
+#include <array>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "VulkanDevice.h"
+#include "VulkanSwapChain.h"
+#include "VulkanRingBuffer.h"
+#include "VulkanImage.h"
+#include "VulkanImageView.h"
+#include "VulkanSampler.h"
+#include "VulkanPipeline.h"
+#include "Shader.h"
+
+namespace vv
+{
+    // Per frame input of the cull shader. Offsets are relative to the instance block the buffer views are bound at.
+    struct CullingUniforms
+    {
+        glm::vec4 frustum_planes[6];
+        glm::mat4 previous_view_projection;     // camera the depth pyramid was rendered with
+        glm::vec4 pyramid_extent;               // width, height and level count of the depth pyramid
+        uint32_t instance_count;
+        uint32_t source_offset;                 // first unculled instance, in instances
+        uint32_t bounds_offset;                 // first world space box, in vec4s. center, then extents + command index.
+        uint32_t command_offset;                // first draw command, in uints
+        uint32_t occlusion_enabled;
+        uint32_t padding[3];
+    };
+
+    /*
+     * Culls instances on the gpu right before they are drawn. Every instance is tested against the frustum and against
+     * a depth pyramid built from the previous frame's depth. Survivors are compacted into the instance data and counted
+     * into the instanceCount of their indirect draw command.
+     *
+     * note: occlusion uses last frame's depth, so geometry revealed by a large camera jump can be missing for one frame.
+     */
+	class CullingPass
+	{
+	public:
+		CullingPass();
+		~CullingPass();
+
+        /*
+         * Creates the depth pyramid for the depth attachment of swap_chain, both compute pipelines and their descriptor
+         * sets. ring_buffer is where the scene streams instances, bounds, draw commands and the culling uniforms.
+         */
+		void create(VulkanDevice *device, VulkanSwapChain *swap_chain, VulkanRingBuffer *ring_buffer);
+
+		/*
+		 *
+		 */
+		void shutDown();
+
+        /*
+         * Records the cull dispatch. Must be recorded outside of a render pass. instance_block_offset is where the
+         * instance block of the frame starts, uniform_offset where its CullingUniforms were written.
+         */
+        void recordCulling(VkCommandBuffer command_buffer, uint32_t uniform_offset, uint32_t instance_block_offset, uint32_t instance_count);
+
+        /*
+         * Rebuilds the depth pyramid from the depth attachment that was just rendered to. Record right after the render pass.
+         */
+        void recordDepthPyramid(VkCommandBuffer command_buffer);
+
+        /*
+         * Returns the size of the most detailed pyramid level.
+         */
+        VkExtent2D getPyramidExtent() const;
+
+        uint32_t getPyramidLevelCount() const;
+
+	private:
+        VulkanDevice *_device                               = nullptr;
+        VulkanSwapChain *_swap_chain                        = nullptr;
+        VulkanRingBuffer *_ring_buffer                      = nullptr;
+        VkDescriptorPool _descriptor_pool                   = VK_NULL_HANDLE;
+
+        // power of two sized, so every level maps onto the screen exactly. stays in the general layout.
+        VulkanImage *_depth_pyramid                         = nullptr;
+        VulkanImageView *_depth_pyramid_view                = nullptr;
+        std::vector<VulkanImageView *> _level_views;
+        VulkanImageView *_depth_view                        = nullptr; // depth aspect of the attachment only
+        VulkanSampler *_sampler                             = nullptr;
+        VkExtent2D _pyramid_extent;
+
+        Shader *_cull_shader                                = nullptr;
+        VkDescriptorSetLayout _cull_descriptor_set_layout   = VK_NULL_HANDLE;
+        VkPipelineLayout _cull_pipeline_layout              = VK_NULL_HANDLE;
+        VulkanPipeline *_cull_pipeline                      = nullptr;
+        VkDescriptorSet _cull_descriptor_set                = VK_NULL_HANDLE;
+
+        // level i reads level i - 1. level 0 reads the depth attachment.
+        Shader *_pyramid_shader                             = nullptr;
+        VkDescriptorSetLayout _pyramid_descriptor_set_layout = VK_NULL_HANDLE;
+        VkPipelineLayout _pyramid_pipeline_layout           = VK_NULL_HANDLE;
+        VulkanPipeline *_pyramid_pipeline                   = nullptr;
+        std::vector<VkDescriptorSet> _pyramid_descriptor_sets;
+
+        /*
+         * Creates the pyramid image, one view per level and moves it into the general layout.
+         */
+        void createDepthPyramid();
+
+        /*
+         * Creates the descriptor pool, layouts and sets of both passes and points them at their resources.
+         */
+        void createDescriptorSets();
+
+        /*
+         * Loads the compute shaders and creates their pipelines.
+         */
+        void createPipelines();
+	};
+}
+
+#endif // VIRTUALVISTA_CULLINGPASS_H
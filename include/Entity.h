@@ -18,15 +18,23 @@ namespace vv
         glm::vec3 getPosition() const;
         glm::mat3 getRotation() const;
 
+        /*
+         * Returns whether the entity passed culling in the last rendered frame.
+         */
+        bool isVisible() const;
+
         virtual void translate(glm::vec3 translation);
         virtual void rotate(float angle, glm::vec3 axis);
         void scale(glm::vec3 scaling);
 
     protected:
-        // todo: use for occlusion checking
+        // whether any part of the entity passed culling in the last frame
         bool _is_visible;
         bool _is_renderable;
 
+        // set whenever the pose changes. cleared by the scene once uniforms and bounds caught up.
+        bool _has_moved;
+
         glm::mat4 _pose;
 
 	private:
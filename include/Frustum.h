@@ -0,0 +1,82 @@
+#ifndef VIRTUALVISTA_FRUSTUM_H
+#define VIRTUALVISTA_FRUSTUM_H
+
+#include <cstdint>
+#include <vector>
+#include <array>
+
+#include "glm/glm.hpp"
+#include "BoundingVolume.h"
+
+namespace vv
+{
+    // Boxes in center/extents form laid out per component, so four of them can be tested with one instruction.
+    struct CullBounds
+    {
+        std::vector<float> center_x, center_y, center_z;
+        std::vector<float> extent_x, extent_y, extent_z;
+        std::size_t count = 0;
+
+        /*
+         * Resizes all components. Storage is padded to a multiple of four so the simd loop never reads past the end.
+         */
+        void resize(std::size_t box_count);
+
+        /*
+         * Stores box at index i.
+         */
+        void set(std::size_t i, const AABB &box);
+    };
+
+    enum class FrustumTest
+    {
+        Outside,
+        Intersecting,
+        Inside
+    };
+
+    struct CullingStatistics
+    {
+        uint32_t visible_count  = 0;
+        uint32_t culled_count   = 0;
+    };
+
+	class Frustum
+	{
+	public:
+		Frustum();
+		~Frustum();
+
+        /*
+         * Extracts the six clipping planes from a combined projection * view matrix.
+         */
+        void update(const glm::mat4 &view_projection);
+
+        /*
+         * Tests a single box against all planes. Returns false only when the box is completely outside.
+         */
+        bool intersects(const AABB &box) const;
+
+        /*
+         * Like intersects() but also tells boxes completely inside apart, so hierarchies can skip testing their children.
+         */
+        FrustumTest classify(const AABB &box) const;
+
+        /*
+         * Tests every box in bounds, four at a time when sse is available. visible[i] is set to 1 for boxes that
+         * intersect the frustum and 0 for the ones that are completely outside.
+         */
+        void cull(const CullBounds &bounds, std::vector<uint8_t> &visible) const;
+
+        /*
+         * Returns left, right, bottom, top, near and far plane in that order. i.e. for uploading to shaders.
+         */
+        const std::array<glm::vec4, 6>& getPlanes() const;
+
+	private:
+        // ax + by + cz + d >= 0 inside. planes are not normalized, the tests only compare signs.
+        std::array<glm::vec4, 6> _planes;
+	};
+}
+
+#endif // VIRTUALVISTA_FRUSTUM_H
@@ -0,0 +1,80 @@
+#ifndef VIRTUALVISTA_GEOMETRYBUFFER_H
+#define VIRTUALVISTA_GEOMETRYBUFFER_H
+
+#include <vector>
+
+#include "Utils.h"
+#include "VulkanDevice.h"
+#include "VulkanBuffer.h"
+#include "VulkanCommandEncoder.h"
+
+namespace vv
+{
+    // Location of a mesh within the shared geometry buffers. Indices are relative to vertex_offset.
+    struct GeometryRange
+    {
+        uint32_t page           = 0;
+        uint32_t first_index    = 0;
+        uint32_t index_count    = 0;
+        int32_t vertex_offset   = 0;
+        uint32_t vertex_count   = 0;
+    };
+
+	class GeometryBuffer
+	{
+	public:
+		GeometryBuffer();
+		~GeometryBuffer();
+
+		/*
+		 * Packs all static geometry into a few large vertex and index buffers. Meshes only keep the range they occupy,
+         * so a single bind of both buffers serves every draw out of the same page.
+		 */
+		void create(VulkanDevice *device);
+
+		/*
+		 *
+		 */
+		void shutDown();
+
+        /*
+         * Appends the geometry to a page with enough room left and queues its upload. The data can be released as soon
+         * as this returns.
+         *
+         * note: ranges live as long as the buffer. Static geometry is never unloaded individually.
+         */
+        GeometryRange allocate(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices);
+        GeometryRange allocate(const Vertex *vertices, uint32_t vertex_count, const uint32_t *indices, uint32_t index_count);
+
+        /*
+         * Binds the vertex and index buffer of page.
+         */
+        void bind(VulkanCommandEncoder &encoder, uint32_t page) const;
+
+        /*
+         * Returns the number of pages created so far.
+         */
+        uint32_t getPageCount() const;
+
+	private:
+        struct GeometryPage
+        {
+            VulkanBuffer vertex_buffer;
+            VulkanBuffer index_buffer;
+            uint32_t vertex_capacity    = 0;
+            uint32_t index_capacity     = 0;
+            uint32_t vertex_count       = 0;
+            uint32_t index_count        = 0;
+        };
+
+		VulkanDevice *_device = nullptr;
+        std::vector<GeometryPage *> _pages;
+
+        /*
+         * Creates a new page that holds at least the given amount of vertices and indices.
+         */
+        GeometryPage* createPage(uint32_t vertex_count, uint32_t index_count);
+	};
+}
+
+#endif // VIRTUALVISTA_GEOMETRYBUFFER_H
@@ -0,0 +1,155 @@
+#ifndef VIRTUALVISTA_GLTFIMPORTER_H
+#define VIRTUALVISTA_GLTFIMPORTER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Utils.h"
+#include "BoundingVolume.h"
+#include "MappedFile.h"
+
+namespace vv
+{
+    struct JsonValue;
+
+    // A triangle list placed in the scene, with the transforms of the nodes above it already applied.
+    struct GltfPrimitive
+    {
+        std::string name;
+        int material_id = -1;               // into GltfImporter::materials, -1 if none was set
+        uint32_t vertex_count = 0;
+        uint32_t index_count = 0;
+
+        // point into the mapped file if the accessors already are laid out like Vertex and uint32_t, otherwise into
+        // the storage below. only valid until GltfImporter::shutDown().
+        const Vertex *vertices = nullptr;
+        const uint32_t *indices = nullptr;
+        std::vector<Vertex> vertex_storage;
+        std::vector<uint32_t> index_storage;
+
+        AABB bounding_box;
+        BoundingSphere bounding_sphere;
+    };
+
+    // Image data is either a file next to the model or png/jpeg bytes embedded in one of its buffers.
+    struct GltfImage
+    {
+        std::string uri;                    // relative to path. empty if embedded.
+        const char *data = nullptr;         // only valid until GltfImporter::shutDown()
+        std::size_t size = 0;
+    };
+
+    // pbrMetallicRoughness material. Textures are indices into GltfImporter::images, -1 if unused.
+    struct GltfMaterial
+    {
+        std::string name;
+        float base_color_factor[4]          = { 1.0f, 1.0f, 1.0f, 1.0f };
+        float metallic_factor               = 1.0f;
+        float roughness_factor              = 1.0f;
+        float emissive_factor[3]            = { 0.0f, 0.0f, 0.0f };
+
+        int base_color_texture              = -1;
+        int metallic_roughness_texture      = -1;   // roughness in g, metalness in b
+        int normal_texture                  = -1;
+        int occlusion_texture               = -1;   // occlusion in r
+        int emissive_texture                = -1;
+    };
+
+	/*
+	 * glTF 2.0 reader for .gltf files with external or base64 buffers and binary .glb files. The files are memory
+	 * mapped. Geometry whose accessors already match Vertex (float position, normal and uv interleaved at a stride of
+	 * sizeof(Vertex)) and tightly packed 32 bit indices are handed out as pointers into the mapping, so they are only
+	 * ever copied once, into staging memory. Everything else is gathered in a single pass without any hashing.
+	 *
+	 * note: only triangle lists of the default scene are read. Sparse accessors, morph targets, skins, cameras and
+	 *       extensions are ignored. Primitives with a transformed node are always gathered, since the transform is
+	 *       baked into their vertices. If it mirrors them, their indices are gathered too, to restore the winding.
+	 */
+	class GltfImporter
+	{
+	public:
+        std::vector<GltfPrimitive> primitives;
+        std::vector<GltfMaterial> materials;
+        std::vector<GltfImage> images;
+
+        // vertices handed out straight from the mapping
+        uint64_t mapped_vertex_count = 0;
+
+		GltfImporter();
+		~GltfImporter();
+
+        /*
+         * Reads path + name and the buffers it references, which are looked up relative to path.
+         * Returns false and fills error if anything fails.
+         */
+        bool load(const std::string &path, const std::string &name, std::string &error);
+
+        /*
+         * Unmaps all files. Vertex, index and image pointers are invalid afterwards.
+         */
+        void shutDown();
+
+	private:
+        struct BufferView
+        {
+            const char *data = nullptr;
+            std::size_t size = 0;
+            uint32_t stride = 0;            // 0 if tightly packed
+        };
+
+        struct Accessor
+        {
+            int buffer_view = -1;
+            std::size_t offset = 0;
+            uint32_t component_type = 0;
+            uint32_t component_count = 0;
+            uint32_t count = 0;
+            uint32_t stride = 0;            // between elements, resolved from the buffer view
+            bool normalized = false;
+            bool has_bounds = false;
+            glm::vec3 min;
+            glm::vec3 max;
+        };
+
+        MappedFile _file;
+        std::vector<MappedFile> _buffer_files;
+        std::vector<std::vector<char> > _decoded_buffers;   // from base64 data uris
+        std::vector<BufferView> _buffers;                   // whole buffers, no stride
+        std::vector<BufferView> _buffer_views;
+        std::vector<Accessor> _accessors;
+
+        /*
+         * Resolves buffers, buffer views and accessors. glb_data is the BIN chunk of a .glb file, null otherwise.
+         */
+        bool loadBuffers(const JsonValue &document, const std::string &path, const char *glb_data, std::size_t glb_size,
+                         std::string &error);
+
+        /*
+         * Reads images, textures and materials.
+         */
+        bool loadMaterials(const JsonValue &document, std::string &error);
+
+        /*
+         * Appends the primitives of node and its children.
+         */
+        bool loadNode(const JsonValue &document, int node_index, const glm::mat4 &parent_transform, int depth, std::string &error);
+
+        /*
+         * Converts one primitive of a mesh into primitives.
+         */
+        bool loadPrimitive(const JsonValue &primitive, const std::string &name, const glm::mat4 &transform, std::string &error);
+
+        /*
+         * Returns the address of element i of accessor. Accessor ranges are checked when they are loaded.
+         */
+        const char* getElement(const Accessor &accessor, uint32_t i) const;
+
+        /*
+         * Reads element i of a float or normalized integer accessor into value.
+         */
+        void readFloats(const Accessor &accessor, uint32_t i, float *value) const;
+	};
+}
+
+#endif // VIRTUALVISTA_GLTFIMPORTER_H
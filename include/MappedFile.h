@@ -0,0 +1,55 @@
+#ifndef VIRTUALVISTA_MAPPEDFILE_H
+#define VIRTUALVISTA_MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Utils.h"
+
+namespace vv
+{
+	/*
+	 * Read only view of a whole file mapped into the address space. Pages are faulted in by the os as they are touched,
+	 * so nothing is copied and several threads can read different parts at once.
+	 */
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+
+        /*
+         * Maps the file at path. Returns false if it can't be opened. Empty files map successfully with a size of 0.
+         */
+		bool create(const std::string &path);
+
+		/*
+		 *
+		 */
+		void shutDown();
+
+        const char* getData() const;
+        std::size_t getSize() const;
+
+        /*
+         * Hashes the contents of the file at path. Returns false if it can't be read.
+         *
+         * note: only meant to notice edited files, not to resist deliberate collisions.
+         */
+        static bool hashFile(const std::string &path, uint64_t &hash);
+
+	private:
+        const char *_data       = nullptr;
+        std::size_t _size       = 0;
+
+#ifdef _WIN32
+        HANDLE _file            = INVALID_HANDLE_VALUE;
+        HANDLE _mapping         = nullptr;
+#else
+        int _file               = -1;
+#endif
+	};
+}
+
+#endif // VIRTUALVISTA_MAPPEDFILE_H
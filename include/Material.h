@@ -8,6 +8,7 @@
 #include "VulkanDevice.h"
 #include "TextureManager.h"
 #include "VulkanBuffer.h"
+#include "VulkanCommandEncoder.h"
 #include "VulkanImageView.h"
 #include "VulkanPipeline.h"
 
@@ -18,9 +19,18 @@ namespace vv
         std::string name;
         VkPipelineLayout pipeline_layout;
         VulkanPipeline *pipeline;
+        VulkanPipeline *depth_equal_pipeline; // main pass after a depth pre-pass. only shades the depth laid down. null for the skybox.
         Shader *shader;
-        VkDescriptorSetLayout material_descriptor_set_layout;
+        VkDescriptorSetLayout material_descriptor_set_layout; // null for bindless templates, which share MaterialTable's
         bool uses_environment_lighting;
+        bool uses_bindless_materials;
+    };
+
+    // Per draw push constants. Shaders declare the members they read at these offsets, in either stage.
+    struct DrawConstants
+    {
+        uint32_t total_mip_levels;      // environment lighting. pushed once per template.
+        uint32_t material_index;        // bindless materials. pushed per bucket.
     };
 
     struct UBOStore
@@ -39,6 +49,7 @@ namespace vv
 	{
 	public:
         MaterialTemplate *material_template;
+        uint32_t material_index = 0; // entry in the MaterialTable for bindless templates
 
 		Material();
 		~Material();
@@ -72,9 +83,11 @@ namespace vv
         void updateDescriptorSets() const;
 
         /*
-         * Binds all descriptor sets this instance has ownership over. Should be called at render time.
+         * Makes this material current for the following draws. Should be called at render time.
+         *
+         * note: materials of bindless templates only push their material_index. Everything else was bound with the template.
          */
-        void bindDescriptorSets(VkCommandBuffer command_buffer) const;
+        void bind(VulkanCommandEncoder &encoder) const;
 
 	private:
         VulkanDevice *_device;
@@ -0,0 +1,94 @@
+#ifndef VIRTUALVISTA_MATERIALTABLE_H
+#define VIRTUALVISTA_MATERIALTABLE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "glm/glm.hpp"
+#include "VulkanDevice.h"
+#include "VulkanBuffer.h"
+#include "VulkanCommandEncoder.h"
+#include "TextureManager.h"
+
+namespace vv
+{
+    // Parameters of one bindless material, mirrored by MaterialData in the shaders. Maps are indices into the texture array.
+    struct MaterialData
+    {
+        glm::vec4 ambient;
+        glm::vec4 diffuse;
+        glm::vec4 specular;
+        float shininess;
+        uint32_t albedo_map;
+        uint32_t normal_map;
+        uint32_t roughness_map;
+        uint32_t metalness_map;
+        uint32_t emissiveness_map;
+        uint32_t ambient_occlusion_map;
+        uint32_t ambient_map;
+        uint32_t diffuse_map;
+        uint32_t specular_map;
+        uint32_t padding[2];
+    };
+
+    /*
+     * Every bindless material in one place. Textures live in a single runtime sized sampler array, parameters in one
+     * storage buffer, both in a descriptor set that is bound once per pipeline. Draws find their material through the
+     * index Material::bind() pushes per bucket as DrawConstants::material_index.
+     *
+     * note: requires VulkanDevice::descriptor_indexing. Entries are only ever appended, so frames in flight never see
+     *       any of their data change.
+     */
+	class MaterialTable
+	{
+	public:
+        VkDescriptorSetLayout descriptor_set_layout = VK_NULL_HANDLE;
+
+		MaterialTable();
+		~MaterialTable();
+
+		/*
+		 * Creates the texture array, the material buffer and the descriptor set holding both.
+		 */
+		void create(VulkanDevice *device);
+
+		/*
+		 *
+		 */
+		void shutDown();
+
+        /*
+         * Returns the array index of texture. Textures are added to the array on first use.
+         */
+        uint32_t addTexture(SampledTexture *texture);
+
+        /*
+         * Appends data to the material buffer and returns its index.
+         */
+        uint32_t addMaterial(const MaterialData &data);
+
+        /*
+         * Points the field of data named like the shader sampler map_name at texture_index. Returns false for unknown names.
+         */
+        static bool setTextureIndex(MaterialData &data, const std::string &map_name, uint32_t texture_index);
+
+        /*
+         * Binds the table as set 1 of pipeline_layout.
+         */
+        void bind(VulkanCommandEncoder &encoder, VkPipelineLayout pipeline_layout) const;
+
+	private:
+        VulkanDevice *_device                       = nullptr;
+        VkDescriptorPool _descriptor_pool           = VK_NULL_HANDLE;
+        VkDescriptorSet _descriptor_set             = VK_NULL_HANDLE;
+        VulkanBuffer *_material_buffer              = nullptr;
+
+        uint32_t _texture_capacity                  = 0;
+        uint32_t _material_capacity                 = 0;
+        uint32_t _material_count                    = 0;
+        std::unordered_map<SampledTexture *, uint32_t> _texture_indices;
+	};
+}
+
+#endif // VIRTUALVISTA_MATERIALTABLE_H
@@ -6,7 +6,8 @@
 #include <string>
 
 #include "VulkanDevice.h"
-#include "VulkanBuffer.h"
+#include "GeometryBuffer.h"
+#include "BoundingVolume.h"
 
 namespace vv
 {
@@ -19,10 +20,22 @@ namespace vv
 		~Mesh();
 
 		/*
-		 * Stores all geometry information for a submesh within a model hierarchy.
+		 * Stores all geometry information for a submesh within a model hierarchy. The geometry itself is packed into
+         * the shared geometry_buffer, the mesh only keeps the range it occupies.
          * Called from Model wrapper class. Should not be called outside of this context.
+         *
+         * note: the host copy of the geometry stays around until releaseHostCopy() is called. ModelManager releases
+         *       it right after upload unless the model was loaded with keep_host_geometry.
 		 */
-		void create(VulkanDevice *device, std::string name, std::vector<Vertex> vertices, std::vector<uint32_t> indices, int material_id);
+		void create(GeometryBuffer *geometry_buffer, std::string name, std::vector<Vertex> vertices, std::vector<uint32_t> indices, int material_id,
+                    const AABB &bounding_box, const BoundingSphere &bounding_sphere);
+
+        /*
+         * Same as above, but uploads straight from the given arrays and never keeps a host copy. They only have to
+         * stay valid until this returns.
+         */
+        void create(GeometryBuffer *geometry_buffer, std::string name, const Vertex *vertices, uint32_t vertex_count, const uint32_t *indices,
+                    uint32_t index_count, int material_id, const AABB &bounding_box, const BoundingSphere &bounding_sphere);
 
 		/*
 		 * 
@@ -30,24 +43,58 @@ namespace vv
 		void shutDown();
 
         /*
-         * Binds all geometry data in preparation for rendering.
+         * Binds the shared geometry page this mesh lives in. Only needed when the previous draw used a different page.
+         */
+        void bindBuffers(VulkanCommandEncoder &encoder);
+
+        /*
+         * Draws this mesh's range out of the currently bound geometry page.
+         */
+        void render(VulkanCommandEncoder &encoder);
+
+        /*
+         * Returns where in the shared geometry buffers this mesh is stored.
+         */
+        const GeometryRange& getGeometryRange() const;
+
+        /*
+         * Object space bounds of the geometry. Models transform them into world space for culling.
+         */
+        const AABB& getBoundingBox() const;
+        const BoundingSphere& getBoundingSphere() const;
+
+        /*
+         * Returns whether the vertex and index data is still available on the host.
          */
-        void bindBuffers(VkCommandBuffer command_buffer);
+        bool hasHostCopy() const;
 
+        /*
+         * Host copies of the geometry. Only valid while hasHostCopy() is true.
+         */
+        const std::vector<Vertex>& getVertices() const;
+        const std::vector<uint32_t>& getIndices() const;
+
+        /*
+         * Drops the host copy of the geometry. Returns the number of bytes released.
+         */
+        uint64_t releaseHostCopy();
 
         /*
-         * Per mesh rendering using private vertex + index vulkan buffers.
+         * Returns the number of bytes the host copy of the geometry occupies.
          */
-        void render(VkCommandBuffer command_buffer);
+        uint64_t getHostCopySize() const;
 
 	private:
         std::string _name;
 
-		VulkanBuffer _vertex_buffer;
-		VulkanBuffer _index_buffer;
+        GeometryBuffer *_geometry_buffer = nullptr;
+        GeometryRange _range;
+        AABB _bounding_box;
+        BoundingSphere _bounding_sphere;
 
 		std::vector<Vertex> _vertices;
 		std::vector<uint32_t> _indices;
+        bool _has_host_copy = false;
 	};
 }
 
@@ -0,0 +1,91 @@
+#ifndef VIRTUALVISTA_MESHCACHE_H
+#define VIRTUALVISTA_MESHCACHE_H
+
+#include <string>
+#include <vector>
+
+#include "Utils.h"
+#include "BoundingVolume.h"
+#include "MappedFile.h"
+#include "ObjImporter.h"
+
+namespace vv
+{
+    // A submesh of a cached model. Its geometry is a range of the shared vertex and index arrays of the cache.
+    struct MeshCacheSubmesh
+    {
+        std::string name;
+        int material_id         = 0;
+        uint32_t first_vertex   = 0;
+        uint32_t vertex_count   = 0;
+        uint32_t first_index    = 0;
+        uint32_t index_count    = 0;
+        AABB bounding_box;
+        BoundingSphere bounding_sphere;
+    };
+
+	/*
+	 * Binary image of an imported model: the final vertex and index arrays, submesh ranges, bounds and the materials
+	 * they reference. Written once a model was imported from source and memory mapped on later loads, so geometry goes
+	 * from the file straight into staging memory.
+	 *
+	 * note: a cache only matches the exact files it was written from. Every source file is stored with a hash of its
+	 *       contents, which is checked on open along with the format, importer version and vertex layout.
+	 */
+	class MeshCache
+	{
+	public:
+        std::vector<MeshCacheSubmesh> submeshes;
+        std::vector<ObjMaterial> materials;
+        std::vector<std::string> sources;       // relative to the cache's directory, the model file first
+
+        // only filled while building a cache. A mapped cache leaves them empty, see getVertices().
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+
+		MeshCache();
+		~MeshCache();
+
+        /*
+         * Maps path + name and validates it against the current contents of its sources. Returns false if the cache is
+         * missing, corrupt or stale, which leaves the members empty.
+         */
+        bool create(const std::string &path, const std::string &name, uint32_t importer_version);
+
+		/*
+		 *
+		 */
+		void shutDown();
+
+        /*
+         * Writes the members to path + name, replacing any older cache. Returns false if it can't be written.
+         */
+        bool write(const std::string &path, const std::string &name, uint32_t importer_version) const;
+
+        /*
+         * Imports path + name from source and fills the members with its final geometry, submeshes and materials.
+         * thread_pool may be null to parse on the calling thread. Returns false and fills error if the files can't be read.
+         */
+        bool importOBJ(const std::string &path, const std::string &name, ThreadPool *thread_pool, ImportStatistics &statistics,
+                       std::string &error);
+
+        /*
+         * Geometry of all submeshes. Points into the mapped file if the cache was opened, otherwise into the members.
+         */
+        const Vertex* getVertices() const;
+        const uint32_t* getIndices() const;
+
+	private:
+        MappedFile _file;
+        bool _mapped                = false;
+        const Vertex *_vertices     = nullptr;
+        const uint32_t *_indices    = nullptr;
+
+        /*
+         * Reads everything behind the header. Returns false if any of it lies outside the file.
+         */
+        bool parse(const std::string &path, uint32_t importer_version);
+	};
+}
+
+#endif // VIRTUALVISTA_MESHCACHE_H
@@ -3,6 +3,7 @@
 #define VIRTUALVISTA_MODEL_H
 
 #include <string>
+#include <vector>
 
 #include "VulkanDevice.h"
 #include "Entity.h"
@@ -42,7 +43,7 @@ namespace vv
 		void shutDown();
 
         /*
-         * Used for update of model + normal matrix at render time.
+         * Used for update of model + normal matrix at render time. Scene streams the result into its uniform ring buffer.
          */
         void updateModelUBO();
 		
@@ -53,7 +54,6 @@ namespace vv
         std::string _material_id_set;
 
         ModelUBO _model_ubo;
-		VulkanBuffer *_model_uniform_buffer = nullptr;
 
 	};
 }
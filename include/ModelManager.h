@@ -12,10 +12,16 @@
 #include "Shader.h"
 #include "Model.h"
 #include "Mesh.h"
+#include "GeometryBuffer.h"
 #include "Material.h"
+#include "MaterialTable.h"
+#include "ThreadPool.h"
 
 namespace vv
 {
+    class GltfImporter;
+    struct GltfMaterial;
+
 	class ModelManager
 	{
         friend class Scene;
@@ -28,8 +34,11 @@ namespace vv
 
 		/*
 		 * High level class that handles all asset loading, initialization, and management.
+		 *
+		 * note: material_table receives the materials of bindless templates. May be null if none are used.
 		 */
-		void create(VulkanDevice *device, TextureManager *texture_manager, VkDescriptorPool descriptor_pool);
+		void create(VulkanDevice *device, TextureManager *texture_manager, VkDescriptorPool descriptor_pool,
+                    MaterialTable *material_table = nullptr);
 
 		/*
 		 *
@@ -39,18 +48,37 @@ namespace vv
         /*
          * Creates a model using the appropriate model loader based on file extension.
          * The provided MaterialTemplate will be used to load the required descriptors with data found in the path.
+         *
+         * note: geometry is only kept in host memory when keep_host_geometry is set. It has to be requested by the
+         *       first load of a file since the data is gone once it has been released.
          */
-        bool loadModel(std::string path, std::string name, MaterialTemplate *material_template, Model *model);
+        bool loadModel(std::string path, std::string name, MaterialTemplate *material_template, Model *model,
+                       bool keep_host_geometry = false);
 
         /*
          * Returns a pointer to the sphere primitive geometry data.
          */
         Mesh* getSphereMesh() const;
 
+        /*
+         * Returns how much geometry is still held in host memory and how much was released after upload.
+         */
+        HostMemoryStatistics getHostMemoryStatistics() const;
+
+        /*
+         * Returns how long loading took so far and how well vertices were deduplicated.
+         */
+        const ImportStatistics& getImportStatistics() const;
+
     private:
 		VulkanDevice *_device;
         VkDescriptorPool _descriptor_pool;
         TextureManager *_texture_manager;
+        MaterialTable *_material_table = nullptr;
+        GeometryBuffer *_geometry_buffer = nullptr; // shared by all loaded meshes
+        uint64_t _reclaimed_host_bytes = 0;
+        ImportStatistics _import_statistics;
+        ThreadPool *_import_thread_pool = nullptr; // parses obj files in parallel. null with a single import thread.
 
         // todo: can have global array of geometry and material data that constantly updates.
         std::unordered_map<std::string, std::vector<Mesh *> > _loaded_meshes;
@@ -58,13 +86,29 @@ namespace vv
 
         /*
          * Loads obj + mtl files for a single model. Returns a model abstraction with references to raw loaded geometry + material data.
+         * The geometry comes from the model's .vvmesh cache if it is up to date, otherwise the files are imported and the cache rewritten.
+         *
+         * note: every material change inside a group starts a new submesh, so each one is drawn with its own material.
+         *       Without load_geometry only the materials are created, for a file whose meshes are already loaded.
+         */
+        bool loadOBJ(std::string path, std::string name, MaterialTemplate *material_template, Model *model, bool load_geometry,
+                     bool keep_host_geometry);
+
+        /*
+         * Loads a .gltf or .glb file for a single model. Every triangle primitive of the default scene becomes a submesh.
+         * Vertex and index data that already has the engine's layout is uploaded straight out of the mapped file.
+         *
+         * note: pbrMetallicRoughness materials fill the maps of the PBR templates. Factors are only used in place of
+         *       missing textures, not multiplied into them. Without load_geometry only the materials are created.
          */
-        bool loadOBJ(std::string path, std::string name, MaterialTemplate *material_template, Model *model);
+        bool loadGLTF(std::string path, std::string name, MaterialTemplate *material_template, Model *model, bool load_geometry,
+                      bool keep_host_geometry);
 
         /*
-         * todo: add support for glTF
+         * Returns the texture of material the descriptor named descriptor_name samples, or a constant stand in.
          */
-        bool loadGLTF();
+        SampledTexture* loadGLTFTexture(const std::string &path, const std::string &name, const GltfImporter &importer,
+                                        const GltfMaterial &material, const std::string &descriptor_name);
 	};
 }
 
@@ -0,0 +1,157 @@
+#ifndef VIRTUALVISTA_OBJIMPORTER_H
+#define VIRTUALVISTA_OBJIMPORTER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "ThreadPool.h"
+
+namespace vv
+{
+    // Zero based references into the attribute arrays of the importer. -1 if a face corner doesn't have the attribute.
+    struct ObjIndex
+    {
+        int32_t vertex_index;
+        int32_t normal_index;
+        int32_t texcoord_index;
+    };
+
+    // Triangulated faces sharing a name and a material. A new shape starts at every o, g and material change.
+    struct ObjShape
+    {
+        std::string name;
+        int material_id = -1;               // into ObjImporter::materials, -1 if none was set
+        std::vector<ObjIndex> indices;      // three per triangle
+    };
+
+    struct ObjMaterial
+    {
+        std::string name;
+        float ambient[3]    = { 0.0f, 0.0f, 0.0f };
+        float diffuse[3]    = { 0.0f, 0.0f, 0.0f };
+        float specular[3]   = { 0.0f, 0.0f, 0.0f };
+        float shininess     = 1.0f;
+
+        std::string ambient_texname;        // map_Ka
+        std::string diffuse_texname;        // map_Kd
+        std::string specular_texname;       // map_Ks
+        std::string normal_texname;         // norm
+        std::string bump_texname;           // map_bump, bump
+        std::string roughness_texname;      // map_Pr
+        std::string metallic_texname;       // map_Pm
+        std::string emissive_texname;       // map_Ke
+    };
+
+	/*
+	 * Maps face corners to the vertex they became. Open addressing with linear probing over flat arrays that are sized
+	 * up front, so inserting never rehashes.
+	 */
+	class ObjVertexMap
+	{
+	public:
+		ObjVertexMap();
+		~ObjVertexMap();
+
+        /*
+         * Empties the map and makes room for max_count distinct corners at a load factor of at most one half.
+         */
+        void reset(std::size_t max_count);
+
+        /*
+         * Returns the vertex index belongs to. Corners seen for the first time get next_vertex and set inserted.
+         */
+        uint32_t findOrInsert(const ObjIndex &index, uint32_t next_vertex, bool &inserted);
+
+	private:
+        std::vector<ObjIndex> _keys;        // a vertex_index of -1 marks an empty slot
+        std::vector<uint32_t> _values;
+        std::size_t _mask = 0;
+	};
+
+	/*
+	 * Wavefront OBJ + MTL reader. The file is memory mapped and split into line aligned chunks that are parsed on a
+	 * thread pool, then stitched together in file order. Numbers are parsed by hand, so the result does not depend on
+	 * the current locale.
+	 *
+	 * note: polygons are fan triangulated. Only the first name of o, g and mtllib lines is used.
+	 */
+	class ObjImporter
+	{
+	public:
+        // bump whenever the same files would import into different geometry, including ModelManager's conversion of it.
+        // caches written by older versions are rebuilt.
+        static const uint32_t version = 1;
+
+        std::vector<float> positions;       // xyz
+        std::vector<float> normals;         // xyz
+        std::vector<float> texcoords;       // uv
+        std::vector<ObjShape> shapes;
+        std::vector<ObjMaterial> materials;
+        std::vector<std::string> material_libraries;    // relative to path, in the order they were read
+
+		ObjImporter();
+		~ObjImporter();
+
+        /*
+         * Reads path + name and the material libraries it references, which are looked up relative to path.
+         * thread_pool may be null to parse on the calling thread. Returns false and fills error if anything fails.
+         */
+        bool load(const std::string &path, const std::string &name, ThreadPool *thread_pool, std::string &error);
+
+	private:
+        enum class DirectiveType
+        {
+            Object,
+            Group,
+            UseMaterial,
+            MaterialLibrary
+        };
+
+        // a line that changes state for the faces after it. applied in file order once all chunks are parsed.
+        struct Directive
+        {
+            DirectiveType type;
+            std::string name;
+            std::size_t index_offset;       // number of indices of the chunk in front of it
+        };
+
+        struct Chunk
+        {
+            const char *begin               = nullptr;
+            const char *end                 = nullptr;
+
+            std::vector<float> positions;
+            std::vector<float> normals;
+            std::vector<float> texcoords;
+            std::vector<ObjIndex> indices;
+            std::vector<Directive> directives;
+
+            // negative indices are relative to what was defined before them, which may lie in an earlier chunk. they
+            // are stored relative to the start of the chunk and moved by its base once those are known.
+            std::vector<std::pair<std::size_t, int> > relative_indices; // index position, component (0 vertex, 1 normal, 2 texcoord)
+
+            std::string error;
+        };
+
+        std::unordered_map<std::string, int> _material_map;
+
+        /*
+         * Parses the lines in [chunk.begin, chunk.end). Safe to call for several chunks at once.
+         */
+        static void parseChunk(Chunk &chunk);
+
+        /*
+         * Concatenates the attributes of all chunks, resolves relative indices and cuts the faces into shapes.
+         */
+        bool mergeChunks(std::vector<Chunk> &chunks, const std::string &path, std::string &error);
+
+        /*
+         * Appends the materials of an MTL file to materials.
+         */
+        bool loadMaterialLibrary(const std::string &file_path, std::string &error);
+	};
+}
+
+#endif // VIRTUALVISTA_OBJIMPORTER_H
@@ -0,0 +1,89 @@
+#ifndef VIRTUALVISTA_RENDERQUEUE_H
+#define VIRTUALVISTA_RENDERQUEUE_H
+
+#include <vector>
+
+#include "Model.h"
+#include "Mesh.h"
+#include "Material.h"
+
+namespace vv
+{
+    // Coarsest sort criterion. Passes are drawn in this order.
+    enum class DrawPass : uint32_t
+    {
+        Opaque      = 0,
+        Transparent = 1
+    };
+
+    // Everything needed to issue a single draw. Compact so the whole list stays cache friendly while sorting.
+    struct DrawPacket
+    {
+        uint64_t sort_key                       = 0;
+        MaterialTemplate *material_template     = nullptr;
+        Material *material                      = nullptr;
+        const Mesh *mesh                        = nullptr;
+        const Model *model                      = nullptr;
+        bool is_visible                         = true; // culled packets still take part in bucket layout
+    };
+
+	class RenderQueue
+	{
+	public:
+		RenderQueue();
+		~RenderQueue();
+
+        /*
+         * Builds a sort key. From most to least significant bits: pass (4), pipeline (8), material (14),
+         * geometry page (6), mesh (16) and depth (16). Ids have to fit their field, since draws sharing a key
+         * interleave by depth and scene buckets have to stay the same between frames.
+         *
+         * note: depth is expected in [0, 1]. Opaque draws sort front to back, transparent ones back to front.
+         */
+        static uint64_t createSortKey(DrawPass pass, uint32_t pipeline_id, uint32_t material_id, uint32_t geometry_page,
+                                      uint32_t mesh_id, float depth);
+
+        /*
+         * Returns sort_key with its depth bits replaced. Keys of static geometry only need this once per frame.
+         */
+        static uint64_t setSortKeyDepth(uint64_t sort_key, float depth);
+
+        /*
+         * Removes all packets. Keeps the storage around for the next frame.
+         */
+        void clear();
+
+        /*
+         * Appends a packet. Its sort key has to be set already.
+         */
+        void push(const DrawPacket &packet);
+
+        /*
+         * Sorts all packets by key with an 8 bit lsd radix sort. Equal keys keep their push order.
+         */
+        void sort();
+
+        /*
+         * Returns the number of packets pushed since the last clear().
+         */
+        std::size_t size() const;
+
+        /*
+         * Returns the i-th packet in sorted order. Only valid after sort().
+         */
+        const DrawPacket& operator[](std::size_t i) const;
+
+	private:
+        struct SortItem
+        {
+            uint64_t key;
+            uint32_t packet_index;
+        };
+
+        std::vector<DrawPacket> _packets;
+        std::vector<SortItem> _items;
+        std::vector<SortItem> _scratch;
+	};
+}
+
+#endif // VIRTUALVISTA_RENDERQUEUE_H
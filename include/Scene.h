@@ -5,8 +5,11 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <utility>
 
 #include "VulkanDevice.h"
+#include "VulkanRingBuffer.h"
+#include "VulkanCommandEncoder.h"
 #include "SkyBox.h"
 #include "VulkanRenderPass.h"
 #include "VulkanSampler.h"
@@ -16,6 +19,11 @@
 #include "Light.h"
 #include "Model.h"
 #include "Camera.h"
+#include "RenderQueue.h"
+#include "Frustum.h"
+#include "BoundingVolumeHierarchy.h"
+#include "CullingPass.h"
+#include "MaterialTable.h"
 
 namespace vv
 {
@@ -32,7 +40,7 @@ namespace vv
 		/*
 		 * Loads all resources and templates needed for model loading and descriptor set updating.
 		 */
-		void create(VulkanDevice *device, VulkanRenderPass *render_pass);
+		void create(VulkanDevice *device, VulkanRenderPass *render_pass, VulkanSwapChain *swap_chain);
 
 		/*
 		 *
@@ -47,9 +55,10 @@ namespace vv
         /*
          * Requests that a model be loaded using the ModelManger and stored for rendering/updates.
          *
-         * note: material_template will be applied to all submeshes for the model found.
+         * note: material_template will be applied to all submeshes for the model found. Geometry is released from host
+         *       memory after upload unless keep_host_geometry is set, e.g. for picking or cpu side collision.
          */
-        Model* addModel(std::string path, std::string name, std::string material_template);
+        Model* addModel(std::string path, std::string name, std::string material_template, bool keep_host_geometry = false);
 
         /*
          * Requests that a perspective camera be created.
@@ -82,21 +91,74 @@ namespace vv
          */
         void setActiveSkyBox(SkyBox *skybox);
 
+        /*
+         * Returns the host memory still held by loaded geometry and textures and how much was released after upload.
+         */
+        HostMemoryStatistics getHostMemoryStatistics() const;
+
+        /*
+         * Returns the time spent importing models and the vertex deduplication ratio they achieved.
+         */
+        const ImportStatistics& getImportStatistics() const;
+
+        /*
+         * Returns how many submesh instances passed and failed frustum culling in the last written frame.
+         *
+         * note: with gpu culling every instance is handed to the gpu and counted as visible here.
+         */
+        const CullingStatistics& getCullingStatistics() const;
+
+        /*
+         * Renders depth with a position only pipeline before any shading, so the main pass only shades fragments that
+         * end up visible. Defaults to Settings::isDepthPrePassEnabled().
+         *
+         * note: pre-recorded command buffers keep the mode they were recorded with.
+         */
+        void setDepthPrePassEnabled(bool enabled);
+        bool isDepthPrePassEnabled() const;
+
+        /*
+         * Appends every model with a submesh touching sphere, e.g. the models within reach of a light.
+         *
+         * note: works on the bounds of the last written frame. Models added since are not found yet.
+         */
+        void queryModels(const BoundingSphere &sphere, std::vector<Model *> &models) const;
+
+        /*
+         * Returns the model whose submesh bounds are hit first by the ray, or nullptr. Tests bounding boxes only.
+         *
+         * note: works on the bounds of the last written frame. Models added since are not found yet.
+         */
+        Model* pickModel(const glm::vec3 &origin, const glm::vec3 &direction, float max_distance) const;
+
         /*
          * Updates the global scene descriptor sets with newly updates data.
+         *
+         * note: only the uniform copies owned by frame_index are written. The caller must guarantee the gpu is done with them.
          */
-        void updateUniformData(VkExtent2D extent, float time);
+        void updateUniformData(VkExtent2D extent, float time, uint32_t frame_index);
 
         /*
-         * Recursively renders each model.
+         * Recursively renders each model using the uniform data written for frame_index.
          *
          * note: This will be automatically called within VulkanRenderer. There is no need in calling manually.
          */
-        void render(VkCommandBuffer command_buffer);
+        void render(VulkanCommandEncoder &encoder, uint32_t frame_index);
+
+        /*
+         * Records the gpu culling pass for frame_index, if enabled. Must be recorded before the render pass.
+         */
+        void recordCulling(VkCommandBuffer command_buffer, uint32_t frame_index);
+
+        /*
+         * Records the depth pyramid build for next frame's occlusion culling, if enabled. Must be recorded after the render pass.
+         */
+        void recordDepthPyramid(VkCommandBuffer command_buffer);
 
 	private:
         VulkanDevice *_device                       = nullptr;
         VulkanRenderPass *_render_pass              = nullptr;
+        VulkanSwapChain *_swap_chain                = nullptr;
         ModelManager *_model_manager                = nullptr;
         TextureManager *_texture_manager            = nullptr;
         bool _initialized                           = false;
@@ -104,6 +166,15 @@ namespace vv
 		VulkanSampler *_sampler                     = nullptr;
 		VkDescriptorPool _descriptor_pool           = VK_NULL_HANDLE;
 
+        // textures and parameters of every bindless material. null when materials bind descriptor sets of their own.
+        MaterialTable *_material_table              = nullptr;
+
+        // depth only pipeline drawing every bucket ahead of the main pass. uses the scene set only.
+        bool _depth_pre_pass_enabled                = false;
+        Shader *_depth_shader                       = nullptr;
+        VkPipelineLayout _depth_pipeline_layout     = VK_NULL_HANDLE;
+        VulkanPipeline *_depth_pipeline             = nullptr;
+
         // General scene uniform
         struct SceneUBO
         {
@@ -112,10 +183,65 @@ namespace vv
             glm::vec4 camera_position;
         };
 
+        // all per-frame data below is duplicated once per frame in flight and indexed by the frame index.
+        uint32_t _frame_count                       = 1;
+
+        // streamed per-frame data. scene and light uniforms, per draw instance data and the indirect draw commands.
+        VulkanRingBuffer *_uniform_ring_buffer      = nullptr;
+
         VkDescriptorSetLayout _scene_descriptor_set_layout;
-        std::vector<VkDescriptorSet> _scene_descriptor_sets;
+        VkDescriptorSet _scene_descriptor_set        = VK_NULL_HANDLE; // shared by all models and frames
         SceneUBO _scene_ubo;
-		VulkanBuffer *_scene_uniform_buffer         = nullptr;
+        std::vector<uint32_t> _scene_ubo_offsets;  // dynamic offsets into _uniform_ring_buffer
+        std::vector<uint32_t> _instance_data_offsets;
+
+        // Draws sharing pipeline, material and geometry page. Submitted with a single indirect draw. Switching between
+        // buckets of a bindless template only takes a push of the material index.
+        struct DrawBucket
+        {
+            MaterialTemplate *material_template     = nullptr;
+            Material *material                      = nullptr;
+            uint32_t geometry_page                  = 0;
+            uint32_t first_draw                     = 0;
+            uint32_t draw_count                     = 0;
+        };
+
+        // one packet per submesh of every model, rebuilt whenever models are added. sorted into _render_queue every frame.
+        bool _draw_packets_dirty                    = true;
+        std::vector<DrawPacket> _scene_packets;
+        RenderQueue _render_queue;
+
+        // world space bounds of every packet. only refit for models that moved. leaves store the packet index.
+        BoundingVolumeHierarchy _bvh;
+        std::vector<uint32_t> _packet_proxies;
+        std::vector<BoundingSphere> _packet_spheres;
+        std::vector<std::pair<uint32_t, uint32_t>> _model_packets; // first packet and packet count, parallel to _models
+
+        // packets the hierarchy couldn't decide on get an exact test of their own box
+        Frustum _frustum;
+        CullBounds _cull_bounds;
+        std::vector<uint32_t> _inside_packets;
+        std::vector<uint32_t> _intersecting_packets;
+        std::vector<uint8_t> _intersecting_visibility;
+        std::vector<uint8_t> _packet_visibility;
+        CullingStatistics _culling_statistics;
+
+        // built from the sorted queue. every copy of a mesh is one instance of a single command. firstInstance
+        // points at the first of its instances, gl_InstanceIndex at the model's entry in the instance data.
+        std::vector<DrawBucket> _draw_buckets;
+        std::vector<VkDrawIndexedIndirectCommand> _draw_commands;
+        std::vector<const Model *> _instance_models;
+        std::vector<VkDeviceSize> _draw_command_offsets;
+        std::vector<VkDeviceSize> _draw_count_offsets;
+
+        // gpu culling. every instance goes into the frame with the command and world space box it belongs to. the cull
+        // shader counts survivors into instanceCount and compacts them in front of the unculled copies.
+        CullingPass *_culling_pass                  = nullptr;
+        std::vector<uint32_t> _instance_commands;
+        std::vector<AABB> _instance_bounds;
+        std::vector<uint32_t> _culling_uniform_offsets;
+        glm::mat4 _previous_view_projection;        // camera of the frame the depth pyramid was built from
+        bool _has_previous_frame                    = false;
 
         // Light uniforms
         struct LightData
@@ -130,14 +256,14 @@ namespace vv
         };
 
         LightUBO _lights_ubo;
-		VulkanBuffer *_lights_uniform_buffer         = nullptr;
+        std::vector<uint32_t> _lights_ubo_offsets;
 
         VkDescriptorSetLayout _environment_descriptor_set_layout;
         VkDescriptorSetLayout _radiance_descriptor_set_layout;
         VkDescriptorSet _environment_descriptor_set  = VK_NULL_HANDLE; // used for IBL calculations
         VkDescriptorSet _radiance_descriptor_set     = VK_NULL_HANDLE; // applied to skybox model
 
-        // todo: think of better data structure. maybe something to help with culling
+        // renderable submeshes are indexed spatially by _bvh
 		std::vector<Light *> _lights;
 		std::vector<Model *> _models;
 		std::vector<Camera *> _cameras;
@@ -148,12 +274,79 @@ namespace vv
         bool _has_active_camera;
         bool _has_active_skybox;
 
+        /*
+         * Writes instance data, scene and light uniforms and the indirect draw commands into the ring buffer region
+         * owned by frame_index.
+         *
+         * note: allocation order is fixed, so the offsets recorded for a frame never change between calls. This keeps
+         *       pre-recorded command buffers valid.
+         */
+        void writeFrameUniforms(uint32_t frame_index);
+
+        /*
+         * Creates a draw packet for every submesh of every model. Sort keys are complete except for depth.
+         */
+        void buildDrawPackets();
+
+        /*
+         * Moves the bounds of every packet whose model moved since the last frame. Inserts packets new to the hierarchy.
+         */
+        void updateBoundingVolumes();
+
+        /*
+         * Sorts this frame's packets by key and groups them into buckets sharing pipeline, material and geometry page.
+         * Models loaded from the same file with the same material share meshes and are collapsed into instanced draws.
+         */
+        void buildDrawBuckets();
+
+        /*
+         * Records the depth of the draw buckets in [first_bucket, first_bucket + bucket_count). Must precede the main
+         * pass of every bucket, since its pipelines only pass fragments matching this depth exactly.
+         */
+        void renderDepthPrePass(VulkanCommandEncoder &encoder, uint32_t frame_index, std::size_t first_bucket, std::size_t bucket_count);
+
+        /*
+         * Records the active skybox, if any.
+         */
+        void renderSkyBox(VulkanCommandEncoder &encoder, uint32_t frame_index);
+
+        /*
+         * Records the draw buckets in [first_bucket, first_bucket + bucket_count). Binds its own pipeline state so the
+         * range can be recorded into a secondary command buffer independently of the others.
+         */
+        void renderModels(VulkanCommandEncoder &encoder, uint32_t frame_index, std::size_t first_bucket, std::size_t bucket_count);
+
+        /*
+         * Returns whether buckets are submitted with indirect draws. Otherwise the commands are issued from the cpu.
+         */
+        bool usesIndirectDraws() const;
+
+        /*
+         * Returns whether instances are culled on the gpu. Requires indirect draws since only the gpu knows the instance counts.
+         */
+        bool usesGpuCulling() const;
+
+        /*
+         * Returns whether templates with a bindless shader variant read their materials from _material_table.
+         */
+        bool usesBindlessMaterials() const;
+
+        /*
+         * Issues the draws of a single bucket. Uses one indirect draw when the device supports it.
+         */
+        void drawBucket(VulkanCommandEncoder &encoder, uint32_t frame_index, std::size_t bucket_index) const;
+
         /*
          * Reads required shaders from file and creates all possible MaterialTemplates that can be used during execution.
          * These MaterialTemplates can be referenced by the name provided in the shader info file.
          */
         void createMaterialTemplates();
 
+        /*
+         * Creates the position only pipeline of the depth pre-pass.
+         */
+        void createDepthPrePassPipeline();
+
         /*
          * Creates global descriptor pool from which all descriptor sets will be allocated from.
          */
@@ -165,10 +358,10 @@ namespace vv
         void createSceneDescriptorSetLayout();
 
         /*
-         * This dynamically allocates a number of scene related descriptor sets depending on the number of
-         * models specified through the scene interface.
+         * Allocates the single scene descriptor set. All of its bindings are dynamic uniform buffers into the ring buffer,
+         * so models added later never need descriptor sets of their own.
          */
-        void allocateSceneDescriptorSets();
+        void allocateSceneDescriptorSet();
 
         /*
          * Creates everything necessary for scene global uniforms.
@@ -33,9 +33,45 @@ namespace vv
         uint32_t getMaxDescriptorSets() const;
         uint32_t getMaxUniformBuffers() const;
         uint32_t getMaxCombinedImageSamplers() const;
+        uint32_t getMaxDynamicUniformBuffers() const;
+        uint32_t getMaxDynamicStorageBuffers() const;
+        uint32_t getUniformRingBufferSize() const;
+        uint32_t getMemoryBlockSize() const;
+        uint32_t getUploadBatchSize() const;
+        uint32_t getStagingArenaSize() const;
+        uint32_t getGeometryBufferSize() const;
+        uint32_t getMaxBindlessTextures() const;
+        uint32_t getMaxBindlessMaterials() const;
+
+        uint32_t getMaxFramesInFlight() const;
+
+        bool isPerFrameRecordingEnabled() const;
+        float getRecordingBudget() const;
+        uint32_t getRecordingThreadCount() const;
+        uint32_t getImportThreadCount() const;
+        bool isFrameStatisticsReportingEnabled() const;
+        bool isIndirectDrawingEnabled() const;
+        bool isFrustumCullingEnabled() const;
+        bool isGpuCullingEnabled() const;
+        bool isOcclusionCullingEnabled() const;
+        bool isBindlessMaterialsEnabled() const;
+        bool isDepthPrePassEnabled() const;
+        bool isMeshCacheEnabled() const;
 
         void setWindowWidth(int width);
         void setWindowHeight(int height);
+        void setMaxFramesInFlight(uint32_t frame_count);
+        void setPerFrameRecordingEnabled(bool enabled);
+        void setFrameStatisticsReportingEnabled(bool enabled);
+        void setRecordingThreadCount(uint32_t thread_count);
+        void setImportThreadCount(uint32_t thread_count);
+        void setIndirectDrawingEnabled(bool enabled);
+        void setFrustumCullingEnabled(bool enabled);
+        void setGpuCullingEnabled(bool enabled);
+        void setOcclusionCullingEnabled(bool enabled);
+        void setBindlessMaterialsEnabled(bool enabled);
+        void setDepthPrePassEnabled(bool enabled);
+        void setMeshCacheEnabled(bool enabled);
 
     private:
         static Settings* instance_;
@@ -56,6 +92,30 @@ namespace vv
         uint32_t _max_descriptor_sets;
         uint32_t _max_uniform_buffers;
         uint32_t _max_combined_image_samplers;
+        uint32_t _max_dynamic_uniform_buffers;
+        uint32_t _max_dynamic_storage_buffers;
+        uint32_t _uniform_ring_buffer_size;
+        uint32_t _memory_block_size;
+        uint32_t _upload_batch_size;
+        uint32_t _staging_arena_size;
+        uint32_t _geometry_buffer_size;
+        uint32_t _max_bindless_textures;
+        uint32_t _max_bindless_materials;
+
+        uint32_t _max_frames_in_flight;
+
+        bool _per_frame_recording;
+        float _recording_budget;
+        uint32_t _recording_thread_count;
+        uint32_t _import_thread_count;
+        bool _report_frame_statistics;
+        bool _indirect_drawing;
+        bool _frustum_culling;
+        bool _gpu_culling;
+        bool _occlusion_culling;
+        bool _bindless_materials;
+        bool _depth_pre_pass;
+        bool _mesh_cache;
 
         Settings() {};
         Settings(const Settings& s) {};
@@ -15,31 +15,70 @@ namespace vv
 	public:
 		VkShaderModule vert_module = VK_NULL_HANDLE;
 		VkShaderModule frag_module = VK_NULL_HANDLE;
+		VkShaderModule comp_module = VK_NULL_HANDLE;
 
         // specifies the binding order of the model descriptor.
         std::vector<DescriptorInfo> material_descriptor_orderings;
+
+        // push constants of both stages. ranges used by several stages are merged into one with all their stage flags.
         std::vector<VkPushConstantRange> push_constant_ranges;
         bool uses_environmental_lighting;
 
+        // the fragment program reads its material from the bindless MaterialTable instead of a set of its own
+        bool uses_bindless_materials = false;
+
 		Shader();
 		~Shader();
 
         /*
          * Manages loading of binary Spir-V shader programs from file.
+         *
+         * note: with bindless_materials the name_bindless_frag.spv variant is used when one was compiled. Material
+         *       descriptors are still reflected from the regular variant, so both describe the same material inputs.
+         *       Reflection is read from the .vvshader cook() wrote when it still matches the programs.
+         */
+		void create(VulkanDevice *device, std::string name, bool bindless_materials = false);
+
+        /*
+         * Reflects the programs create() would load and writes the result to name.vvshader, or name_bindless.vvshader
+         * for the bindless variant, next to them. Needs no device. Returns false if the file can't be written.
+         */
+        bool cook(std::string name, bool bindless_materials = false);
+
+        /*
+         * Loads only the vertex program, for pipelines that write depth and nothing else. frag_module stays null.
+         */
+		void createVertexOnly(VulkanDevice *device, std::string name);
+
+        /*
+         * Loads a compute program instead. Only comp_module is valid afterwards.
+         *
+         * note: compute shaders declare their own descriptor layouts, so no reflection is done for them.
          */
-		void create(VulkanDevice *device, std::string name);
+		void createCompute(VulkanDevice *device, std::string name);
 
         /*
          *
          */
 		void shutDown();
 
+        /*
+         * Returns the stages of every push constant range overlapping [offset, offset + size). vkCmdPushConstants
+         * has to name exactly those.
+         */
+        VkShaderStageFlags getPushConstantStages(uint32_t offset, uint32_t size) const;
+
 	private:
+        static const uint32_t reflection_version = 1;   // bump when the .vvshader contents change
+
 		VulkanDevice *_device;
 
 		std::string _name;
 		std::string _vert_path;
 		std::string _frag_path;
+		std::string _comp_path;
+		std::string _material_frag_path;    // program material descriptors are reflected from
+		std::string _reflection_path;
 
 		std::vector<char> _vert_binary_data;
 		std::vector<char> _frag_binary_data;
@@ -51,6 +90,28 @@ namespace vv
             "radiance_map"
         };
 
+        /*
+         * Resolves the program paths of name and loads the vertex and fragment binaries.
+         */
+        void loadPrograms(std::string name, bool bindless_materials);
+
+        /*
+         * Fills material descriptors, push constant ranges and lighting requirements from the loaded programs.
+         */
+        void reflect();
+
+        /*
+         * Reads what reflect() would produce from _reflection_path. Returns false if it's missing or was written from
+         * different programs.
+         */
+        bool loadReflection();
+        bool writeReflection() const;
+
+        /*
+         * Returns the programs the reflection depends on.
+         */
+        std::vector<std::string> getReflectionSources() const;
+
         /*
          * Parses binary data and returns it as an array of chars.
          */
@@ -65,6 +126,11 @@ namespace vv
          * Uses SPIRV-Cross to perform runtime reflection of the spriv shader to analyze descriptor binding info.
          */
         void reflectDescriptorTypes(std::vector<uint32_t> spirv_binar, VkShaderStageFlagBits shader_stage);
+
+        /*
+         * Adds the push constant bytes shader_stage actually reads to push_constant_ranges.
+         */
+        void reflectPushConstants(std::vector<uint32_t> spirv_binary, VkShaderStageFlagBits shader_stage);
 	};
 }
 
@@ -40,23 +40,24 @@ namespace vv
          * The skybox sphere mesh only uses the radiance_map for rendering. This updates a special descriptor
          * set intended to be used exclusively by the "active_skybox".
          */
-        void bindSkyBoxDescriptorSets(VkCommandBuffer command_buffer, VkPipelineLayout pipeline_layout) const;
+        void bindSkyBoxDescriptorSets(VulkanCommandEncoder &encoder, VkPipelineLayout pipeline_layout) const;
 
         /*
          * Updates diffuse + specular irradiance maps as well as a preloaded BRDF LUT, which are used to 
          * calculate PBR image based lighting.
          */
-        void bindIBLDescriptorSets(VkCommandBuffer command_buffer, VkPipelineLayout pipeline_layout) const;
+        void bindIBLDescriptorSets(VulkanCommandEncoder &encoder, VkPipelineLayout pipeline_layout) const;
 
         /*
-         * Submits the maximum number of mip levels used for specular irradiance calculation.
+         * Submits the maximum number of mip levels used for specular irradiance calculation. stage_flags are the stages
+         * of the push constant range holding DrawConstants::total_mip_levels.
          */
-        void submitMipLevelPushConstants(VkCommandBuffer command_buffer, VkPipelineLayout pipeline_layout) const;
+        void submitMipLevelPushConstants(VulkanCommandEncoder &encoder, VkPipelineLayout pipeline_layout, VkShaderStageFlags stage_flags) const;
 
         /*
          * Calls the skybox sphere mesh's render function.
          */
-        void render(VkCommandBuffer command_buffer);
+        void render(VulkanCommandEncoder &encoder);
 	
 	private:
 		VulkanDevice *_device;
@@ -0,0 +1,70 @@
+#ifndef VIRTUALVISTA_TEXTURECACHE_H
+#define VIRTUALVISTA_TEXTURECACHE_H
+
+#include <string>
+#include <vector>
+
+#include "Utils.h"
+#include "MappedFile.h"
+
+namespace vv
+{
+	/*
+	 * Cooked 2D texture: a complete mip chain in its final, usually block compressed, format. Written by vv_cook next to
+	 * the source image as <image>.vvtex and memory mapped by TextureManager, so nothing is decoded at runtime.
+	 *
+	 * note: levels are stored tightly packed from largest to smallest, as VulkanImage::updateAndTransfer expects them.
+	 *       A cooked texture is only used while the hash of its source image still matches.
+	 */
+	class TextureCache
+	{
+	public:
+        VkFormat format         = VK_FORMAT_UNDEFINED;
+        uint32_t width          = 0;
+        uint32_t height         = 0;
+        uint32_t mip_levels     = 0;
+
+        // only filled while cooking. A mapped cache leaves it empty, see getData().
+        std::vector<char> data;
+
+		TextureCache();
+		~TextureCache();
+
+        /*
+         * Maps path + source_name + ".vvtex" and validates it against the source image. Returns false if the cache is
+         * missing, corrupt or stale.
+         */
+        bool create(const std::string &path, const std::string &source_name);
+
+		/*
+		 *
+		 */
+		void shutDown();
+
+        /*
+         * Writes the members to path + source_name + ".vvtex", replacing any older cache.
+         */
+        bool write(const std::string &path, const std::string &source_name) const;
+
+        /*
+         * Texel data of all levels. Points into the mapped file if the cache was opened, otherwise into data.
+         */
+        const char* getData() const;
+
+        /*
+         * Returns the bytes taken by the first level_count levels.
+         */
+        uint64_t getSize(uint32_t level_count) const;
+
+        /*
+         * Returns the bytes of a single level. Only R8G8B8A8_UNORM, BC1_RGB_UNORM and BC3_UNORM are supported.
+         */
+        static uint64_t getLevelSize(VkFormat format, uint32_t width, uint32_t height, uint32_t level);
+
+	private:
+        MappedFile _file;
+        const char *_data = nullptr;
+	};
+}
+
+#endif // VIRTUALVISTA_TEXTURECACHE_H
@@ -10,6 +10,7 @@
 #include "VulkanSampler.h"
 #include "VulkanDevice.h"
 #include "VulkanImageView.h"
+#include "TextureCache.h"
 
 namespace vv
 {
@@ -40,11 +41,28 @@ namespace vv
         /*
          * Loads a texture from file.
          *
-         * note: only png, jpeg, dds, and ktx file formats are supported for now.
+         * note: only png, jpeg, dds, and ktx file formats are supported for now. png and jpeg images cooked by vv_cook
+         *       are read from their .vvtex instead, as long as it is up to date and format is R8G8B8A8_UNORM.
          */
         SampledTexture* load2DImage(std::string path, std::string name, VkFormat format = VK_FORMAT_R8G8B8A8_UNORM,
                                     bool create_mip_levels = true);
 
+        /*
+         * Decodes a png or jpeg image held in memory, i.e. one embedded in a model file. key identifies it for reuse.
+         */
+        SampledTexture* loadEncodedImage(const std::string &key, const char *data, std::size_t size);
+
+        /*
+         * Returns a 1x1 texture of the given color. Stands in for maps a material only gives a constant for.
+         */
+        SampledTexture* loadSolidImage(const glm::vec4 &color);
+
+        /*
+         * Returns a view of texture with its channels reordered by components, for shaders that expect data in a
+         * different channel than the image stores it in. The image and sampler are shared with texture.
+         */
+        SampledTexture* createSwizzledView(SampledTexture *texture, const std::string &key, VkComponentMapping components);
+
         /*
          * Loads a provided cube map from file.
          *
@@ -53,6 +71,13 @@ namespace vv
         SampledTexture* loadCubeMap(std::string path, std::string name, VkFormat format = VK_FORMAT_R8G8B8A8_UNORM,
                                     bool create_mip_levels = true);
 
+        /*
+         * Returns how many bytes of decoded texel data were released after upload.
+         *
+         * note: texel data is never kept on the host. Nothing reads it back once the image has been uploaded.
+         */
+        HostMemoryStatistics getHostMemoryStatistics() const;
+
 	private:
 		VulkanDevice *_device;
         std::string _texture_directory;
@@ -60,9 +85,11 @@ namespace vv
         // Stores constructed textures/cube maps this class creates and is in current use.
         std::unordered_map<std::string, SampledTexture *> _loaded_textures;
 
-        // Stores raw texture data on host memory.
-        std::unordered_map<std::string, unsigned char *> _ldr_texture_array_data_cache;
-        std::unordered_map<std::string, float *> _hdr_texture_array_data_cache;
+        // views into textures of _loaded_textures. only their image views belong to them.
+        std::unordered_map<std::string, SampledTexture *> _swizzled_views;
+
+        // decoded texel data released once it has been copied into staging memory
+        uint64_t _reclaimed_host_bytes = 0;
 
         std::unordered_map<gli::format, VkFormat> _gliToVulkanFormat =
 		{
@@ -73,6 +100,11 @@ namespace vv
 			{ gli::FORMAT_RGB8_UNORM_PACK8, VK_FORMAT_R8G8B8_UNORM }
 		};
 
+        /*
+         * Uploads the cooked version of path + name. Returns null if there is none that is current and usable.
+         */
+        SampledTexture* loadCookedImage(const std::string &path, const std::string &name, bool create_mip_levels);
+
         /*
          * Generalized function to abstract loading of different texture types.
          */
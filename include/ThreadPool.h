@@ -0,0 +1,61 @@
+#ifndef VIRTUALVISTA_THREADPOOL_H
+#define VIRTUALVISTA_THREADPOOL_H
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace vv
+{
+	class ThreadPool
+	{
+	public:
+		ThreadPool();
+		~ThreadPool();
+
+        /*
+         * Spawns a fixed number of worker threads that stay alive until shutDown.
+         */
+		void create(uint32_t thread_count);
+
+        /*
+         * Finishes all queued work and joins every worker thread.
+         */
+		void shutDown();
+
+        /*
+         * Queues a task to be executed by the first available worker.
+         */
+        void enqueue(std::function<void()> task);
+
+        /*
+         * Blocks the calling thread until every queued task has finished executing.
+         */
+        void wait();
+
+        /*
+         * Returns the number of worker threads owned by the pool.
+         */
+        uint32_t getThreadCount() const;
+
+	private:
+        std::vector<std::thread> _workers;
+        std::queue<std::function<void()> > _tasks;
+
+        std::mutex _mutex;
+        std::condition_variable _task_available;
+        std::condition_variable _tasks_finished;
+        uint32_t _pending_tasks = 0;
+        bool _stopping          = false;
+
+        /*
+         * Main loop of every worker. Pulls tasks from the queue until the pool is shut down.
+         */
+        void workerLoop();
+	};
+}
+
+#endif // VIRTUALVISTA_THREADPOOL_H
@@ -135,6 +135,27 @@ namespace vv
         VkDescriptorType type;
     };
 
+    // Host copies of asset data. Anything uploaded to the gpu is released unless a copy was explicitly requested.
+    struct HostMemoryStatistics
+    {
+        uint64_t resident_bytes         = 0;
+        uint64_t reclaimed_bytes        = 0;
+    };
+
+    // Cost of turning model files into meshes, summed over every model loaded so far. Times are in milliseconds.
+    struct ImportStatistics
+    {
+        uint64_t index_count            = 0;
+        uint64_t unique_vertex_count    = 0;    // what the indices were deduplicated to
+        double parse_time               = 0.0;
+        double deduplication_time       = 0.0;
+        uint32_t cached_model_count     = 0;    // mapped from an up to date .vvmesh instead of imported
+        double cache_load_time          = 0.0;
+        uint32_t gltf_model_count       = 0;
+        double gltf_load_time           = 0.0;  // parsing and uploading the geometry
+        uint64_t mapped_vertex_count    = 0;    // glTF vertices uploaded straight from the file
+    };
+
 	namespace util
 	{
 		static VkCommandBuffer beginSingleUseCommand(VkDevice device, VkCommandPool command_pool)
@@ -187,6 +208,22 @@ namespace vv
 			vkDestroySemaphore(device, semaphore, nullptr);
 		}
 
+		static VkFence createVulkanFence(VkDevice device, bool signaled)
+		{
+			VkFence fence;
+			VkFenceCreateInfo fence_create_info = {};
+			fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			fence_create_info.flags = (signaled) ? VK_FENCE_CREATE_SIGNALED_BIT : 0;
+
+			VV_CHECK_SUCCESS(vkCreateFence(device, &fence_create_info, nullptr, &fence));
+			return fence;
+		}
+
+		static void destroyVulkanFence(VkDevice device, VkFence fence)
+		{
+			vkDestroyFence(device, fence, nullptr);
+		}
+
         static VkDescriptorSetLayout createVulkanDescriptorSetLayout(VkDevice device, std::vector<VkDescriptorSetLayoutBinding> bindings)
         {
             VkDescriptorSetLayout layout = {};
@@ -207,14 +244,4 @@ namespace vv
 	}
 }
 
-namespace std {
-	template<> struct hash<vv::Vertex> {
-		size_t operator()(vv::Vertex const& vertex) const {
-			return ((hash<glm::vec3>()(vertex.position) ^
-				(hash<glm::vec3>()(vertex.normal) << 1)) >> 1) ^
-				(hash<glm::vec2>()(vertex.texCoord) << 1);
-		}
-	};
-}
-
 #endif // VIRTUALVISTA_UTILS_H
\ No newline at end of file
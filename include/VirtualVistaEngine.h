@@ -43,6 +43,11 @@ namespace vv
 
 		VulkanRenderer *_renderer;
         Scene *_scene;
+
+        /*
+         * Prints the renderer's accumulated frame statistics to stdout.
+         */
+        void reportFrameStatistics();
 	};
 }
 
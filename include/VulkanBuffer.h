@@ -21,10 +21,13 @@ namespace vv
 		~VulkanBuffer();
 
 		/*
-		 * Creates two VkBuffers. One as a transfer buffer located on CPU memory and one as a storage buffer on GPU memory.
-		 * Use along with update() and transferToDevice().
+		 * Creates a storage buffer on GPU memory. Data reaches it through updateAndTransfer(), which stages it in the
+		 * device's shared staging arena, so no host side copy is kept around.
+		 *
+		 * note: host_visible creates a single persistently mapped buffer instead. update() then writes straight into
+		 *       memory the gpu reads from. Meant for small data rewritten every frame.
 		 */
-		void create(VulkanDevice *device, VkBufferUsageFlags usage_flags, VkDeviceSize size);
+		void create(VulkanDevice *device, VkBufferUsageFlags usage_flags, VkDeviceSize size, bool host_visible = false);
 
         /*
          *
@@ -32,31 +35,32 @@ namespace vv
 		void shutDown();
 
 		/*
-		 * Helper function to perform an update and transfer in a single step.
+		 * Copies data to GPU memory. The copy is recorded into the device's upload queue and executes once it is flushed.
+		 * data can be released as soon as this returns.
 		 */
 		void updateAndTransfer(void *data);
-		
+
 		/*
-		 * Updates the staging buffer with new raw data.
+		 * Copies size bytes of data into the buffer starting at offset. Used to fill sub-ranges of shared buffers.
 		 */
-		void update(void *data);
+		void updateAndTransfer(const void *data, VkDeviceSize size, VkDeviceSize offset);
 		
 		/*
-		 * Copies a buffer allocated on CPU memory to one allocated on GPU memory.
+		 * Writes raw data into a host visible buffer.
 		 */
-		void transferToDevice();
+		void update(void *data);
 		
 	private:
 		VulkanDevice *_device;
-		VkBuffer _staging_buffer = VK_NULL_HANDLE;
-		VkDeviceMemory _staging_memory = VK_NULL_HANDLE;
-		VkDeviceMemory _buffer_memory;
+		VulkanAllocation _buffer_allocation;
 		VkBufferUsageFlags _usage_flags;
+		void *_mapped_data = nullptr; // only set for host visible buffers
 
 		/*
 		 * Creates the Vulkan abstraction for a data buffer with the given specifications.
 		 */
-		void allocateMemory(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memory_properties, VkBuffer &buffer, VkDeviceMemory &buffer_memory);
+		void allocateMemory(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memory_properties, VkBuffer &buffer, VulkanAllocation &allocation,
+                            VkMemoryPropertyFlags preferred_memory_properties = 0);
 	};
 }
 
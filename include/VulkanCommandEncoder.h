@@ -0,0 +1,105 @@
+#ifndef VIRTUALVISTA_VULKANCOMMANDENCODER_H
+#define VIRTUALVISTA_VULKANCOMMANDENCODER_H
+
+#include <array>
+
+#include "Utils.h"
+
+namespace vv
+{
+    // State changes recorded through an encoder since its last begin().
+    struct CommandEncoderStatistics
+    {
+        uint32_t issued_calls   = 0;
+        uint32_t elided_calls   = 0;
+    };
+
+	/*
+	 * Thin layer over state setting vkCmd* calls that remembers what is currently bound to a command buffer and drops
+	 * calls that would not change anything. Draws and everything else are recorded into command_buffer directly.
+	 *
+	 * note: tracking is conservative. sets and push constants are only assumed to survive while the same pipeline
+	 *       layout is used, since the encoder can't tell whether two layouts are compatible.
+	 */
+	class VulkanCommandEncoder
+	{
+	public:
+		VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+
+		VulkanCommandEncoder();
+		~VulkanCommandEncoder();
+
+        /*
+         * Forgets all tracked state and statistics and starts encoding into command_buffer.
+         *
+         * note: state recorded into command_buffer without going through the encoder afterwards is not seen by it.
+         */
+        void begin(VkCommandBuffer command_buffer);
+
+        void bindPipeline(VkPipelineBindPoint bind_point, VkPipeline pipeline);
+
+        /*
+         * Binds every set in the range individually tracked. The call is only elided if every set and its dynamic
+         * offsets are already bound with pipeline_layout.
+         */
+        void bindDescriptorSets(VkPipelineBindPoint bind_point, VkPipelineLayout pipeline_layout, uint32_t first_set,
+                                uint32_t set_count, const VkDescriptorSet *sets, uint32_t dynamic_offset_count = 0,
+                                const uint32_t *dynamic_offsets = nullptr);
+
+        /*
+         * offset and size have to be multiples of 4, as required for push constants.
+         */
+        void pushConstants(VkPipelineLayout pipeline_layout, VkShaderStageFlags stage_flags, uint32_t offset, uint32_t size, const void *values);
+
+        void bindVertexBuffer(uint32_t binding, VkBuffer buffer, VkDeviceSize offset);
+        void bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType index_type);
+
+        const CommandEncoderStatistics& getStatistics() const;
+
+	private:
+        static const uint32_t max_descriptor_sets       = 8;    // per bind point
+        static const uint32_t max_dynamic_offsets       = 8;    // per set
+        static const uint32_t max_push_constant_size    = 128;  // minimum guaranteed maxPushConstantsSize
+        static const uint32_t max_vertex_bindings       = 4;
+
+        struct BoundSet
+        {
+            VkPipelineLayout pipeline_layout            = VK_NULL_HANDLE;
+            VkDescriptorSet set                         = VK_NULL_HANDLE;
+            uint32_t dynamic_offset_count               = 0;
+            std::array<uint32_t, max_dynamic_offsets> dynamic_offsets;
+        };
+
+        struct BindPointState
+        {
+            VkPipeline pipeline                         = VK_NULL_HANDLE;
+            std::array<BoundSet, max_descriptor_sets> sets;
+        };
+
+        std::array<BindPointState, 2> _bind_points;     // graphics, compute
+
+        // push constants are tracked per 4 byte word. bit i of the mask is set once word i holds a known value.
+        VkPipelineLayout _push_constant_layout          = VK_NULL_HANDLE;
+        uint32_t _push_constant_mask                    = 0;
+        std::array<uint32_t, max_push_constant_size / 4> _push_constant_words;
+        std::array<VkShaderStageFlags, max_push_constant_size / 4> _push_constant_stages;
+
+        std::array<VkBuffer, max_vertex_bindings> _vertex_buffers;
+        std::array<VkDeviceSize, max_vertex_bindings> _vertex_buffer_offsets;
+
+        VkBuffer _index_buffer                          = VK_NULL_HANDLE;
+        VkDeviceSize _index_buffer_offset               = 0;
+        VkIndexType _index_type                         = VK_INDEX_TYPE_UINT32;
+
+        CommandEncoderStatistics _statistics;
+
+        BindPointState& getBindPointState(VkPipelineBindPoint bind_point);
+
+        /*
+         * Counts a state change as issued or elided. Returns whether it has to be recorded.
+         */
+        bool track(bool redundant);
+	};
+}
+
+#endif // VIRTUALVISTA_VULKANCOMMANDENCODER_H
@@ -11,6 +11,8 @@
 #include "GLFWWindow.h"
 #include "Settings.h"
 #include "Utils.h"
+#include "VulkanMemoryAllocator.h"
+#include "VulkanUploadQueue.h"
 
 namespace vv
 {
@@ -37,13 +39,30 @@ namespace vv
 
 		std::unordered_map<std::string, VkCommandPool> command_pools;
 
+		// all buffer and image memory is sub-allocated through here. valid after createLogicalDevice().
+		VulkanMemoryAllocator *memory_allocator = nullptr;
+
+		// batches host to device copies into large submissions. uses the transfer family when available.
+		VulkanUploadQueue *upload_queue = nullptr;
+
+		// VK_KHR_draw_indirect_count entry point. null when the extension is not supported.
+		PFN_vkCmdDrawIndexedIndirectCountKHR cmd_draw_indexed_indirect_count = nullptr;
+
+		// lower of the instance and device api versions
+		uint32_t api_version = VK_API_VERSION_1_0;
+
+		// VK_EXT_descriptor_indexing with everything bindless materials need: runtime sized, partially bound sampler
+		// arrays indexed non uniformly and updated while bound. enabled on the logical device when true.
+		bool descriptor_indexing = false;
+		uint32_t max_bindless_sampled_images = 0;
+
 		VulkanDevice();
 		~VulkanDevice();
 
 		/*
-		 * Creates all initial Vulkan internals.
+		 * Creates all initial Vulkan internals. instance_api_version is the version the instance was created with.
 		 */
-		void create(VkPhysicalDevice device);
+		void create(VkPhysicalDevice device, uint32_t instance_api_version = VK_API_VERSION_1_0);
 
 		/*
 		 * Deletes all Vulkan internals.
@@ -72,6 +91,12 @@ namespace vv
 		 */
 		uint32_t findMemoryTypeIndex(uint32_t filter_type, VkMemoryPropertyFlags memory_property_flags);
 
+		/*
+		 * Same as above, but favors a memory type that additionally has the preferred flags when one exists.
+		 * i.e. device local + host visible memory (resizable BAR) for data the cpu writes every frame.
+		 */
+		uint32_t findMemoryTypeIndex(uint32_t filter_type, VkMemoryPropertyFlags required_flags, VkMemoryPropertyFlags preferred_flags);
+
 	private:
 		/*
 		 * Checks to see if this GPU has swap chain support (creating queues of rendered frames to pass to a window system)
@@ -89,6 +114,11 @@ namespace vv
 		 * Checks if the requested device level extension is presently available.
 		 */
 		bool checkDeviceExtensionSupport(const char* extension);
+
+		/*
+		 * Fills descriptor_indexing. Needs vkGetPhysicalDeviceFeatures2, so only 1.1 devices are queried.
+		 */
+		void queryDescriptorIndexingSupport();
 	};
 }
 
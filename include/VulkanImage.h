@@ -41,7 +41,8 @@ namespace vv
          */
         void create(VulkanDevice *device, VkExtent3D extent, VkFormat format, VkImageType type, VkImageCreateFlags flags,
                     VkImageAspectFlags aspect_flags, uint32_t mip_levels, uint32_t array_layers,
-                    VkImageLayout initial_layout, VkSampleCountFlagBits sample_count);
+                    VkImageLayout initial_layout, VkSampleCountFlagBits sample_count,
+                    VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
 
         /*
 		 * Creates an image from existing image. Mainly for swap chain image support.
@@ -51,8 +52,11 @@ namespace vv
 
         /*
          * Creates a special image intended to be used as a depth/stencil attachment to a framebuffer.
+         *
+         * note: additional_usage is added on top of the attachment usage, e.g. sampled for reading depth back in shaders.
          */
-        void createDepthAttachment(VulkanDevice *device, VkExtent2D extent, VkImageTiling tiling, VkFormatFeatureFlags features);
+        void createDepthAttachment(VulkanDevice *device, VkExtent2D extent, VkImageTiling tiling, VkFormatFeatureFlags features,
+                                   VkImageUsageFlags additional_usage = 0);
 
 		/*
 		 * Removes allocated device memory.
@@ -71,32 +75,25 @@ namespace vv
 
 	private:
 		VulkanDevice *_device;
-		VkImage _staging_image			= VK_NULL_HANDLE;
-        VkBuffer _staging_buffer        = VK_NULL_HANDLE;
-		VkDeviceMemory _staging_memory	= VK_NULL_HANDLE;
-		VkDeviceMemory _image_memory	= VK_NULL_HANDLE;
+		VulkanAllocation _image_allocation;
 
         std::unordered_map<VkFormat, FormatInfo> _format_info_table =
         {
             { VK_FORMAT_R8G8B8A8_UNORM, { 4, { 1, 1, 1 } } },
             { VK_FORMAT_R32G32_SFLOAT, { 8, { 1, 1, 1 } } },
             { VK_FORMAT_R32G32B32A32_SFLOAT, { 16, { 1, 1, 1 } } },
+            { VK_FORMAT_BC1_RGB_UNORM_BLOCK, { 8, { 4, 4, 1 } } },
             { VK_FORMAT_BC3_UNORM_BLOCK, { 16, { 4, 4, 1 } } },
             { VK_FORMAT_R8_UNORM, { 1, { 1, 1, 1 } } },
             { VK_FORMAT_R8G8B8_UNORM, { 3, { 1, 1, 1 } } }
         };
 
-        /*
-         * Allocates a VkBuffer to use during transfer operations between host and device memory.
-         */
-        void allocateTransferMemory(VkDeviceSize size_in_bytes);
-
 		/*
 		 * Creates the Vulkan abstraction for a data buffer with the given specifications.
 		 */
         void allocateMemory(VkImageTiling tiling, VkImageUsageFlags usage, VkImageCreateFlags flags, VkImageLayout initial_layout,
                             VkSampleCountFlagBits sample_count, VkMemoryPropertyFlags memory_properties, VkImage &image,
-                            VkDeviceMemory &memory);
+                            VulkanAllocation &allocation);
 	
 		/*
 		 * Move the linearly stored staging image into an optimal texture storage layout.
@@ -24,6 +24,14 @@ namespace vv
 		 */
 		void create(VulkanDevice *device, VulkanImage *image, VkImageViewType image_view_type, uint32_t base_mip_level);
 
+		/*
+		 * Same as above, but limited to the given aspects and mip_level_count levels. i.e. the depth aspect of a
+		 * depth/stencil image for sampling, or a single mip level for storage writes.
+		 * components reorders the channels shaders read. Identity by default.
+		 */
+		void create(VulkanDevice *device, VulkanImage *image, VkImageViewType image_view_type, VkImageAspectFlags aspect_flags,
+                    uint32_t base_mip_level, uint32_t mip_level_count, VkComponentMapping components = {});
+
 		/*
 		 *
 		 */
@@ -0,0 +1,125 @@
+#ifndef VIRTUALVISTA_VULKANMEMORYALLOCATOR_H
+#define VIRTUALVISTA_VULKANMEMORYALLOCATOR_H
+
+#include <vector>
+#include <map>
+#include <mutex>
+
+#include "Utils.h"
+
+namespace vv
+{
+    struct VulkanDevice;
+    struct MemoryBlock;
+
+    // Determines which pool a resource is placed in. Linear (buffers, linear images) and optimal (tiled images) resources
+    // never share a block, so bufferImageGranularity can never be violated between neighbouring allocations.
+    enum class ResourceTiling
+    {
+        Linear,
+        Optimal
+    };
+
+    struct VulkanAllocation
+    {
+        VkDeviceMemory memory   = VK_NULL_HANDLE;
+        VkDeviceSize offset     = 0;
+        VkDeviceSize size       = 0;
+        void *mapped_data       = nullptr; // persistently mapped pointer to offset. only set for host visible memory.
+        uint32_t memory_type    = 0;
+        MemoryBlock *block      = nullptr; // nullptr for dedicated allocations
+        uint32_t pool_index     = 0;       // pool block belongs to. unused for dedicated allocations.
+    };
+
+    struct MemoryStatistics
+    {
+        uint32_t block_count                = 0;
+        uint32_t dedicated_allocation_count = 0;
+        uint32_t allocation_count           = 0; // sub-allocations + dedicated allocations
+        VkDeviceSize bytes_reserved         = 0; // total device memory obtained through vkAllocateMemory
+        VkDeviceSize bytes_used             = 0;
+        VkDeviceSize largest_free_range     = 0;
+        float fragmentation                 = 0.0f; // 0 = all free space is contiguous, 1 = free space is scattered in tiny ranges
+    };
+
+    struct MemoryBlock
+    {
+        VkDeviceMemory memory   = VK_NULL_HANDLE;
+        VkDeviceSize size       = 0;
+        VkDeviceSize used       = 0;
+        uint8_t *mapped_data    = nullptr;
+        uint32_t allocation_count = 0;
+        std::map<VkDeviceSize, VkDeviceSize> free_ranges; // offset -> size, kept coalesced
+    };
+
+	class VulkanMemoryAllocator
+	{
+	public:
+		VulkanMemoryAllocator();
+		~VulkanMemoryAllocator();
+
+		/*
+		 * Prepares one pool per memory type and resource tiling. No device memory is allocated until it is needed.
+		 */
+		void create(VulkanDevice *device);
+
+        /*
+         * Frees every block. All allocations handed out must have been freed already.
+         */
+		void shutDown();
+
+        /*
+         * Sub-allocates memory that satisfies the given requirements out of a large block. Resources larger than half a
+         * block receive a dedicated vkAllocateMemory instead. Host visible memory is always returned mapped.
+         *
+         * note: preferred_flags are only honoured when a memory type with them exists.
+         */
+        void allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags required_flags, VkMemoryPropertyFlags preferred_flags,
+                      ResourceTiling tiling, VulkanAllocation &allocation);
+
+        /*
+         * Returns the range to its block. Blocks that become empty are released, except for the last one of each pool.
+         */
+        void free(VulkanAllocation &allocation);
+
+        /*
+         * Snapshot of block usage and fragmentation across all pools.
+         */
+        MemoryStatistics getStatistics();
+
+	private:
+        struct MemoryPool
+        {
+            std::vector<MemoryBlock *> blocks;
+        };
+
+		VulkanDevice *_device = nullptr;
+        std::mutex _mutex;
+
+        std::vector<MemoryPool> _pools; // [memory_type * 2 + tiling]
+        uint32_t _dedicated_allocation_count = 0;
+        VkDeviceSize _dedicated_bytes = 0;
+
+        /*
+         * Size of new blocks for the given memory type. Small heaps (i.e. a 256MB BAR window) get smaller blocks.
+         */
+        VkDeviceSize getBlockSize(uint32_t memory_type) const;
+
+        /*
+         * Calls vkAllocateMemory and maps the result when the memory type is host visible.
+         */
+        void allocateDeviceMemory(uint32_t memory_type, VkDeviceSize size, VkDeviceMemory &memory, void *&mapped_data);
+
+        /*
+         * First fit search through a block's free ranges. Returns false if no range can hold the aligned request.
+         */
+        bool allocateFromBlock(MemoryBlock *block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset);
+
+        /*
+         * Inserts a free range into the block, merging it with its neighbours.
+         */
+        void releaseToBlock(MemoryBlock *block, VkDeviceSize offset, VkDeviceSize size);
+	};
+}
+
+#endif // VIRTUALVISTA_VULKANMEMORYALLOCATOR_H
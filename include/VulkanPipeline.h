@@ -20,13 +20,20 @@ namespace vv
 		~VulkanPipeline();
 
 		/*
-		 * Creates a pipeline abstraction.
+		 * Creates a pipeline abstraction. Shaders without a frag_module get a depth only pipeline that reads nothing
+         * but vertex positions and leaves the color attachment untouched.
          *
          * note: this is single use pipeline for now. No current way to alter the pipeline
          *       created outside of shader modules, descriptor set layouts, and push constants.
 		 */
 		void create(VulkanDevice *device, Shader *shader, VkPipelineLayout pipeline_layout,
-                    VulkanRenderPass *render_pass, VkFrontFace front_face, bool depth_test_enable, bool depth_write_enable);
+                    VulkanRenderPass *render_pass, VkFrontFace front_face, bool depth_test_enable, bool depth_write_enable,
+                    VkCompareOp depth_compare_op = VK_COMPARE_OP_LESS);
+
+		/*
+		 * Creates a compute pipeline from the comp_module of shader.
+		 */
+		void createCompute(VulkanDevice *device, Shader *shader, VkPipelineLayout pipeline_layout);
 
 		/*
 		 *
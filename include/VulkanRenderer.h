@@ -11,16 +11,32 @@
 #include "VulkanPipeline.h"
 #include "VulkanRenderPass.h"
 #include "VulkanBuffer.h"
+#include "VulkanCommandEncoder.h"
 #include "VulkanDevice.h"
 #include "Scene.h"
 #include "Material.h"
 #include "ModelManager.h"
 #include "Mesh.h"
 #include "Shader.h"
+#include "ThreadPool.h"
 #include "Utils.h"
 
 namespace vv
 {
+    // Cpu side cost of building the frame. All timings are in milliseconds.
+    struct FrameStatistics
+    {
+        uint64_t frame_count            = 0;
+        uint64_t frames_over_budget     = 0;
+        double last_record_time         = 0.0;
+        double average_record_time      = 0.0;
+        double max_record_time          = 0.0;
+        uint32_t visible_draws          = 0;
+        uint32_t culled_draws           = 0;
+        uint32_t issued_state_calls     = 0;    // pipeline, descriptor set, push constant and buffer binds of the last recording
+        uint32_t elided_state_calls     = 0;    // ... and the ones dropped as redundant
+    };
+
 	class VulkanRenderer
 	{
 	public:
@@ -55,6 +71,33 @@ namespace vv
          */
         Scene* getScene() const;
 
+        /*
+         * Returns cpu timings gathered while building frames.
+         *
+         * note: recording times are only gathered when per frame recording is enabled.
+         */
+        const FrameStatistics& getFrameStatistics() const;
+
+        /*
+         * Clears the accumulated maximums so the next report only covers new frames.
+         */
+        void resetFrameStatistics();
+
+        /*
+         * Returns block usage and fragmentation of the device memory allocator.
+         */
+        MemoryStatistics getMemoryStatistics() const;
+
+        /*
+         * Returns how much asset data is still kept on the host and how much was released after upload.
+         */
+        HostMemoryStatistics getHostMemoryStatistics() const;
+
+        /*
+         * Returns how long model imports took and how many vertices deduplication left.
+         */
+        const ImportStatistics& getImportStatistics() const;
+
 		/*
 		 * Returns whether the renderer should stop execution.
 		 */
@@ -63,18 +106,40 @@ namespace vv
 	private:
 		GLFWWindow *window_						    = nullptr;
 		VkInstance instance_					    = VK_NULL_HANDLE;
+		uint32_t instance_api_version_			    = VK_API_VERSION_1_0;
 		VkDebugReportCallbackEXT debug_callback_    = VK_NULL_HANDLE;
 		VulkanDevice* physical_device_              = nullptr;
 		
         VulkanSwapChain *swap_chain_;
 		std::vector<VkFramebuffer> frame_buffers_;
 
-		VkSemaphore image_ready_semaphore_          = VK_NULL_HANDLE;
-		VkSemaphore rendering_complete_semaphore_   = VK_NULL_HANDLE;
+		// one set of sync primitives per frame in flight. the fence marks when the gpu has finished consuming
+		// everything that frame slot owns (command buffers + per-frame uniform data).
+		uint32_t max_frames_in_flight_              = 1;
+		uint32_t current_frame_                     = 0;
+		std::vector<VkSemaphore> image_ready_semaphores_;
+		std::vector<VkSemaphore> rendering_complete_semaphores_;
+		std::vector<VkFence> in_flight_fences_;
 
 		VulkanRenderPass *render_pass_              = nullptr;
+
+		// indexed by [frame_in_flight * swap_chain_image_count + swap_chain_image_index]
 		std::vector<VkCommandBuffer> command_buffers_;
 
+		// per frame recording. each frame in flight owns a transient pool that is reset (not freed) before re-recording.
+		bool record_per_frame_                      = false;
+		std::vector<VkCommandPool> frame_command_pools_;
+		std::vector<VkCommandBuffer> frame_command_buffers_;
+
+		// multithreaded recording. the draw list is split into one chunk per worker, each recorded into a secondary
+		// command buffer allocated from a pool that only that chunk touches. indexed by [frame_in_flight][chunk].
+		ThreadPool *recording_thread_pool_          = nullptr;
+		std::vector<std::vector<VkCommandPool> > secondary_command_pools_;
+		std::vector<std::vector<VkCommandBuffer> > secondary_command_buffers_;
+
+		std::vector<VkClearValue> clear_values_;
+		FrameStatistics frame_statistics_;
+
         Scene *scene_;
 
         std::vector<const char*> used_validation_layers_ = { "VK_LAYER_LUNARG_standard_validation" };
@@ -95,6 +160,33 @@ namespace vv
 		 */
 		void setupDebugCallback();
 
+		/*
+		 * Creates the semaphores + fences needed for each frame in flight.
+		 */
+		void createFrameSyncObjects();
+
+		/*
+		 * Creates one transient command pool + primary command buffer per frame in flight for per frame recording.
+		 */
+		void createFrameCommandPools();
+
+		/*
+		 * Records the full render pass for the given frame in flight targeting the given swap chain image.
+		 */
+		void recordCommandBuffer(VkCommandBuffer command_buffer, uint32_t frame_index, uint32_t image_index,
+                                 VkCommandBufferUsageFlags usage_flags);
+
+		/*
+		 * Splits the scene across the recording threads, records each part into a secondary command buffer and
+		 * executes them all from the given primary command buffer. Must be called inside the render pass.
+		 */
+		void recordSecondaryCommandBuffers(VkCommandBuffer primary_command_buffer, uint32_t frame_index, uint32_t image_index);
+
+		/*
+		 * Resets this frame's transient pool and records a fresh command buffer. Returns the recorded buffer.
+		 */
+		VkCommandBuffer recordFrameCommandBuffer(uint32_t frame_index, uint32_t image_index);
+
 		/*
 		 * Creates Vulkan FrameBuffer objects that encapsulate all of the Vulkan image textures in the swap chain for storing rendered frames.
 		 */
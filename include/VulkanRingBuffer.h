@@ -0,0 +1,76 @@
+#ifndef VIRTUALVISTA_VULKANRINGBUFFER_H
+#define VIRTUALVISTA_VULKANRINGBUFFER_H
+
+#include <vector>
+
+#include "Utils.h"
+#include "VulkanDevice.h"
+
+namespace vv
+{
+	class VulkanRingBuffer
+	{
+	public:
+		VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+
+        // whether the memory backing this buffer lives on the gpu (resizable BAR) or in system memory.
+        bool is_device_local = false;
+
+		VulkanRingBuffer();
+		~VulkanRingBuffer();
+
+		/*
+		 * Creates a single persistently mapped, host visible buffer split into one region per frame in flight.
+         * Data written through allocate() is visible to the gpu directly. No staging copy or queue submission is involved.
+         *
+         * note: device local + host visible memory is used when the device exposes it.
+		 */
+		void create(VulkanDevice *device, VkBufferUsageFlags usage_flags, VkDeviceSize frame_size, uint32_t frame_count);
+
+        /*
+         *
+         */
+		void shutDown();
+
+        /*
+         * Rewinds the allocator to the start of the region owned by frame_index.
+         *
+         * note: the caller must guarantee the gpu is no longer reading from that region (i.e. the frame's fence was waited on).
+         */
+        void beginFrame(uint32_t frame_index);
+
+        /*
+         * Sub-allocates size bytes from the current frame's region. Returns a pointer to write the data to and outputs
+         * the offset from the start of the buffer to use as a (dynamic) descriptor offset.
+         */
+        void* allocate(VkDeviceSize size, VkDeviceSize &offset);
+
+        /*
+         * Helper that allocates and copies in a single step. Returns the offset of the written data.
+         */
+        VkDeviceSize write(const void *data, VkDeviceSize size);
+
+        /*
+         * Returns how many bytes of the current frame's region have been handed out.
+         */
+        VkDeviceSize getFrameUsage() const;
+
+        /*
+         * Returns the size of the region owned by each frame.
+         */
+        VkDeviceSize getFrameSize() const;
+
+	private:
+		VulkanDevice *_device;
+		VulkanAllocation _allocation;
+        uint8_t *_mapped_data      = nullptr;
+
+        VkDeviceSize _frame_size   = 0;
+        VkDeviceSize _alignment    = 1;
+        VkDeviceSize _frame_begin  = 0;
+        VkDeviceSize _head         = 0;
+	};
+}
+
+#endif // VIRTUALVISTA_VULKANRINGBUFFER_H
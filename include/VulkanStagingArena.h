@@ -0,0 +1,58 @@
+#ifndef VIRTUALVISTA_VULKANSTAGINGARENA_H
+#define VIRTUALVISTA_VULKANSTAGINGARENA_H
+
+#include "Utils.h"
+#include "VulkanMemoryAllocator.h"
+
+namespace vv
+{
+    struct VulkanDevice;
+
+	class VulkanStagingArena
+	{
+	public:
+		VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+
+		VulkanStagingArena();
+		~VulkanStagingArena();
+
+		/*
+		 * Creates one persistently mapped, host visible transfer source buffer that all uploads share.
+		 */
+		void create(VulkanDevice *device, VkDeviceSize size);
+
+        /*
+         *
+         */
+		void shutDown();
+
+        /*
+         * Carves size bytes out of the ring. Returns nullptr when the free space is too small. The caller is expected to
+         * retire in flight uploads and try again.
+         */
+        void* allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset);
+
+        /*
+         * Returns the current write position. Recorded by uploads so the space can be handed back once they complete.
+         */
+        VkDeviceSize getHead() const;
+
+        /*
+         * Frees everything allocated before end. Releases must happen in allocation order.
+         */
+        void release(VkDeviceSize end);
+
+	private:
+		VulkanDevice *_device = nullptr;
+		VulkanAllocation _allocation;
+        uint8_t *_mapped_data = nullptr;
+
+        // [_tail, _head) is in use, wrapping around the end of the buffer
+        VkDeviceSize _head = 0;
+        VkDeviceSize _tail = 0;
+        bool _empty = true;
+	};
+}
+
+#endif // VIRTUALVISTA_VULKANSTAGINGARENA_H
@@ -0,0 +1,157 @@
+#ifndef VIRTUALVISTA_VULKANUPLOADQUEUE_H
+#define VIRTUALVISTA_VULKANUPLOADQUEUE_H
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <functional>
+
+#include "Utils.h"
+#include "VulkanStagingArena.h"
+
+namespace vv
+{
+    struct VulkanDevice;
+
+	class VulkanUploadQueue
+	{
+	public:
+		VulkanUploadQueue();
+		~VulkanUploadQueue();
+
+		/*
+		 * Prepares command pools for batched uploads. Copies run on the dedicated transfer family when the device has one.
+		 */
+		void create(VulkanDevice *device);
+
+        /*
+         * Waits for all submitted uploads and releases every batch. Unsubmitted work is discarded.
+         */
+		void shutDown();
+
+        /*
+         * Copies data into the shared staging arena and records a copy into dst at dst_offset. Nothing is submitted
+         * until flush() or until the batch grows past Settings' upload batch size. data can be released right away.
+         *
+         * note: blocks on older uploads only when the staging arena is full. Since a full batch is submitted right
+         *       away, uploads should be issued from the thread that submits rendering work.
+         */
+        void uploadBuffer(const void *data, VkDeviceSize size, VkBuffer dst, VkDeviceSize dst_offset, VkBufferUsageFlags dst_usage);
+
+        /*
+         * Records the full upload of an image: transition into TRANSFER_DST, copy all regions and hand the image over
+         * to the graphics queue in SHADER_READ_ONLY_OPTIMAL. Region buffer offsets are relative to data.
+         *
+         * note: alignment has to satisfy the copy rules of the image format (a multiple of 4 and of the texel block size).
+         */
+        void uploadImage(const void *data, VkDeviceSize size, VkDeviceSize alignment, VkImage dst, std::vector<VkBufferImageCopy> regions,
+                         VkImageSubresourceRange subresource_range, VkImageLayout old_layout);
+
+        /*
+         * Registers a callback that is executed once everything recorded so far has finished on the gpu.
+         */
+        void onComplete(std::function<void()> callback);
+
+        /*
+         * Submits the open batch without waiting for it. Returns the id of the submitted batch, or of the last
+         * submitted one when nothing was pending.
+         *
+         * note: with a dedicated transfer family this also submits ownership acquires to the graphics queue, so it has
+         *       to be called from the thread that submits rendering work.
+         */
+        uint64_t flush();
+
+        /*
+         * Polls fences of in flight batches and runs completion callbacks of the ones that are done.
+         */
+        void collect();
+
+        /*
+         * Returns whether batch_id, and every batch submitted before it, finished executing.
+         */
+        bool isComplete(uint64_t batch_id);
+
+        /*
+         * Blocks until batch_id has completed.
+         */
+        void wait(uint64_t batch_id);
+
+        /*
+         * Flushes and blocks until every upload has completed.
+         */
+        void waitIdle();
+
+	private:
+        struct UploadBatch
+        {
+            uint64_t id                                 = 0;
+            VkCommandBuffer transfer_command_buffer     = VK_NULL_HANDLE;
+            VkCommandBuffer acquire_command_buffer      = VK_NULL_HANDLE; // graphics side. only used with ownership transfers
+            VkSemaphore transfer_complete               = VK_NULL_HANDLE;
+            VkFence fence                               = VK_NULL_HANDLE;
+            VkDeviceSize byte_count                     = 0;
+            VkPipelineStageFlags consumer_stages        = 0;
+            bool uses_staging                           = false;
+            VkDeviceSize staging_end                    = 0; // arena space up to here is freed when the batch retires
+
+            // recorded at the end of the transfer command buffer. releases ownership when it changes queue family.
+            std::vector<VkBufferMemoryBarrier> buffer_releases;
+            std::vector<VkImageMemoryBarrier> image_releases;
+
+            // recorded into the graphics side acquire command buffer
+            std::vector<VkBufferMemoryBarrier> buffer_acquires;
+            std::vector<VkImageMemoryBarrier> image_acquires;
+            std::vector<std::function<void()> > callbacks;
+        };
+
+		VulkanDevice *_device                       = nullptr;
+        std::mutex _mutex;
+
+        // copies run on a different queue family than rendering, which requires release + acquire barriers
+        bool _transfer_ownership                    = false;
+        uint32_t _transfer_family                   = 0;
+        uint32_t _graphics_family                   = 0;
+        VkQueue _transfer_queue                     = VK_NULL_HANDLE;
+        VkCommandPool _transfer_command_pool        = VK_NULL_HANDLE;
+        VkCommandPool _acquire_command_pool         = VK_NULL_HANDLE;
+        VulkanStagingArena *_staging_arena          = nullptr;
+
+        UploadBatch *_open_batch                    = nullptr;
+        std::deque<UploadBatch *> _in_flight_batches;
+        std::vector<UploadBatch *> _free_batches;
+        uint64_t _next_batch_id                     = 1;
+        uint64_t _last_submitted_batch_id           = 0;
+        uint64_t _last_completed_batch_id           = 0;
+
+        /*
+         * Returns the open batch, beginning a new one if needed. Expects _mutex to be held.
+         */
+        UploadBatch* getOpenBatch();
+
+        /*
+         * Submits the open batch. Expects _mutex to be held.
+         */
+        void submitOpenBatch();
+
+        /*
+         * Reserves staging memory for an upload and marks the open batch as its owner. Waits on in flight batches when
+         * the arena is full and falls back to a temporary buffer for uploads larger than the whole arena.
+         * Expects _mutex to be held. Callbacks of batches retired while waiting are appended to callbacks.
+         */
+        void* allocateStaging(VkDeviceSize size, VkDeviceSize alignment, VkBuffer &src, VkDeviceSize &src_offset,
+                              std::vector<std::function<void()> > &callbacks);
+
+        /*
+         * Retires completed batches from the front of the in flight list. Expects _mutex to be held.
+         * Returns the callbacks that have to be run once the lock is released.
+         */
+        std::vector<std::function<void()> > retireCompletedBatches(bool block);
+
+        /*
+         * Maps buffer usage onto the pipeline stages and access types that will consume the uploaded data.
+         */
+        void determineBufferConsumers(VkBufferUsageFlags usage, VkPipelineStageFlags &stages, VkAccessFlags &access) const;
+	};
+}
+
+#endif // VIRTUALVISTA_VULKANUPLOADQUEUE_H
@@ -0,0 +1,431 @@
+#include <algorithm>
+
+#include "BoundingVolumeHierarchy.h"
+#include "Utils.h"
+
+namespace vv
+{
+	///////////////////////////////////////////////////////////////////////////////////////////// Public
+	BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+	{
+	}
+
+
+	BoundingVolumeHierarchy::~BoundingVolumeHierarchy()
+	{
+	}
+
+
+    void BoundingVolumeHierarchy::clear()
+    {
+        _nodes.clear();
+        _root = null_proxy;
+        _free_list = null_proxy;
+        _leaf_count = 0;
+    }
+
+
+    uint32_t BoundingVolumeHierarchy::insert(const AABB &box, uint32_t user_data)
+    {
+        uint32_t leaf = allocateNode();
+        _nodes[leaf].box = enlarge(box);
+        _nodes[leaf].tight_box = box;
+        _nodes[leaf].height = 0;
+        _nodes[leaf].user_data = user_data;
+
+        insertLeaf(leaf);
+        ++_leaf_count;
+        return leaf;
+    }
+
+
+    void BoundingVolumeHierarchy::remove(uint32_t proxy)
+    {
+        VV_ASSERT(proxy < _nodes.size() && _nodes[proxy].isLeaf() && _nodes[proxy].height == 0, "ERROR: proxy is not a leaf");
+
+        removeLeaf(proxy);
+        freeNode(proxy);
+        --_leaf_count;
+    }
+
+
+    bool BoundingVolumeHierarchy::refit(uint32_t proxy, const AABB &box)
+    {
+        VV_ASSERT(proxy < _nodes.size() && _nodes[proxy].isLeaf() && _nodes[proxy].height == 0, "ERROR: proxy is not a leaf");
+
+        _nodes[proxy].tight_box = box;
+        if (_nodes[proxy].box.contains(box))
+            return false;
+
+        removeLeaf(proxy);
+        _nodes[proxy].box = enlarge(box);
+        insertLeaf(proxy);
+        return true;
+    }
+
+
+    uint32_t BoundingVolumeHierarchy::getUserData(uint32_t proxy) const
+    {
+        return _nodes[proxy].user_data;
+    }
+
+
+    const AABB& BoundingVolumeHierarchy::getBox(uint32_t proxy) const
+    {
+        return _nodes[proxy].tight_box;
+    }
+
+
+    uint32_t BoundingVolumeHierarchy::getLeafCount() const
+    {
+        return _leaf_count;
+    }
+
+
+    uint32_t BoundingVolumeHierarchy::getHeight() const
+    {
+        return (_root == null_proxy) ? 0 : static_cast<uint32_t>(_nodes[_root].height);
+    }
+
+
+    void BoundingVolumeHierarchy::queryFrustum(const Frustum &frustum, std::vector<uint32_t> &inside, std::vector<uint32_t> &intersecting) const
+    {
+        if (_root == null_proxy)
+            return;
+
+        std::vector<uint32_t> stack;
+        stack.reserve(64);
+        stack.push_back(_root);
+
+        while (!stack.empty())
+        {
+            const Node &node = _nodes[stack.back()];
+            uint32_t index = stack.back();
+            stack.pop_back();
+
+            FrustumTest test = frustum.classify(node.box);
+            if (test == FrustumTest::Outside)
+                continue;
+
+            if (test == FrustumTest::Inside)
+                collectLeaves(index, inside);
+            else if (node.isLeaf())
+                intersecting.push_back(node.user_data);
+            else
+            {
+                stack.push_back(node.left);
+                stack.push_back(node.right);
+            }
+        }
+    }
+
+
+    void BoundingVolumeHierarchy::querySphere(const BoundingSphere &sphere, std::vector<uint32_t> &results) const
+    {
+        if (_root == null_proxy)
+            return;
+
+        auto touches = [&sphere](const AABB &box) {
+            glm::vec3 closest = glm::clamp(sphere.center, box.min, box.max);
+            glm::vec3 offset = closest - sphere.center;
+            return glm::dot(offset, offset) <= sphere.radius * sphere.radius;
+        };
+
+        std::vector<uint32_t> stack;
+        stack.reserve(64);
+        stack.push_back(_root);
+
+        while (!stack.empty())
+        {
+            const Node &node = _nodes[stack.back()];
+            stack.pop_back();
+
+            if (!touches(node.box))
+                continue;
+
+            if (node.isLeaf())
+            {
+                if (touches(node.tight_box))
+                    results.push_back(node.user_data);
+            }
+            else
+            {
+                stack.push_back(node.left);
+                stack.push_back(node.right);
+            }
+        }
+    }
+
+
+    bool BoundingVolumeHierarchy::raycast(const glm::vec3 &origin, const glm::vec3 &direction, float max_distance,
+                                          uint32_t &user_data, float &distance) const
+    {
+        if (_root == null_proxy)
+            return false;
+
+        // slab test. returns whether the ray hits box and its entry distance if so. a miss is never a distance, so an
+        // unbounded max_distance can't mistake one for a hit.
+        glm::vec3 inverse_direction = 1.0f / direction;
+        auto hit = [&](const AABB &box, float &entry) {
+            glm::vec3 t0 = (box.min - origin) * inverse_direction;
+            glm::vec3 t1 = (box.max - origin) * inverse_direction;
+            glm::vec3 t_near = glm::min(t0, t1);
+            glm::vec3 t_far = glm::max(t0, t1);
+
+            entry = std::max(std::max(t_near.x, t_near.y), std::max(t_near.z, 0.0f));
+            float exit = std::min(std::min(t_far.x, t_far.y), t_far.z);
+            return entry <= exit;
+        };
+
+        float closest = max_distance;
+        bool found = false;
+
+        std::vector<uint32_t> stack;
+        stack.reserve(64);
+        stack.push_back(_root);
+
+        while (!stack.empty())
+        {
+            const Node &node = _nodes[stack.back()];
+            stack.pop_back();
+
+            // anything missed or entered past the closest hit so far can't contain a closer one
+            float entry;
+            if (!hit(node.box, entry) || entry > closest)
+                continue;
+
+            if (node.isLeaf())
+            {
+                float t;
+                if (hit(node.tight_box, t) && t <= closest)
+                {
+                    closest = t;
+                    user_data = node.user_data;
+                    found = true;
+                }
+            }
+            else
+            {
+                stack.push_back(node.left);
+                stack.push_back(node.right);
+            }
+        }
+
+        distance = closest;
+        return found;
+    }
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////// Private
+    uint32_t BoundingVolumeHierarchy::allocateNode()
+    {
+        if (_free_list == null_proxy)
+        {
+            _nodes.push_back(Node());
+            return static_cast<uint32_t>(_nodes.size() - 1);
+        }
+
+        uint32_t index = _free_list;
+        _free_list = _nodes[index].parent;
+        _nodes[index] = Node();
+        return index;
+    }
+
+
+    void BoundingVolumeHierarchy::freeNode(uint32_t index)
+    {
+        _nodes[index].parent = _free_list;
+        _nodes[index].height = -1;
+        _free_list = index;
+    }
+
+
+    void BoundingVolumeHierarchy::insertLeaf(uint32_t leaf)
+    {
+        if (_root == null_proxy)
+        {
+            _root = leaf;
+            _nodes[leaf].parent = null_proxy;
+            return;
+        }
+
+        // descend towards the child that grows the least. stop once a new parent here is cheaper than going deeper.
+        const AABB leaf_box = _nodes[leaf].box;
+        uint32_t index = _root;
+        while (!_nodes[index].isLeaf())
+        {
+            const Node &node = _nodes[index];
+            float area = node.box.getSurfaceArea();
+            float combined_area = AABB::merge(node.box, leaf_box).getSurfaceArea();
+
+            // pairing with this node creates a parent of combined_area. every ancestor below grows as well.
+            float cost = 2.0f * combined_area;
+            float inheritance_cost = 2.0f * (combined_area - area);
+
+            auto descendCost = [&](uint32_t child) {
+                const Node &c = _nodes[child];
+                float merged_area = AABB::merge(c.box, leaf_box).getSurfaceArea();
+                return (c.isLeaf() ? merged_area : merged_area - c.box.getSurfaceArea()) + inheritance_cost;
+            };
+
+            float left_cost = descendCost(node.left);
+            float right_cost = descendCost(node.right);
+
+            if (cost < left_cost && cost < right_cost)
+                break;
+
+            index = (left_cost < right_cost) ? node.left : node.right;
+        }
+
+        uint32_t sibling = index;
+        uint32_t old_parent = _nodes[sibling].parent;
+        uint32_t new_parent = allocateNode(); // may reallocate _nodes
+
+        _nodes[new_parent].parent = old_parent;
+        _nodes[new_parent].box = AABB::merge(leaf_box, _nodes[sibling].box);
+        _nodes[new_parent].height = _nodes[sibling].height + 1;
+        _nodes[new_parent].left = sibling;
+        _nodes[new_parent].right = leaf;
+        _nodes[sibling].parent = new_parent;
+        _nodes[leaf].parent = new_parent;
+
+        if (old_parent == null_proxy)
+            _root = new_parent;
+        else if (_nodes[old_parent].left == sibling)
+            _nodes[old_parent].left = new_parent;
+        else
+            _nodes[old_parent].right = new_parent;
+
+        refitAncestors(_nodes[leaf].parent);
+    }
+
+
+    void BoundingVolumeHierarchy::removeLeaf(uint32_t leaf)
+    {
+        if (leaf == _root)
+        {
+            _root = null_proxy;
+            return;
+        }
+
+        uint32_t parent = _nodes[leaf].parent;
+        uint32_t grand_parent = _nodes[parent].parent;
+        uint32_t sibling = (_nodes[parent].left == leaf) ? _nodes[parent].right : _nodes[parent].left;
+
+        // the sibling takes the parent's place
+        _nodes[sibling].parent = grand_parent;
+        freeNode(parent);
+
+        if (grand_parent == null_proxy)
+        {
+            _root = sibling;
+            return;
+        }
+
+        if (_nodes[grand_parent].left == parent)
+            _nodes[grand_parent].left = sibling;
+        else
+            _nodes[grand_parent].right = sibling;
+
+        refitAncestors(grand_parent);
+    }
+
+
+    void BoundingVolumeHierarchy::refitAncestors(uint32_t index)
+    {
+        while (index != null_proxy)
+        {
+            index = balance(index);
+
+            Node &node = _nodes[index];
+            const Node &left = _nodes[node.left];
+            const Node &right = _nodes[node.right];
+            node.height = 1 + std::max(left.height, right.height);
+            node.box = AABB::merge(left.box, right.box);
+
+            index = node.parent;
+        }
+    }
+
+
+    uint32_t BoundingVolumeHierarchy::balance(uint32_t index)
+    {
+        Node &a = _nodes[index];
+        if (a.isLeaf() || a.height < 2)
+            return index;
+
+        uint32_t ib = a.left;
+        uint32_t ic = a.right;
+        Node &b = _nodes[ib];
+        Node &c = _nodes[ic];
+        int32_t difference = c.height - b.height;
+
+        if (difference >= -1 && difference <= 1)
+            return index;
+
+        // the taller child p takes a's place. its taller child stays with it, the shorter one moves under a.
+        uint32_t ip = (difference > 1) ? ic : ib;
+        Node &p = _nodes[ip];
+        uint32_t ishort = (difference > 1) ? ib : ic;
+
+        uint32_t ix = p.left;
+        uint32_t iy = p.right;
+        if (_nodes[ix].height > _nodes[iy].height)
+            std::swap(ix, iy);
+
+        // ix is the shorter grandchild and moves under a, iy stays with p
+        p.left = index;
+        p.right = iy;
+        p.parent = a.parent;
+        a.parent = ip;
+
+        if (p.parent == null_proxy)
+            _root = ip;
+        else if (_nodes[p.parent].left == index)
+            _nodes[p.parent].left = ip;
+        else
+            _nodes[p.parent].right = ip;
+
+        a.left = ishort;
+        a.right = ix;
+        _nodes[ix].parent = index;
+
+        a.box = AABB::merge(_nodes[ishort].box, _nodes[ix].box);
+        a.height = 1 + std::max(_nodes[ishort].height, _nodes[ix].height);
+        p.box = AABB::merge(a.box, _nodes[iy].box);
+        p.height = 1 + std::max(a.height, _nodes[iy].height);
+
+        return ip;
+    }
+
+
+    void BoundingVolumeHierarchy::collectLeaves(uint32_t index, std::vector<uint32_t> &results) const
+    {
+        std::vector<uint32_t> stack(1, index);
+        while (!stack.empty())
+        {
+            const Node &node = _nodes[stack.back()];
+            stack.pop_back();
+
+            if (node.isLeaf())
+                results.push_back(node.user_data);
+            else
+            {
+                stack.push_back(node.left);
+                stack.push_back(node.right);
+            }
+        }
+    }
+
+
+    AABB BoundingVolumeHierarchy::enlarge(const AABB &box)
+    {
+        // relative margin, so it works the same regardless of scene units. the absolute term covers flat boxes.
+        glm::vec3 margin = box.getExtents() * 0.1f + glm::vec3(0.01f);
+
+        AABB result;
+        result.min = box.min - margin;
+        result.max = box.max + margin;
+        return result;
+    }
+}
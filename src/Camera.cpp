@@ -94,5 +94,11 @@ namespace vv
         return glm::lookAt(Entity::getPosition(), _look_at_point, _up_vec);
     }
 
+
+    float Camera::getFarPlane() const
+    {
+        return _far_plane;
+    }
+
 	///////////////////////////////////////////////////////////////////////////////////////////// Private
 }
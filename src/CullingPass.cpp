@@ -0,0 +1,362 @@
+#include <algorithm>
+
+#include "CullingPass.h"
+#include "Utils.h"
+
+namespace vv
+{
+	///////////////////////////////////////////////////////////////////////////////////////////// Public
+	CullingPass::CullingPass()
+	{
+	}
+
+
+	CullingPass::~CullingPass()
+	{
+	}
+
+
+	void CullingPass::create(VulkanDevice *device, VulkanSwapChain *swap_chain, VulkanRingBuffer *ring_buffer)
+	{
+        _device = device;
+        _swap_chain = swap_chain;
+        _ring_buffer = ring_buffer;
+
+        createDepthPyramid();
+        createDescriptorSets();
+        createPipelines();
+	}
+
+
+	void CullingPass::shutDown()
+	{
+        _cull_pipeline->shutDown(); delete _cull_pipeline;
+        _pyramid_pipeline->shutDown(); delete _pyramid_pipeline;
+        _cull_shader->shutDown(); delete _cull_shader;
+        _pyramid_shader->shutDown(); delete _pyramid_shader;
+
+        vkDestroyPipelineLayout(_device->logical_device, _cull_pipeline_layout, nullptr);
+        vkDestroyPipelineLayout(_device->logical_device, _pyramid_pipeline_layout, nullptr);
+        vkDestroyDescriptorSetLayout(_device->logical_device, _cull_descriptor_set_layout, nullptr);
+        vkDestroyDescriptorSetLayout(_device->logical_device, _pyramid_descriptor_set_layout, nullptr);
+        vkDestroyDescriptorPool(_device->logical_device, _descriptor_pool, nullptr);
+
+        for (auto &v : _level_views)
+        {
+            v->shutDown();
+            delete v;
+        }
+
+        _depth_pyramid_view->shutDown(); delete _depth_pyramid_view;
+        _depth_view->shutDown(); delete _depth_view;
+        _depth_pyramid->shutDown(); delete _depth_pyramid;
+        _sampler->shutDown(); delete _sampler;
+	}
+
+
+    void CullingPass::recordCulling(VkCommandBuffer command_buffer, uint32_t uniform_offset, uint32_t instance_block_offset, uint32_t instance_count)
+    {
+        if (instance_count == 0)
+            return;
+
+        // the cull shader reads, writes and counts into the block through three views starting at the same offset
+        std::array<uint32_t, 4> dynamic_offsets = { uniform_offset, instance_block_offset, instance_block_offset, instance_block_offset };
+
+        _cull_pipeline->bind(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE);
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, _cull_pipeline_layout, 0, 1, &_cull_descriptor_set,
+                                static_cast<uint32_t>(dynamic_offsets.size()), dynamic_offsets.data());
+        vkCmdDispatch(command_buffer, (instance_count + 63) / 64, 1, 1);
+
+        // draws read the counted commands and the compacted instances
+        VkMemoryBarrier memory_barrier = {};
+        memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memory_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        memory_barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                             0, 1, &memory_barrier, 0, nullptr, 0, nullptr);
+    }
+
+
+    void CullingPass::recordDepthPyramid(VkCommandBuffer command_buffer)
+    {
+        VulkanImage *depth_image = _swap_chain->depth_image;
+
+        VkImageMemoryBarrier depth_barrier = {};
+        depth_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        depth_barrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        depth_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        depth_barrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depth_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        depth_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        depth_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        depth_barrier.image = depth_image->image;
+        depth_barrier.subresourceRange.aspectMask = depth_image->aspect_flags;
+        depth_barrier.subresourceRange.levelCount = 1;
+        depth_barrier.subresourceRange.layerCount = 1;
+
+        // the compute stage in the source scope also keeps this frame's cull reads ahead of the pyramid writes
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &depth_barrier);
+
+        _pyramid_pipeline->bind(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE);
+
+        VkMemoryBarrier level_barrier = {};
+        level_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        level_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        level_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        for (uint32_t level = 0; level < _depth_pyramid->mip_levels; ++level)
+        {
+            uint32_t width = std::max(_pyramid_extent.width >> level, 1u);
+            uint32_t height = std::max(_pyramid_extent.height >> level, 1u);
+
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pyramid_pipeline_layout, 0, 1,
+                                    &_pyramid_descriptor_sets[level], 0, nullptr);
+            vkCmdDispatch(command_buffer, (width + 7) / 8, (height + 7) / 8, 1);
+
+            // the next level reads this one. after the last level, this orders the writes before next frame's cull.
+            vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                 0, 1, &level_barrier, 0, nullptr, 0, nullptr);
+        }
+
+        // hand depth back to the render pass, which expects it as an attachment
+        std::swap(depth_barrier.oldLayout, depth_barrier.newLayout);
+        depth_barrier.srcAccessMask = 0;
+        depth_barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &depth_barrier);
+    }
+
+
+    VkExtent2D CullingPass::getPyramidExtent() const
+    {
+        return _pyramid_extent;
+    }
+
+
+    uint32_t CullingPass::getPyramidLevelCount() const
+    {
+        return _depth_pyramid->mip_levels;
+    }
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////// Private
+    void CullingPass::createDepthPyramid()
+    {
+        // largest power of two that fits into the attachment. every level then covers exactly half of the one below,
+        // and uv coordinates map onto texels of any level without rounding.
+        auto previousPowerOfTwo = [](uint32_t value) {
+            uint32_t result = 1;
+            while (result * 2 <= value)
+                result *= 2;
+            return result;
+        };
+
+        _pyramid_extent.width = previousPowerOfTwo(_swap_chain->extent.width);
+        _pyramid_extent.height = previousPowerOfTwo(_swap_chain->extent.height);
+
+        uint32_t level_count = 1;
+        while ((std::max(_pyramid_extent.width, _pyramid_extent.height) >> level_count) > 0)
+            ++level_count;
+
+        _depth_pyramid = new VulkanImage();
+        _depth_pyramid->create(_device, { _pyramid_extent.width, _pyramid_extent.height, 1 }, VK_FORMAT_R32_SFLOAT, VK_IMAGE_TYPE_2D, 0,
+                               VK_IMAGE_ASPECT_COLOR_BIT, level_count, 1, VK_IMAGE_LAYOUT_UNDEFINED, VK_SAMPLE_COUNT_1_BIT,
+                               VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT);
+
+        _depth_pyramid_view = new VulkanImageView();
+        _depth_pyramid_view->create(_device, _depth_pyramid, VK_IMAGE_VIEW_TYPE_2D, 0);
+
+        for (uint32_t i = 0; i < level_count; ++i)
+        {
+            VulkanImageView *level_view = new VulkanImageView();
+            level_view->create(_device, _depth_pyramid, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT, i, 1);
+            _level_views.push_back(level_view);
+        }
+
+        // a view with stencil can't be sampled
+        _depth_view = new VulkanImageView();
+        _depth_view->create(_device, _swap_chain->depth_image, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1);
+
+        // every read is a texelFetch. filtering would mix depths and break the conservative test.
+        _sampler = new VulkanSampler();
+        _sampler->create(_device, VK_FILTER_NEAREST, VK_FILTER_NEAREST, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                         VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, false, 1.0f, VK_SAMPLER_MIPMAP_MODE_NEAREST, 0.0f, 0.0f,
+                         static_cast<float>(level_count), false);
+
+        // storage writes and sampled reads both work in the general layout, so the pyramid never changes layouts again
+        auto command_pool = _device->command_pools["graphics"];
+        auto command_buffer = util::beginSingleUseCommand(_device->logical_device, command_pool);
+
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = _depth_pyramid->image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.levelCount = level_count;
+        barrier.subresourceRange.layerCount = 1;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        util::endSingleUseCommand(_device->logical_device, command_pool, command_buffer, _device->graphics_queue);
+    }
+
+
+    void CullingPass::createDescriptorSets()
+    {
+        uint32_t level_count = _depth_pyramid->mip_levels;
+
+        std::array<VkDescriptorPoolSize, 4> pool_sizes = {};
+        pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        pool_sizes[0].descriptorCount = 1;
+        pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+        pool_sizes[1].descriptorCount = 3;
+        pool_sizes[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        pool_sizes[2].descriptorCount = 1 + level_count;
+        pool_sizes[3].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        pool_sizes[3].descriptorCount = level_count;
+
+        VkDescriptorPoolCreateInfo pool_create_info = {};
+        pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_create_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+        pool_create_info.pPoolSizes = pool_sizes.data();
+        pool_create_info.maxSets = 1 + level_count;
+        VV_CHECK_SUCCESS(vkCreateDescriptorPool(_device->logical_device, &pool_create_info, nullptr, &_descriptor_pool));
+
+        auto createBinding = [](uint32_t binding, VkDescriptorType type) {
+            VkDescriptorSetLayoutBinding layout_binding = {};
+            layout_binding.binding = binding;
+            layout_binding.descriptorType = type;
+            layout_binding.descriptorCount = 1;
+            layout_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+            return layout_binding;
+        };
+
+        /// Layouts
+        std::array<VkDescriptorSetLayoutBinding, 5> cull_bindings = {
+            createBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC),
+            createBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC), // instances
+            createBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC), // bounds
+            createBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC), // draw commands
+            createBinding(4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)  // depth pyramid
+        };
+
+        VkDescriptorSetLayoutCreateInfo layout_create_info = {};
+        layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layout_create_info.bindingCount = static_cast<uint32_t>(cull_bindings.size());
+        layout_create_info.pBindings = cull_bindings.data();
+        VV_CHECK_SUCCESS(vkCreateDescriptorSetLayout(_device->logical_device, &layout_create_info, nullptr, &_cull_descriptor_set_layout));
+
+        std::array<VkDescriptorSetLayoutBinding, 2> pyramid_bindings = {
+            createBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER),
+            createBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
+        };
+
+        layout_create_info.bindingCount = static_cast<uint32_t>(pyramid_bindings.size());
+        layout_create_info.pBindings = pyramid_bindings.data();
+        VV_CHECK_SUCCESS(vkCreateDescriptorSetLayout(_device->logical_device, &layout_create_info, nullptr, &_pyramid_descriptor_set_layout));
+
+        /// Sets
+        std::vector<VkDescriptorSetLayout> set_layouts(level_count, _pyramid_descriptor_set_layout);
+        set_layouts.push_back(_cull_descriptor_set_layout);
+
+        std::vector<VkDescriptorSet> sets(set_layouts.size());
+        VkDescriptorSetAllocateInfo allocate_info = {};
+        allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocate_info.descriptorPool = _descriptor_pool;
+        allocate_info.descriptorSetCount = static_cast<uint32_t>(set_layouts.size());
+        allocate_info.pSetLayouts = set_layouts.data();
+        VV_CHECK_SUCCESS(vkAllocateDescriptorSets(_device->logical_device, &allocate_info, sets.data()));
+
+        _cull_descriptor_set = sets.back();
+        _pyramid_descriptor_sets.assign(sets.begin(), sets.end() - 1);
+
+        // the instance block of a frame can take up its whole region. the actual location comes from dynamic offsets.
+        std::array<VkDescriptorBufferInfo, 4> buffer_infos = {};
+        for (auto &info : buffer_infos)
+        {
+            info.buffer = _ring_buffer->buffer;
+            info.offset = 0;
+            info.range = _ring_buffer->getFrameSize();
+        }
+        buffer_infos[0].range = sizeof(CullingUniforms);
+
+        VkDescriptorImageInfo pyramid_info = {};
+        pyramid_info.sampler = _sampler->sampler;
+        pyramid_info.imageView = _depth_pyramid_view->image_view;
+        pyramid_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        std::vector<VkWriteDescriptorSet> write_sets;
+        for (uint32_t i = 0; i < 5; ++i)
+        {
+            VkWriteDescriptorSet write_set = {};
+            write_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write_set.dstSet = _cull_descriptor_set;
+            write_set.dstBinding = i;
+            write_set.descriptorCount = 1;
+            write_set.descriptorType = cull_bindings[i].descriptorType;
+            if (i < 4)
+                write_set.pBufferInfo = &buffer_infos[i];
+            else
+                write_set.pImageInfo = &pyramid_info;
+            write_sets.push_back(write_set);
+        }
+
+        std::vector<VkDescriptorImageInfo> source_infos(level_count);
+        std::vector<VkDescriptorImageInfo> destination_infos(level_count);
+        for (uint32_t i = 0; i < level_count; ++i)
+        {
+            source_infos[i].sampler = _sampler->sampler;
+            source_infos[i].imageView = (i == 0) ? _depth_view->image_view : _level_views[i - 1]->image_view;
+            source_infos[i].imageLayout = (i == 0) ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+            destination_infos[i].imageView = _level_views[i]->image_view;
+            destination_infos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+            VkWriteDescriptorSet write_set = {};
+            write_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write_set.dstSet = _pyramid_descriptor_sets[i];
+            write_set.descriptorCount = 1;
+
+            write_set.dstBinding = 0;
+            write_set.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            write_set.pImageInfo = &source_infos[i];
+            write_sets.push_back(write_set);
+
+            write_set.dstBinding = 1;
+            write_set.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            write_set.pImageInfo = &destination_infos[i];
+            write_sets.push_back(write_set);
+        }
+
+        vkUpdateDescriptorSets(_device->logical_device, static_cast<uint32_t>(write_sets.size()), write_sets.data(), 0, nullptr);
+    }
+
+
+    void CullingPass::createPipelines()
+    {
+        VkPipelineLayoutCreateInfo pipeline_layout_create_info = {};
+        pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipeline_layout_create_info.setLayoutCount = 1;
+
+        pipeline_layout_create_info.pSetLayouts = &_cull_descriptor_set_layout;
+        VV_CHECK_SUCCESS(vkCreatePipelineLayout(_device->logical_device, &pipeline_layout_create_info, nullptr, &_cull_pipeline_layout));
+
+        pipeline_layout_create_info.pSetLayouts = &_pyramid_descriptor_set_layout;
+        VV_CHECK_SUCCESS(vkCreatePipelineLayout(_device->logical_device, &pipeline_layout_create_info, nullptr, &_pyramid_pipeline_layout));
+
+        _cull_shader = new Shader();
+        _cull_shader->createCompute(_device, "cull");
+        _cull_pipeline = new VulkanPipeline();
+        _cull_pipeline->createCompute(_device, _cull_shader, _cull_pipeline_layout);
+
+        _pyramid_shader = new Shader();
+        _pyramid_shader->createCompute(_device, "depth_pyramid");
+        _pyramid_pipeline = new VulkanPipeline();
+        _pyramid_pipeline->createCompute(_device, _pyramid_shader, _pyramid_pipeline_layout);
+    }
+}
@@ -5,6 +5,9 @@ namespace vv
 {
 	///////////////////////////////////////////////////////////////////////////////////////////// Public
 	Entity::Entity() :
+        _is_visible(true),
+        _is_renderable(true),
+        _has_moved(true),
         _pose(glm::mat4())
 	{
 	}
@@ -27,21 +30,30 @@ namespace vv
 	}
 
 
+    bool Entity::isVisible() const
+    {
+        return _is_visible;
+    }
+
+
     void Entity::translate(glm::vec3 translation)
 	{
         _pose = glm::translate(_pose, translation);
+        _has_moved = true;
 	}
 
 
     void Entity::rotate(float angle, glm::vec3 axis)
 	{
         _pose = glm::rotate(_pose, angle, axis);
+        _has_moved = true;
 	}
 
 
     void Entity::scale(glm::vec3 scaling)
 	{
         _pose = glm::scale(_pose, scaling);
+        _has_moved = true;
 	}
 
 
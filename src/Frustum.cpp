@@ -0,0 +1,158 @@
+#include <cmath>
+
+#include "Frustum.h"
+
+// every x86-64 target has sse2. 32 bit builds only when the compiler was told so.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define VV_FRUSTUM_SSE
+    #include <emmintrin.h>
+#endif
+
+namespace vv
+{
+	///////////////////////////////////////////////////////////////////////////////////////////// Public
+    void CullBounds::resize(std::size_t box_count)
+    {
+        count = box_count;
+        std::size_t padded_count = (box_count + 3) & ~std::size_t(3);
+
+        center_x.resize(padded_count, 0.0f);
+        center_y.resize(padded_count, 0.0f);
+        center_z.resize(padded_count, 0.0f);
+        extent_x.resize(padded_count, 0.0f);
+        extent_y.resize(padded_count, 0.0f);
+        extent_z.resize(padded_count, 0.0f);
+    }
+
+
+    void CullBounds::set(std::size_t i, const AABB &box)
+    {
+        glm::vec3 center = box.getCenter();
+        glm::vec3 extents = box.getExtents();
+
+        center_x[i] = center.x;
+        center_y[i] = center.y;
+        center_z[i] = center.z;
+        extent_x[i] = extents.x;
+        extent_y[i] = extents.y;
+        extent_z[i] = extents.z;
+    }
+
+
+	Frustum::Frustum()
+	{
+	}
+
+
+	Frustum::~Frustum()
+	{
+	}
+
+
+    void Frustum::update(const glm::mat4 &view_projection)
+    {
+        // rows of the matrix. glm stores columns.
+        glm::vec4 rows[4];
+        for (int i = 0; i < 4; ++i)
+            rows[i] = glm::vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]);
+
+        _planes[0] = rows[3] + rows[0]; // left
+        _planes[1] = rows[3] - rows[0]; // right
+        _planes[2] = rows[3] + rows[1]; // bottom
+        _planes[3] = rows[3] - rows[1]; // top
+        _planes[4] = rows[3] + rows[2]; // near. conservative for vulkan's [0, 1] depth range.
+        _planes[5] = rows[3] - rows[2]; // far
+    }
+
+
+    bool Frustum::intersects(const AABB &box) const
+    {
+        glm::vec3 center = box.getCenter();
+        glm::vec3 extents = box.getExtents();
+
+        for (const auto &plane : _planes)
+        {
+            float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+            float radius = std::abs(plane.x) * extents.x + std::abs(plane.y) * extents.y + std::abs(plane.z) * extents.z;
+
+            if (distance + radius < 0.0f)
+                return false;
+        }
+
+        return true;
+    }
+
+
+    FrustumTest Frustum::classify(const AABB &box) const
+    {
+        glm::vec3 center = box.getCenter();
+        glm::vec3 extents = box.getExtents();
+        FrustumTest result = FrustumTest::Inside;
+
+        for (const auto &plane : _planes)
+        {
+            float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+            float radius = std::abs(plane.x) * extents.x + std::abs(plane.y) * extents.y + std::abs(plane.z) * extents.z;
+
+            if (distance + radius < 0.0f)
+                return FrustumTest::Outside;
+            if (distance - radius < 0.0f)
+                result = FrustumTest::Intersecting;
+        }
+
+        return result;
+    }
+
+
+    void Frustum::cull(const CullBounds &bounds, std::vector<uint8_t> &visible) const
+    {
+        visible.resize(bounds.count);
+
+#ifdef VV_FRUSTUM_SSE
+        const __m128 zero = _mm_setzero_ps();
+
+        for (std::size_t i = 0; i < bounds.count; i += 4)
+        {
+            __m128 cx = _mm_loadu_ps(&bounds.center_x[i]);
+            __m128 cy = _mm_loadu_ps(&bounds.center_y[i]);
+            __m128 cz = _mm_loadu_ps(&bounds.center_z[i]);
+            __m128 ex = _mm_loadu_ps(&bounds.extent_x[i]);
+            __m128 ey = _mm_loadu_ps(&bounds.extent_y[i]);
+            __m128 ez = _mm_loadu_ps(&bounds.extent_z[i]);
+
+            // a box is outside once it is fully behind any one plane
+            __m128 outside = zero;
+            for (const auto &plane : _planes)
+            {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_mul_ps(cy, _mm_set1_ps(plane.y))),
+                                             _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+                __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, _mm_set1_ps(std::abs(plane.x))), _mm_mul_ps(ey, _mm_set1_ps(std::abs(plane.y)))),
+                                           _mm_mul_ps(ez, _mm_set1_ps(std::abs(plane.z))));
+
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+            }
+
+            int mask = _mm_movemask_ps(outside);
+            for (std::size_t j = 0; j < 4 && i + j < bounds.count; ++j)
+                visible[i + j] = ((mask >> j) & 1) ? 0 : 1;
+        }
+#else
+        for (std::size_t i = 0; i < bounds.count; ++i)
+        {
+            AABB box;
+            box.min = glm::vec3(bounds.center_x[i] - bounds.extent_x[i], bounds.center_y[i] - bounds.extent_y[i], bounds.center_z[i] - bounds.extent_z[i]);
+            box.max = glm::vec3(bounds.center_x[i] + bounds.extent_x[i], bounds.center_y[i] + bounds.extent_y[i], bounds.center_z[i] + bounds.extent_z[i]);
+            visible[i] = intersects(box) ? 1 : 0;
+        }
+#endif
+    }
+
+
+    const std::array<glm::vec4, 6>& Frustum::getPlanes() const
+    {
+        return _planes;
+    }
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////// Private
+}
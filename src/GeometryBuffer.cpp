@@ -0,0 +1,112 @@
+#include <algorithm>
+
+#include "GeometryBuffer.h"
+#include "Settings.h"
+
+namespace vv
+{
+	///////////////////////////////////////////////////////////////////////////////////////////// Public
+	GeometryBuffer::GeometryBuffer()
+	{
+	}
+
+
+	GeometryBuffer::~GeometryBuffer()
+	{
+	}
+
+
+	void GeometryBuffer::create(VulkanDevice *device)
+	{
+        VV_ASSERT(device != VK_NULL_HANDLE, "VulkanDevice not present");
+        _device = device;
+	}
+
+
+	void GeometryBuffer::shutDown()
+	{
+        for (auto &page : _pages)
+        {
+            page->vertex_buffer.shutDown();
+            page->index_buffer.shutDown();
+            delete page;
+        }
+        _pages.clear();
+	}
+
+
+    GeometryRange GeometryBuffer::allocate(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices)
+    {
+        return allocate(vertices.data(), static_cast<uint32_t>(vertices.size()), indices.data(), static_cast<uint32_t>(indices.size()));
+    }
+
+
+    GeometryRange GeometryBuffer::allocate(const Vertex *vertices, uint32_t vertex_count, const uint32_t *indices, uint32_t index_count)
+    {
+        // first page with room for both. pages fill up in load order, so only the last ones are likely to fit.
+        uint32_t page_index = 0;
+        GeometryPage *page = nullptr;
+        for (; page_index < _pages.size(); ++page_index)
+        {
+            GeometryPage *p = _pages[page_index];
+            if (p->vertex_count + vertex_count <= p->vertex_capacity && p->index_count + index_count <= p->index_capacity)
+            {
+                page = p;
+                break;
+            }
+        }
+
+        if (!page)
+            page = createPage(vertex_count, index_count);
+
+        GeometryRange range = {};
+        range.page = page_index;
+        range.first_index = page->index_count;
+        range.index_count = index_count;
+        range.vertex_offset = static_cast<int32_t>(page->vertex_count);
+        range.vertex_count = vertex_count;
+
+        if (vertex_count > 0)
+            page->vertex_buffer.updateAndTransfer(vertices, sizeof(Vertex) * vertex_count, sizeof(Vertex) * page->vertex_count);
+        if (index_count > 0)
+            page->index_buffer.updateAndTransfer(indices, sizeof(uint32_t) * index_count, sizeof(uint32_t) * page->index_count);
+
+        page->vertex_count += vertex_count;
+        page->index_count += index_count;
+
+        return range;
+    }
+
+
+    void GeometryBuffer::bind(VulkanCommandEncoder &encoder, uint32_t page) const
+    {
+        VV_ASSERT(page < _pages.size(), "Geometry page does not exist");
+
+        encoder.bindVertexBuffer(0, _pages[page]->vertex_buffer.buffer, 0);
+        encoder.bindIndexBuffer(_pages[page]->index_buffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+    }
+
+
+    uint32_t GeometryBuffer::getPageCount() const
+    {
+        return static_cast<uint32_t>(_pages.size());
+    }
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////// Private
+    GeometryBuffer::GeometryPage* GeometryBuffer::createPage(uint32_t vertex_count, uint32_t index_count)
+    {
+        VkDeviceSize page_size = Settings::inst()->getGeometryBufferSize();
+
+        // meshes larger than a page get a page of their own, sized to fit
+        GeometryPage *page = new GeometryPage();
+        page->vertex_capacity = std::max(static_cast<uint32_t>(page_size / sizeof(Vertex)), vertex_count);
+        page->index_capacity = std::max(static_cast<uint32_t>(page_size / sizeof(uint32_t)), index_count);
+
+        page->vertex_buffer.create(_device, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sizeof(Vertex) * page->vertex_capacity);
+        page->index_buffer.create(_device, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, sizeof(uint32_t) * page->index_capacity);
+
+        _pages.push_back(page);
+        return page;
+    }
+}
@@ -0,0 +1,1149 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+#include "GltfImporter.h"
+
+namespace vv
+{
+    static const uint32_t glb_magic = 0x46546C67;           // "glTF"
+    static const uint32_t glb_json_chunk = 0x4E4F534A;      // "JSON"
+    static const uint32_t glb_binary_chunk = 0x004E4942;    // "BIN\0"
+
+    static const uint32_t component_byte = 5120;
+    static const uint32_t component_unsigned_byte = 5121;
+    static const uint32_t component_short = 5122;
+    static const uint32_t component_unsigned_short = 5123;
+    static const uint32_t component_unsigned_int = 5125;
+    static const uint32_t component_float = 5126;
+
+    static const uint32_t mode_triangles = 4;
+
+    // deep enough for any real file, shallow enough that recursion can't overflow the stack
+    static const int max_depth = 64;
+
+    struct JsonValue
+    {
+        enum class Type
+        {
+            Null,
+            Boolean,
+            Number,
+            String,
+            Array,
+            Object
+        };
+
+        Type type = Type::Null;
+        bool boolean = false;
+        double number = 0.0;
+        std::string string;
+        std::vector<JsonValue> elements;    // array elements or object member values
+        std::vector<std::string> keys;      // object member names, parallel to elements
+
+        // returns a null value if there is no such member. objects in glTF are small, so a linear search is enough.
+        const JsonValue& operator[](const char *key) const
+        {
+            static const JsonValue null_value;
+            for (std::size_t i = 0; i < keys.size(); ++i)
+                if (keys[i] == key)
+                    return elements[i];
+            return null_value;
+        }
+
+        const JsonValue& operator[](std::size_t i) const
+        {
+            return elements[i];
+        }
+
+        // a literal 0 would be ambiguous between the two above otherwise
+        const JsonValue& operator[](int i) const
+        {
+            return elements[i];
+        }
+
+        std::size_t size() const
+        {
+            return (type == Type::Array) ? elements.size() : 0;
+        }
+
+        int asInt(int fallback) const
+        {
+            return (type == Type::Number) ? static_cast<int>(number) : fallback;
+        }
+
+        std::size_t asSize(std::size_t fallback) const
+        {
+            return (type == Type::Number && number >= 0.0) ? static_cast<std::size_t>(number) : fallback;
+        }
+
+        float asFloat(float fallback) const
+        {
+            return (type == Type::Number) ? static_cast<float>(number) : fallback;
+        }
+    };
+
+
+    static const char* skipWhitespace(const char *p, const char *end)
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+            ++p;
+        return p;
+    }
+
+
+    static const char* matchLiteral(const char *p, const char *end, const char *literal)
+    {
+        std::size_t length = std::strlen(literal);
+        return (static_cast<std::size_t>(end - p) >= length && std::strncmp(p, literal, length) == 0) ? p + length : nullptr;
+    }
+
+
+    static void appendUtf8(uint32_t code_point, std::string &value)
+    {
+        if (code_point < 0x80)
+            value += static_cast<char>(code_point);
+        else if (code_point < 0x800)
+        {
+            value += static_cast<char>(0xC0 | (code_point >> 6));
+            value += static_cast<char>(0x80 | (code_point & 0x3F));
+        }
+        else if (code_point < 0x10000)
+        {
+            value += static_cast<char>(0xE0 | (code_point >> 12));
+            value += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+            value += static_cast<char>(0x80 | (code_point & 0x3F));
+        }
+        else
+        {
+            value += static_cast<char>(0xF0 | (code_point >> 18));
+            value += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+            value += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+            value += static_cast<char>(0x80 | (code_point & 0x3F));
+        }
+    }
+
+
+    static int parseHexDigit(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    }
+
+
+    static const char* parseHex4(const char *p, const char *end, uint32_t &value)
+    {
+        if (end - p < 4)
+            return nullptr;
+
+        value = 0;
+        for (int i = 0; i < 4; ++i, ++p)
+        {
+            int digit = parseHexDigit(*p);
+            if (digit < 0)
+                return nullptr;
+            value = (value << 4) | static_cast<uint32_t>(digit);
+        }
+        return p;
+    }
+
+
+    /*
+     * Reads the string starting at the quote p points to. Returns nullptr if it is malformed.
+     */
+    static const char* parseJsonString(const char *p, const char *end, std::string &value)
+    {
+        value.clear();
+        for (++p; p < end && *p != '"';)
+        {
+            // runs without escapes are copied at once
+            const char *run = p;
+            while (p < end && *p != '"' && *p != '\\')
+                ++p;
+            value.append(run, p);
+
+            if (p >= end || *p == '"')
+                break;
+
+            if (++p >= end)
+                return nullptr;
+
+            switch (*p++)
+            {
+            case '"':  value += '"'; break;
+            case '\\': value += '\\'; break;
+            case '/':  value += '/'; break;
+            case 'b':  value += '\b'; break;
+            case 'f':  value += '\f'; break;
+            case 'n':  value += '\n'; break;
+            case 'r':  value += '\r'; break;
+            case 't':  value += '\t'; break;
+            case 'u':
+            {
+                uint32_t code_point;
+                if (!(p = parseHex4(p, end, code_point)))
+                    return nullptr;
+
+                // characters outside the basic plane are written as a surrogate pair
+                uint32_t low;
+                if (code_point >= 0xD800 && code_point < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u' &&
+                    parseHex4(p + 2, end, low) && low >= 0xDC00 && low < 0xE000)
+                {
+                    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                }
+
+                appendUtf8(code_point, value);
+                break;
+            }
+            default:
+                return nullptr;
+            }
+        }
+
+        return (p < end) ? p + 1 : nullptr;
+    }
+
+
+    /*
+     * Same approach as the obj parser: doesn't look at the locale and is exact for what exporters write.
+     */
+    static const char* parseJsonNumber(const char *p, const char *end, double &value)
+    {
+        static const double powers_of_ten[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        bool negative = (p < end && *p == '-');
+        if (negative)
+            ++p;
+
+        uint64_t mantissa = 0;
+        int exponent = 0;
+        int digit_count = 0;
+        bool has_digits = false;
+
+        for (; p < end && *p >= '0' && *p <= '9'; ++p, has_digits = true)
+        {
+            if (digit_count < 19)
+            {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                digit_count += (mantissa != 0);
+            }
+            else
+                ++exponent;
+        }
+
+        if (p < end && *p == '.')
+        {
+            for (++p; p < end && *p >= '0' && *p <= '9'; ++p, has_digits = true)
+            {
+                if (digit_count < 19)
+                {
+                    mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                    digit_count += (mantissa != 0);
+                    --exponent;
+                }
+            }
+        }
+
+        if (!has_digits)
+            return nullptr;
+
+        if (p < end && (*p == 'e' || *p == 'E'))
+        {
+            ++p;
+            bool negative_exponent = false;
+            if (p < end && (*p == '-' || *p == '+'))
+                negative_exponent = (*p++ == '-');
+
+            if (p >= end || *p < '0' || *p > '9')
+                return nullptr;
+
+            int written_exponent = 0;
+            for (; p < end && *p >= '0' && *p <= '9'; ++p)
+                written_exponent = std::min(written_exponent * 10 + (*p - '0'), 10000);
+            exponent += negative_exponent ? -written_exponent : written_exponent;
+        }
+
+        double result = static_cast<double>(mantissa);
+        for (; exponent > 0 && result != 0.0; exponent -= std::min(exponent, 22))
+            result *= powers_of_ten[std::min(exponent, 22)];
+        for (; exponent < 0 && result != 0.0; exponent += std::min(-exponent, 22))
+            result /= powers_of_ten[std::min(-exponent, 22)];
+
+        value = negative ? -result : result;
+        return p;
+    }
+
+
+    static const char* parseJsonValue(const char *p, const char *end, int depth, JsonValue &value)
+    {
+        p = skipWhitespace(p, end);
+        if (p >= end || depth > max_depth)
+            return nullptr;
+
+        switch (*p)
+        {
+        case '{':
+        case '[':
+        {
+            bool object = (*p == '{');
+            char closing = object ? '}' : ']';
+            value.type = object ? JsonValue::Type::Object : JsonValue::Type::Array;
+
+            p = skipWhitespace(p + 1, end);
+            if (p < end && *p == closing)
+                return p + 1;
+
+            while (p)
+            {
+                if (object)
+                {
+                    p = skipWhitespace(p, end);
+                    if (p >= end || *p != '"')
+                        return nullptr;
+
+                    value.keys.emplace_back();
+                    if (!(p = parseJsonString(p, end, value.keys.back())))
+                        return nullptr;
+
+                    p = skipWhitespace(p, end);
+                    if (p >= end || *p++ != ':')
+                        return nullptr;
+                }
+
+                value.elements.emplace_back();
+                if (!(p = parseJsonValue(p, end, depth + 1, value.elements.back())))
+                    return nullptr;
+
+                p = skipWhitespace(p, end);
+                if (p < end && *p == ',')
+                    ++p;
+                else if (p < end && *p == closing)
+                    return p + 1;
+                else
+                    return nullptr;
+            }
+            return nullptr;
+        }
+        case '"':
+            value.type = JsonValue::Type::String;
+            return parseJsonString(p, end, value.string);
+        case 't':
+            value.type = JsonValue::Type::Boolean;
+            value.boolean = true;
+            return matchLiteral(p, end, "true");
+        case 'f':
+            value.type = JsonValue::Type::Boolean;
+            return matchLiteral(p, end, "false");
+        case 'n':
+            return matchLiteral(p, end, "null");
+        default:
+            value.type = JsonValue::Type::Number;
+            return parseJsonNumber(p, end, value.number);
+        }
+    }
+
+
+    static bool parseJson(const char *data, std::size_t size, JsonValue &document)
+    {
+        const char *end = data + size;
+
+        // byte order mark some editors put in front of text files
+        if (size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+            data += 3;
+
+        const char *p = parseJsonValue(data, end, 0, document);
+        return p && skipWhitespace(p, end) == end && document.type == JsonValue::Type::Object;
+    }
+
+
+    static bool decodeBase64(const char *p, const char *end, std::vector<char> &result)
+    {
+        result.clear();
+        result.reserve((end - p) / 4 * 3);
+
+        uint32_t bits = 0;
+        int bit_count = 0;
+        for (; p < end && *p != '='; ++p)
+        {
+            char c = *p;
+            uint32_t digit;
+            if (c >= 'A' && c <= 'Z')
+                digit = c - 'A';
+            else if (c >= 'a' && c <= 'z')
+                digit = c - 'a' + 26;
+            else if (c >= '0' && c <= '9')
+                digit = c - '0' + 52;
+            else if (c == '+')
+                digit = 62;
+            else if (c == '/')
+                digit = 63;
+            else
+                return false;
+
+            bits = (bits << 6) | digit;
+            bit_count += 6;
+            if (bit_count >= 8)
+            {
+                bit_count -= 8;
+                result.push_back(static_cast<char>((bits >> bit_count) & 0xFF));
+            }
+        }
+
+        return true;
+    }
+
+
+    /*
+     * Undoes the percent encoding of uris, i.e. %20 for spaces in file names.
+     */
+    static std::string decodeUri(const std::string &uri)
+    {
+        std::string result;
+        result.reserve(uri.size());
+
+        for (std::size_t i = 0; i < uri.size(); ++i)
+        {
+            int high = (uri[i] == '%' && i + 2 < uri.size()) ? parseHexDigit(uri[i + 1]) : -1;
+            int low = (high >= 0) ? parseHexDigit(uri[i + 2]) : -1;
+            if (low >= 0)
+            {
+                result += static_cast<char>((high << 4) | low);
+                i += 2;
+            }
+            else
+                result += uri[i];
+        }
+
+        return result;
+    }
+
+
+    static bool isDataUri(const std::string &uri)
+    {
+        return uri.compare(0, 5, "data:") == 0;
+    }
+
+
+    /*
+     * Decodes a base64 data uri into result. Returns false for any other encoding.
+     */
+    static bool decodeDataUri(const std::string &uri, std::vector<char> &result)
+    {
+        std::size_t comma = uri.find(";base64,");
+        if (comma == std::string::npos)
+            return false;
+
+        const char *begin = uri.data() + comma + 8;
+        return decodeBase64(begin, uri.data() + uri.size(), result);
+    }
+
+
+    static uint32_t getComponentSize(uint32_t component_type)
+    {
+        switch (component_type)
+        {
+        case component_byte:
+        case component_unsigned_byte:
+            return 1;
+        case component_short:
+        case component_unsigned_short:
+            return 2;
+        case component_unsigned_int:
+        case component_float:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+
+    static uint32_t getComponentCount(const std::string &type)
+    {
+        if (type == "SCALAR")
+            return 1;
+        if (type == "VEC2")
+            return 2;
+        if (type == "VEC3")
+            return 3;
+        if (type == "VEC4" || type == "MAT2")
+            return 4;
+        if (type == "MAT3")
+            return 9;
+        if (type == "MAT4")
+            return 16;
+        return 0;
+    }
+
+
+    // glTF requires offsets to be multiples of the component size, but not every exporter keeps to it
+    static bool isAligned(const char *data, std::size_t alignment)
+    {
+        return reinterpret_cast<uintptr_t>(data) % alignment == 0;
+    }
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////// Public
+	GltfImporter::GltfImporter()
+	{
+	}
+
+
+	GltfImporter::~GltfImporter()
+	{
+	}
+
+
+    bool GltfImporter::load(const std::string &path, const std::string &name, std::string &error)
+    {
+        if (!_file.create(path + name))
+        {
+            error = "Failed to open " + path + name;
+            return false;
+        }
+
+        const char *data = _file.getData();
+        const char *json_data = data;
+        std::size_t json_size = _file.getSize();
+        const char *glb_data = nullptr;
+        std::size_t glb_size = 0;
+        bool success = true;
+
+        uint32_t header[3] = { 0, 0, 0 };
+        if (_file.getSize() >= sizeof(header))
+            std::memcpy(header, data, sizeof(header));
+
+        // binary container: a 12 byte header followed by chunks, each with an 8 byte header of its own
+        if (header[0] == glb_magic)
+        {
+            std::size_t file_size = std::min<std::size_t>(header[2], _file.getSize());
+            std::size_t offset = sizeof(header);
+            json_data = nullptr;
+
+            if (header[1] != 2)
+            {
+                error = "Unsupported glb version " + std::to_string(header[1]);
+                success = false;
+            }
+
+            while (success && offset + 8 <= file_size)
+            {
+                uint32_t chunk[2];
+                std::memcpy(chunk, data + offset, sizeof(chunk));
+                offset += sizeof(chunk);
+
+                if (chunk[0] > file_size - offset)
+                {
+                    error = "Truncated glb chunk";
+                    success = false;
+                    break;
+                }
+
+                if (chunk[1] == glb_json_chunk && !json_data)
+                {
+                    json_data = data + offset;
+                    json_size = chunk[0];
+                }
+                else if (chunk[1] == glb_binary_chunk && !glb_data)
+                {
+                    glb_data = data + offset;
+                    glb_size = chunk[0];
+                }
+
+                // chunks are padded to 4 bytes
+                offset += std::min<std::size_t>((chunk[0] + 3ull) & ~3ull, file_size - offset);
+            }
+
+            if (success && !json_data)
+            {
+                error = "glb file without a JSON chunk";
+                success = false;
+            }
+        }
+
+        JsonValue document;
+        if (success && !parseJson(json_data, json_size, document))
+        {
+            error = "Invalid JSON";
+            success = false;
+        }
+
+        if (success && document["asset"]["version"].string.compare(0, 2, "2.") != 0)
+        {
+            error = "Only glTF 2.0 is supported";
+            success = false;
+        }
+
+        success = success && loadBuffers(document, path, glb_data, glb_size, error) && loadMaterials(document, error);
+
+        if (success)
+        {
+            const JsonValue &scenes = document["scenes"];
+            if (scenes.size() > 0)
+            {
+                std::size_t scene = document["scene"].asSize(0);
+                if (scene < scenes.size())
+                {
+                    const JsonValue &nodes = scenes[scene]["nodes"];
+                    for (std::size_t i = 0; success && i < nodes.size(); ++i)
+                        success = loadNode(document, nodes[i].asInt(-1), glm::mat4(1.0f), 0, error);
+                }
+                else
+                {
+                    error = "Invalid default scene " + std::to_string(scene);
+                    success = false;
+                }
+            }
+            else
+            {
+                // nothing places the meshes, so they are all loaded where they are
+                const JsonValue &meshes = document["meshes"];
+                for (std::size_t i = 0; success && i < meshes.size(); ++i)
+                {
+                    const JsonValue &mesh_primitives = meshes[i]["primitives"];
+                    std::string mesh_name = meshes[i]["name"].string.empty() ? "mesh_" + std::to_string(i) : meshes[i]["name"].string;
+                    for (std::size_t j = 0; success && j < mesh_primitives.size(); ++j)
+                        success = loadPrimitive(mesh_primitives[j], (mesh_primitives.size() > 1) ? mesh_name + "_" + std::to_string(j) : mesh_name,
+                                                glm::mat4(1.0f), error);
+                }
+            }
+        }
+
+        if (!success)
+        {
+            error = path + name + ": " + error;
+            shutDown();
+            return false;
+        }
+
+        // the storage only stops moving once every primitive is in place
+        for (auto &primitive : primitives)
+        {
+            if (!primitive.vertices)
+                primitive.vertices = primitive.vertex_storage.data();
+            if (!primitive.indices)
+                primitive.indices = primitive.index_storage.data();
+        }
+
+        return true;
+    }
+
+
+	void GltfImporter::shutDown()
+	{
+        _file.shutDown();
+        for (auto &file : _buffer_files)
+            file.shutDown();
+
+        _buffer_files.clear();
+        _decoded_buffers.clear();
+        _buffers.clear();
+        _buffer_views.clear();
+        _accessors.clear();
+
+        primitives.clear();
+        materials.clear();
+        images.clear();
+        mapped_vertex_count = 0;
+	}
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////// Private
+    bool GltfImporter::loadBuffers(const JsonValue &document, const std::string &path, const char *glb_data, std::size_t glb_size,
+                                   std::string &error)
+    {
+        const JsonValue &buffers = document["buffers"];
+        _buffer_files.resize(buffers.size());
+        _decoded_buffers.resize(buffers.size());
+        _buffers.resize(buffers.size());
+
+        for (std::size_t i = 0; i < buffers.size(); ++i)
+        {
+            const JsonValue &uri = buffers[i]["uri"];
+            BufferView &buffer = _buffers[i];
+
+            if (uri.type != JsonValue::Type::String)
+            {
+                // only the first buffer of a glb file may leave out its uri. it is the BIN chunk.
+                if (i != 0 || !glb_data)
+                {
+                    error = "Buffer " + std::to_string(i) + " has no data";
+                    return false;
+                }
+
+                buffer.data = glb_data;
+                buffer.size = glb_size;
+            }
+            else if (isDataUri(uri.string))
+            {
+                if (!decodeDataUri(uri.string, _decoded_buffers[i]))
+                {
+                    error = "Buffer " + std::to_string(i) + " is a data uri that isn't base64";
+                    return false;
+                }
+
+                buffer.data = _decoded_buffers[i].data();
+                buffer.size = _decoded_buffers[i].size();
+            }
+            else
+            {
+                std::string buffer_path = path + decodeUri(uri.string);
+                if (!_buffer_files[i].create(buffer_path))
+                {
+                    error = "Buffer not found: " + buffer_path;
+                    return false;
+                }
+
+                buffer.data = _buffer_files[i].getData();
+                buffer.size = _buffer_files[i].getSize();
+            }
+
+            // the BIN chunk may be padded past the length of the buffer
+            std::size_t byte_length = buffers[i]["byteLength"].asSize(0);
+            if (buffer.size < byte_length)
+            {
+                error = "Buffer " + std::to_string(i) + " is shorter than its byteLength";
+                return false;
+            }
+            buffer.size = byte_length;
+        }
+
+        const JsonValue &buffer_views = document["bufferViews"];
+        _buffer_views.resize(buffer_views.size());
+        for (std::size_t i = 0; i < buffer_views.size(); ++i)
+        {
+            const JsonValue &view = buffer_views[i];
+            std::size_t buffer = view["buffer"].asSize(_buffers.size());
+            std::size_t offset = view["byteOffset"].asSize(0);
+            std::size_t length = view["byteLength"].asSize(0);
+
+            if (buffer >= _buffers.size() || offset > _buffers[buffer].size || length > _buffers[buffer].size - offset)
+            {
+                error = "Buffer view " + std::to_string(i) + " lies outside of its buffer";
+                return false;
+            }
+
+            _buffer_views[i].data = _buffers[buffer].data + offset;
+            _buffer_views[i].size = length;
+            _buffer_views[i].stride = static_cast<uint32_t>(view["byteStride"].asSize(0));
+        }
+
+        const JsonValue &accessors = document["accessors"];
+        _accessors.resize(accessors.size());
+        for (std::size_t i = 0; i < accessors.size(); ++i)
+        {
+            const JsonValue &a = accessors[i];
+            Accessor &accessor = _accessors[i];
+
+            accessor.buffer_view = a["bufferView"].asInt(-1);
+            accessor.offset = a["byteOffset"].asSize(0);
+            accessor.component_type = static_cast<uint32_t>(a["componentType"].asSize(0));
+            accessor.component_count = getComponentCount(a["type"].string);
+            accessor.count = static_cast<uint32_t>(std::min<std::size_t>(a["count"].asSize(0), UINT32_MAX));
+            accessor.normalized = a["normalized"].boolean;
+
+            const JsonValue &min = a["min"];
+            const JsonValue &max = a["max"];
+            accessor.has_bounds = accessor.component_count == 3 && min.size() == 3 && max.size() == 3;
+            if (accessor.has_bounds)
+            {
+                accessor.min = glm::vec3(min[0].asFloat(0.0f), min[1].asFloat(0.0f), min[2].asFloat(0.0f));
+                accessor.max = glm::vec3(max[0].asFloat(0.0f), max[1].asFloat(0.0f), max[2].asFloat(0.0f));
+            }
+
+            uint32_t element_size = getComponentSize(accessor.component_type) * accessor.component_count;
+            if (element_size == 0)
+            {
+                error = "Accessor " + std::to_string(i) + " has an unknown type";
+                return false;
+            }
+
+            // accessors without a buffer view are all zeros. none of the ones read here may be.
+            if (accessor.buffer_view < 0 || accessor.buffer_view >= static_cast<int>(_buffer_views.size()))
+            {
+                accessor.buffer_view = -1;
+                continue;
+            }
+
+            const BufferView &view = _buffer_views[accessor.buffer_view];
+            accessor.stride = view.stride ? view.stride : element_size;
+
+            uint64_t required_size = (accessor.count == 0) ? 0 : static_cast<uint64_t>(accessor.stride) * (accessor.count - 1) + element_size;
+            if (accessor.offset > view.size || required_size > view.size - accessor.offset)
+            {
+                error = "Accessor " + std::to_string(i) + " lies outside of its buffer view";
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+
+    bool GltfImporter::loadMaterials(const JsonValue &document, std::string &error)
+    {
+        const JsonValue &json_images = document["images"];
+        images.resize(json_images.size());
+        for (std::size_t i = 0; i < json_images.size(); ++i)
+        {
+            const JsonValue &image = json_images[i];
+            const JsonValue &uri = image["uri"];
+
+            if (uri.type == JsonValue::Type::String && isDataUri(uri.string))
+            {
+                _decoded_buffers.emplace_back();
+                if (!decodeDataUri(uri.string, _decoded_buffers.back()))
+                {
+                    error = "Image " + std::to_string(i) + " is a data uri that isn't base64";
+                    return false;
+                }
+
+                images[i].data = _decoded_buffers.back().data();
+                images[i].size = _decoded_buffers.back().size();
+            }
+            else if (uri.type == JsonValue::Type::String)
+                images[i].uri = decodeUri(uri.string);
+            else
+            {
+                std::size_t buffer_view = image["bufferView"].asSize(_buffer_views.size());
+                if (buffer_view >= _buffer_views.size())
+                {
+                    error = "Image " + std::to_string(i) + " has no data";
+                    return false;
+                }
+
+                images[i].data = _buffer_views[buffer_view].data;
+                images[i].size = _buffer_views[buffer_view].size;
+            }
+        }
+
+        // materials reference textures, which only add a sampler to an image. the engine picks its own sampler.
+        const JsonValue &textures = document["textures"];
+        std::vector<int> texture_images(textures.size());
+        for (std::size_t i = 0; i < textures.size(); ++i)
+        {
+            int image = textures[i]["source"].asInt(-1);
+            texture_images[i] = (image >= 0 && image < static_cast<int>(images.size())) ? image : -1;
+        }
+
+        auto getImage = [&texture_images](const JsonValue &texture_info) {
+            int texture = texture_info["index"].asInt(-1);
+            return (texture >= 0 && texture < static_cast<int>(texture_images.size())) ? texture_images[texture] : -1;
+        };
+
+        const JsonValue &json_materials = document["materials"];
+        materials.resize(json_materials.size());
+        for (std::size_t i = 0; i < json_materials.size(); ++i)
+        {
+            const JsonValue &m = json_materials[i];
+            const JsonValue &pbr = m["pbrMetallicRoughness"];
+            GltfMaterial &material = materials[i];
+
+            material.name = m["name"].string;
+
+            const JsonValue &base_color = pbr["baseColorFactor"];
+            for (std::size_t c = 0; c < 4 && c < base_color.size(); ++c)
+                material.base_color_factor[c] = base_color[c].asFloat(1.0f);
+
+            material.metallic_factor = pbr["metallicFactor"].asFloat(1.0f);
+            material.roughness_factor = pbr["roughnessFactor"].asFloat(1.0f);
+
+            const JsonValue &emissive = m["emissiveFactor"];
+            for (std::size_t c = 0; c < 3 && c < emissive.size(); ++c)
+                material.emissive_factor[c] = emissive[c].asFloat(0.0f);
+
+            material.base_color_texture = getImage(pbr["baseColorTexture"]);
+            material.metallic_roughness_texture = getImage(pbr["metallicRoughnessTexture"]);
+            material.normal_texture = getImage(m["normalTexture"]);
+            material.occlusion_texture = getImage(m["occlusionTexture"]);
+            material.emissive_texture = getImage(m["emissiveTexture"]);
+        }
+
+        return true;
+    }
+
+
+    bool GltfImporter::loadNode(const JsonValue &document, int node_index, const glm::mat4 &parent_transform, int depth, std::string &error)
+    {
+        const JsonValue &nodes = document["nodes"];
+        if (node_index < 0 || node_index >= static_cast<int>(nodes.size()) || depth > max_depth)
+        {
+            error = "Invalid node " + std::to_string(node_index);
+            return false;
+        }
+
+        const JsonValue &node = nodes[node_index];
+        glm::mat4 transform(1.0f);
+
+        // both are column major
+        const JsonValue &matrix = node["matrix"];
+        if (matrix.size() == 16)
+        {
+            for (int i = 0; i < 16; ++i)
+                transform[i / 4][i % 4] = matrix[i].asFloat(0.0f);
+        }
+        else
+        {
+            const JsonValue &t = node["translation"];
+            const JsonValue &r = node["rotation"];
+            const JsonValue &s = node["scale"];
+
+            if (t.size() == 3)
+                transform = glm::translate(transform, glm::vec3(t[0].asFloat(0.0f), t[1].asFloat(0.0f), t[2].asFloat(0.0f)));
+            if (r.size() == 4)
+                transform = transform * glm::mat4_cast(glm::quat(r[3].asFloat(1.0f), r[0].asFloat(0.0f), r[1].asFloat(0.0f), r[2].asFloat(0.0f)));
+            if (s.size() == 3)
+                transform = glm::scale(transform, glm::vec3(s[0].asFloat(1.0f), s[1].asFloat(1.0f), s[2].asFloat(1.0f)));
+        }
+
+        transform = parent_transform * transform;
+
+        int mesh = node["mesh"].asInt(-1);
+        if (mesh >= 0)
+        {
+            const JsonValue &meshes = document["meshes"];
+            if (mesh >= static_cast<int>(meshes.size()))
+            {
+                error = "Node " + std::to_string(node_index) + " references invalid mesh " + std::to_string(mesh);
+                return false;
+            }
+
+            const JsonValue &mesh_primitives = meshes[mesh]["primitives"];
+            std::string mesh_name = meshes[mesh]["name"].string.empty() ? "mesh_" + std::to_string(mesh) : meshes[mesh]["name"].string;
+            for (std::size_t i = 0; i < mesh_primitives.size(); ++i)
+                if (!loadPrimitive(mesh_primitives[i], (mesh_primitives.size() > 1) ? mesh_name + "_" + std::to_string(i) : mesh_name,
+                                   transform, error))
+                    return false;
+        }
+
+        const JsonValue &children = node["children"];
+        for (std::size_t i = 0; i < children.size(); ++i)
+            if (!loadNode(document, children[i].asInt(-1), transform, depth + 1, error))
+                return false;
+
+        return true;
+    }
+
+
+    bool GltfImporter::loadPrimitive(const JsonValue &primitive, const std::string &name, const glm::mat4 &transform, std::string &error)
+    {
+        // points and lines aren't drawn by any material template
+        if (primitive["mode"].asInt(mode_triangles) != mode_triangles)
+            return true;
+
+        const JsonValue &attributes = primitive["attributes"];
+        int position_index = attributes["POSITION"].asInt(-1);
+        int normal_index = attributes["NORMAL"].asInt(-1);
+        int texcoord_index = attributes["TEXCOORD_0"].asInt(-1);
+        int index_index = primitive["indices"].asInt(-1);
+
+        auto isReadable = [this](int accessor) {
+            return accessor >= 0 && accessor < static_cast<int>(_accessors.size()) && _accessors[accessor].buffer_view >= 0;
+        };
+
+        if (!isReadable(position_index) || (normal_index >= 0 && !isReadable(normal_index)) ||
+            (texcoord_index >= 0 && !isReadable(texcoord_index)) || (index_index >= 0 && !isReadable(index_index)))
+        {
+            error = name + " references an invalid accessor";
+            return false;
+        }
+
+        const Accessor &positions = _accessors[position_index];
+        const Accessor *normals = (normal_index >= 0) ? &_accessors[normal_index] : nullptr;
+        const Accessor *texcoords = (texcoord_index >= 0) ? &_accessors[texcoord_index] : nullptr;
+
+        bool valid_texcoords = !texcoords || (texcoords->component_count == 2 && (texcoords->component_type == component_float ||
+                               (texcoords->normalized && (texcoords->component_type == component_unsigned_byte ||
+                                                          texcoords->component_type == component_unsigned_short))));
+
+        if (positions.component_type != component_float || positions.component_count != 3 ||
+            (normals && (normals->component_type != component_float || normals->component_count != 3)) || !valid_texcoords)
+        {
+            error = name + " has vertex attributes of an unsupported type";
+            return false;
+        }
+
+        if ((normals && normals->count != positions.count) || (texcoords && texcoords->count != positions.count))
+        {
+            error = name + " has vertex attributes of different lengths";
+            return false;
+        }
+
+        if (positions.count == 0)
+            return true;
+
+        GltfPrimitive result;
+        result.name = name;
+        result.vertex_count = positions.count;
+
+        int material_id = primitive["material"].asInt(-1);
+        result.material_id = (material_id < static_cast<int>(materials.size())) ? material_id : -1;
+
+        // interleaved exactly like Vertex, so the buffer view can be uploaded as it is
+        bool identity = (transform == glm::mat4(1.0f));
+        bool mirrored = !identity && glm::determinant(glm::mat3(transform)) < 0.0f;
+        if (identity && normals && texcoords && texcoords->component_type == component_float &&
+            normals->buffer_view == positions.buffer_view && texcoords->buffer_view == positions.buffer_view &&
+            positions.stride == sizeof(Vertex) && normals->offset == positions.offset + offsetof(Vertex, normal) &&
+            texcoords->offset == positions.offset + offsetof(Vertex, texCoord) &&
+            isAligned(getElement(positions, 0), alignof(Vertex)))
+        {
+            result.vertices = reinterpret_cast<const Vertex *>(getElement(positions, 0));
+            mapped_vertex_count += result.vertex_count;
+        }
+        else
+        {
+            result.vertex_storage.resize(result.vertex_count);
+            for (uint32_t i = 0; i < result.vertex_count; ++i)
+            {
+                Vertex &vertex = result.vertex_storage[i];
+                readFloats(positions, i, &vertex.position.x);
+
+                if (normals)
+                    readFloats(*normals, i, &vertex.normal.x);
+                else
+                    vertex.normal = glm::vec3(0.0f);
+
+                if (texcoords)
+                    readFloats(*texcoords, i, &vertex.texCoord.x);
+                else
+                    vertex.texCoord = glm::vec2(0.0f);
+            }
+
+            if (!identity)
+            {
+                glm::mat3 normal_transform = glm::transpose(glm::inverse(glm::mat3(transform)));
+                for (auto &vertex : result.vertex_storage)
+                {
+                    vertex.position = glm::vec3(transform * glm::vec4(vertex.position, 1.0f));
+
+                    glm::vec3 normal = normal_transform * vertex.normal;
+                    float length = glm::length(normal);
+                    vertex.normal = (length > 0.0f) ? normal / length : normal;
+                }
+            }
+        }
+
+        if (index_index >= 0)
+        {
+            const Accessor &indices = _accessors[index_index];
+            uint32_t component_size = getComponentSize(indices.component_type);
+            result.index_count = indices.count;
+
+            if (indices.component_count != 1 || (indices.component_type != component_unsigned_int &&
+                indices.component_type != component_unsigned_short && indices.component_type != component_unsigned_byte))
+            {
+                error = name + " has indices of an unsupported type";
+                return false;
+            }
+
+            if (!mirrored && indices.component_type == component_unsigned_int && indices.stride == sizeof(uint32_t) &&
+                isAligned(getElement(indices, 0), alignof(uint32_t)))
+                result.indices = reinterpret_cast<const uint32_t *>(getElement(indices, 0));
+            else
+            {
+                // narrower indices are widened, since the shared geometry buffer only holds 32 bit ones
+                result.index_storage.resize(indices.count);
+                for (uint32_t i = 0; i < indices.count; ++i)
+                {
+                    const char *element = getElement(indices, i);
+                    if (component_size == 1)
+                        result.index_storage[i] = static_cast<uint8_t>(*element);
+                    else if (component_size == 2)
+                    {
+                        uint16_t index;
+                        std::memcpy(&index, element, sizeof(index));
+                        result.index_storage[i] = index;
+                    }
+                    else
+                        std::memcpy(&result.index_storage[i], element, sizeof(uint32_t));
+                }
+            }
+
+            // an index past the vertices would read outside this primitive once it sits in the shared buffer
+            const uint32_t *checked = result.indices ? result.indices : result.index_storage.data();
+            for (uint32_t i = 0; i < result.index_count; ++i)
+            {
+                if (checked[i] >= result.vertex_count)
+                {
+                    error = name + " has indices past its vertices";
+                    return false;
+                }
+            }
+        }
+        else
+        {
+            // every three vertices form a triangle of their own
+            result.index_count = result.vertex_count;
+            result.index_storage.resize(result.vertex_count);
+            for (uint32_t i = 0; i < result.vertex_count; ++i)
+                result.index_storage[i] = i;
+        }
+
+        // a mirroring transform flips the winding of every triangle, so it is flipped back to keep them front facing
+        if (mirrored)
+        {
+            for (uint32_t i = 0; i + 2 < result.index_count; i += 3)
+                std::swap(result.index_storage[i + 1], result.index_storage[i + 2]);
+        }
+
+        // exporters have to write the bounds of positions, so the vertices don't need another pass
+        AABB &bounding_box = result.bounding_box;
+        if (positions.has_bounds)
+        {
+            bounding_box.min = positions.min;
+            bounding_box.max = positions.max;
+            if (!identity)
+                bounding_box = bounding_box.transform(transform);
+        }
+        else
+        {
+            const Vertex *vertices = result.vertices ? result.vertices : result.vertex_storage.data();
+            for (uint32_t i = 0; i < result.vertex_count; ++i)
+                bounding_box.expand(vertices[i].position);
+        }
+
+        // sphere around the box center. looser than one fit to the vertices, but free.
+        result.bounding_sphere.center = bounding_box.getCenter();
+        result.bounding_sphere.radius = glm::length(bounding_box.getExtents());
+
+        primitives.push_back(std::move(result));
+        return true;
+    }
+
+
+    const char* GltfImporter::getElement(const Accessor &accessor, uint32_t i) const
+    {
+        return _buffer_views[accessor.buffer_view].data + accessor.offset + static_cast<std::size_t>(accessor.stride) * i;
+    }
+
+
+    void GltfImporter::readFloats(const Accessor &accessor, uint32_t i, float *value) const
+    {
+        const char *element = getElement(accessor, i);
+        for (uint32_t c = 0; c < accessor.component_count; ++c)
+        {
+            if (accessor.component_type == component_float)
+                std::memcpy(&value[c], element + c * sizeof(float), sizeof(float));
+            else if (accessor.component_type == component_unsigned_short)
+            {
+                uint16_t component;
+                std::memcpy(&component, element + c * sizeof(uint16_t), sizeof(uint16_t));
+                value[c] = component / 65535.0f;
+            }
+            else
+                value[c] = static_cast<uint8_t>(element[c]) / 255.0f;
+        }
+    }
+}
@@ -0,0 +1,144 @@
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include <cstring>
+
+#include "MappedFile.h"
+
+namespace vv
+{
+    static uint64_t hashBytes(const char *data, std::size_t size)
+    {
+        // a word at a time, so it keeps up with the disk
+        const uint64_t k0 = 0x9E3779B97F4A7C15ull;
+        const uint64_t k1 = 0xC2B2AE3D27D4EB4Full;
+        uint64_t hash = static_cast<uint64_t>(size) * k0;
+
+        std::size_t i = 0;
+        for (; i + 8 <= size; i += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            hash ^= word * k1;
+            hash = ((hash << 31) | (hash >> 33)) * k0;
+        }
+
+        uint64_t tail = 0;
+        if (i < size)
+            std::memcpy(&tail, data + i, size - i);
+        hash ^= tail * k1;
+        hash ^= hash >> 29;
+        hash *= k0;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////// Public
+	MappedFile::MappedFile()
+	{
+	}
+
+
+	MappedFile::~MappedFile()
+	{
+	}
+
+
+	bool MappedFile::create(const std::string &path)
+	{
+#ifdef _WIN32
+        _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (_file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size = {};
+        GetFileSizeEx(_file, &size);
+        _size = static_cast<std::size_t>(size.QuadPart);
+
+        // a zero sized mapping can't be created
+        if (_size == 0)
+            return true;
+
+        _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (_mapping)
+            _data = static_cast<const char *>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+        _file = open(path.c_str(), O_RDONLY);
+        if (_file < 0)
+            return false;
+
+        struct stat file_stats;
+        fstat(_file, &file_stats);
+        _size = static_cast<std::size_t>(file_stats.st_size);
+
+        if (_size == 0)
+            return true;
+
+        void *data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _file, 0);
+        if (data != MAP_FAILED)
+        {
+            _data = static_cast<const char *>(data);
+            madvise(data, _size, MADV_SEQUENTIAL); // only a hint. read ahead aggressively.
+        }
+#endif
+
+        if (!_data)
+        {
+            shutDown();
+            return false;
+        }
+
+        return true;
+	}
+
+
+	void MappedFile::shutDown()
+	{
+#ifdef _WIN32
+        if (_data) UnmapViewOfFile(_data);
+        if (_mapping) CloseHandle(_mapping);
+        if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+
+        _mapping = nullptr;
+        _file = INVALID_HANDLE_VALUE;
+#else
+        if (_data) munmap(const_cast<char *>(_data), _size);
+        if (_file >= 0) close(_file);
+
+        _file = -1;
+#endif
+
+        _data = nullptr;
+        _size = 0;
+	}
+
+
+    const char* MappedFile::getData() const
+    {
+        return _data;
+    }
+
+
+    std::size_t MappedFile::getSize() const
+    {
+        return _size;
+    }
+
+
+    bool MappedFile::hashFile(const std::string &path, uint64_t &hash)
+    {
+        MappedFile file;
+        if (!file.create(path))
+            return false;
+
+        hash = hashBytes(file.getData(), file.getSize());
+        file.shutDown();
+        return true;
+    }
+}
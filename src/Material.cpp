@@ -1,4 +1,6 @@
 
+#include <cstddef>
+
 #include "Material.h"
 
 namespace vv
@@ -105,13 +107,16 @@ namespace vv
     }
 
 
-    void Material::bindDescriptorSets(VkCommandBuffer command_buffer) const
+    void Material::bind(VulkanCommandEncoder &encoder) const
     {
-        if (material_template->material_descriptor_set_layout)
+        if (material_template->uses_bindless_materials)
         {
-            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, material_template->pipeline_layout, 1,
-                1, &_descriptor_set, 0, nullptr);
+            const uint32_t offset = offsetof(DrawConstants, material_index);
+            encoder.pushConstants(material_template->pipeline_layout, material_template->shader->getPushConstantStages(offset, sizeof(uint32_t)),
+                                  offset, sizeof(uint32_t), &material_index);
         }
+        else if (material_template->material_descriptor_set_layout)
+            encoder.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, material_template->pipeline_layout, 1, 1, &_descriptor_set);
     }
 
 
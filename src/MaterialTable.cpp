@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include "MaterialTable.h"
+#include "Settings.h"
+
+namespace vv
+{
+	///////////////////////////////////////////////////////////////////////////////////////////// Public
+	MaterialTable::MaterialTable()
+	{
+	}
+
+
+	MaterialTable::~MaterialTable()
+	{
+	}
+
+
+	void MaterialTable::create(VulkanDevice *device)
+	{
+        VV_ASSERT(device->descriptor_indexing, "ERROR: bindless materials need descriptor indexing");
+        _device = device;
+        _texture_capacity = std::min(Settings::inst()->getMaxBindlessTextures(), device->max_bindless_sampled_images);
+        _material_capacity = Settings::inst()->getMaxBindlessMaterials();
+
+        _material_buffer = new VulkanBuffer();
+        _material_buffer->create(_device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, sizeof(MaterialData) * _material_capacity);
+
+        // the array is filled as textures are loaded, while command buffers using the set may be pending. unused
+        // elements are never read, so they don't need valid descriptors.
+        std::array<VkDescriptorSetLayoutBinding, 2> bindings = {};
+        bindings[0].binding = 0;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[0].descriptorCount = 1;
+        bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        bindings[1].binding = 1;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[1].descriptorCount = _texture_capacity;
+        bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        // a variable count binding has to be the last one of its layout
+        std::array<VkDescriptorBindingFlagsEXT, 2> binding_flags = {
+            0,
+            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+            VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT_EXT
+        };
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfoEXT binding_flags_create_info = {};
+        binding_flags_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+        binding_flags_create_info.bindingCount = static_cast<uint32_t>(binding_flags.size());
+        binding_flags_create_info.pBindingFlags = binding_flags.data();
+
+        VkDescriptorSetLayoutCreateInfo layout_create_info = {};
+        layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layout_create_info.pNext = &binding_flags_create_info;
+        layout_create_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+        layout_create_info.bindingCount = static_cast<uint32_t>(bindings.size());
+        layout_create_info.pBindings = bindings.data();
+        VV_CHECK_SUCCESS(vkCreateDescriptorSetLayout(_device->logical_device, &layout_create_info, nullptr, &descriptor_set_layout));
+
+        std::array<VkDescriptorPoolSize, 2> pool_sizes = {};
+        pool_sizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        pool_sizes[0].descriptorCount = 1;
+        pool_sizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        pool_sizes[1].descriptorCount = _texture_capacity;
+
+        VkDescriptorPoolCreateInfo pool_create_info = {};
+        pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_create_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+        pool_create_info.maxSets = 1;
+        pool_create_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+        pool_create_info.pPoolSizes = pool_sizes.data();
+        VV_CHECK_SUCCESS(vkCreateDescriptorPool(_device->logical_device, &pool_create_info, nullptr, &_descriptor_pool));
+
+        VkDescriptorSetVariableDescriptorCountAllocateInfoEXT variable_count_info = {};
+        variable_count_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO_EXT;
+        variable_count_info.descriptorSetCount = 1;
+        variable_count_info.pDescriptorCounts = &_texture_capacity;
+
+        VkDescriptorSetAllocateInfo allocate_info = {};
+        allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocate_info.pNext = &variable_count_info;
+        allocate_info.descriptorPool = _descriptor_pool;
+        allocate_info.descriptorSetCount = 1;
+        allocate_info.pSetLayouts = &descriptor_set_layout;
+        VV_CHECK_SUCCESS(vkAllocateDescriptorSets(_device->logical_device, &allocate_info, &_descriptor_set));
+
+        VkDescriptorBufferInfo buffer_info = {};
+        buffer_info.buffer = _material_buffer->buffer;
+        buffer_info.offset = 0;
+        buffer_info.range = VK_WHOLE_SIZE;
+
+        VkWriteDescriptorSet write_set = {};
+        write_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write_set.dstSet = _descriptor_set;
+        write_set.dstBinding = 0;
+        write_set.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write_set.descriptorCount = 1;
+        write_set.pBufferInfo = &buffer_info;
+        vkUpdateDescriptorSets(_device->logical_device, 1, &write_set, 0, nullptr);
+	}
+
+
+	void MaterialTable::shutDown()
+	{
+        _material_buffer->shutDown(); delete _material_buffer;
+        vkDestroyDescriptorPool(_device->logical_device, _descriptor_pool, nullptr);
+        vkDestroyDescriptorSetLayout(_device->logical_device, descriptor_set_layout, nullptr);
+	}
+
+
+    uint32_t MaterialTable::addTexture(SampledTexture *texture)
+    {
+        auto it = _texture_indices.find(texture);
+        if (it != _texture_indices.end())
+            return it->second;
+
+        uint32_t index = static_cast<uint32_t>(_texture_indices.size());
+        if (index >= _texture_capacity)
+            throw std::runtime_error("Bindless texture array full. Increase Settings' max bindless textures.");
+
+        _texture_indices[texture] = index;
+
+        VkDescriptorImageInfo image_info = {};
+        image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        image_info.imageView = texture->image_view->image_view;
+        image_info.sampler = texture->sampler->sampler;
+
+        VkWriteDescriptorSet write_set = {};
+        write_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write_set.dstSet = _descriptor_set;
+        write_set.dstBinding = 1;
+        write_set.dstArrayElement = index;
+        write_set.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write_set.descriptorCount = 1;
+        write_set.pImageInfo = &image_info;
+        vkUpdateDescriptorSets(_device->logical_device, 1, &write_set, 0, nullptr);
+
+        return index;
+    }
+
+
+    uint32_t MaterialTable::addMaterial(const MaterialData &data)
+    {
+        if (_material_count >= _material_capacity)
+            throw std::runtime_error("Bindless material buffer full. Increase Settings' max bindless materials.");
+
+        // the upload lands before the next submission. nothing in flight reads this slot yet.
+        uint32_t index = _material_count++;
+        _material_buffer->updateAndTransfer(&data, sizeof(MaterialData), sizeof(MaterialData) * index);
+        return index;
+    }
+
+
+    bool MaterialTable::setTextureIndex(MaterialData &data, const std::string &map_name, uint32_t texture_index)
+    {
+        if (map_name == "albedo_map")
+            data.albedo_map = texture_index;
+        else if (map_name == "normal_map")
+            data.normal_map = texture_index;
+        else if (map_name == "roughness_map")
+            data.roughness_map = texture_index;
+        else if (map_name == "metalness_map")
+            data.metalness_map = texture_index;
+        else if (map_name == "emissiveness_map")
+            data.emissiveness_map = texture_index;
+        else if (map_name == "ambient_occlusion_map")
+            data.ambient_occlusion_map = texture_index;
+        else if (map_name == "ambient_map")
+            data.ambient_map = texture_index;
+        else if (map_name == "diffuse_map")
+            data.diffuse_map = texture_index;
+        else if (map_name == "specular_map")
+            data.specular_map = texture_index;
+        else
+            return false;
+
+        return true;
+    }
+
+
+    void MaterialTable::bind(VulkanCommandEncoder &encoder, VkPipelineLayout pipeline_layout) const
+    {
+        encoder.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 1, 1, &_descriptor_set);
+    }
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////// Private
+}
@@ -1,4 +1,6 @@
 
+#include <utility>
+
 #include "Mesh.h"
 
 namespace vv
@@ -14,39 +16,108 @@ namespace vv
 	}
 
 
-	void Mesh::create(VulkanDevice *device, std::string name, std::vector<Vertex> vertices, std::vector<uint32_t> indices, int material_id)
+	void Mesh::create(GeometryBuffer *geometry_buffer, std::string name, std::vector<Vertex> vertices, std::vector<uint32_t> indices, int material_id,
+                      const AABB &bounding_box, const BoundingSphere &bounding_sphere)
 	{
-        _vertices = vertices;
-        _indices = indices;
+        _vertices = std::move(vertices);
+        _indices = std::move(indices);
+        _has_host_copy = true;
         _name = name;
+        _geometry_buffer = geometry_buffer;
+        _bounding_box = bounding_box;
+        _bounding_sphere = bounding_sphere;
         this->material_id = material_id;
 
-        _vertex_buffer.create(device, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sizeof(_vertices[0]) * _vertices.size());
-		_vertex_buffer.updateAndTransfer(_vertices.data());
+        _range = _geometry_buffer->allocate(_vertices, _indices);
+	}
+
 
-		_index_buffer.create(device, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, sizeof(_indices[0]) * _indices.size());
-		_index_buffer.updateAndTransfer(_indices.data());
+	void Mesh::create(GeometryBuffer *geometry_buffer, std::string name, const Vertex *vertices, uint32_t vertex_count, const uint32_t *indices,
+                      uint32_t index_count, int material_id, const AABB &bounding_box, const BoundingSphere &bounding_sphere)
+	{
+        _has_host_copy = false;
+        _name = name;
+        _geometry_buffer = geometry_buffer;
+        _bounding_box = bounding_box;
+        _bounding_sphere = bounding_sphere;
+        this->material_id = material_id;
+
+        _range = _geometry_buffer->allocate(vertices, vertex_count, indices, index_count);
 	}
 
 
 	void Mesh::shutDown()
 	{
-        _vertex_buffer.shutDown();
-        _index_buffer.shutDown();
+        // the geometry buffer owns the device memory. its ranges are released all at once.
 	}
 
 
-    void Mesh::bindBuffers(VkCommandBuffer command_buffer)
+    void Mesh::bindBuffers(VulkanCommandEncoder &encoder)
+    {
+        _geometry_buffer->bind(encoder, _range.page);
+    }
+
+
+    void Mesh::render(VulkanCommandEncoder &encoder)
     {
-        std::array<VkDeviceSize, 1> offsets = { 0 };
-        vkCmdBindVertexBuffers(command_buffer, 0, 1, &_vertex_buffer.buffer, offsets.data());
-        vkCmdBindIndexBuffer(command_buffer, _index_buffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+        vkCmdDrawIndexed(encoder.command_buffer, _range.index_count, 1, _range.first_index, _range.vertex_offset, 0);
+    }
+
+
+    const GeometryRange& Mesh::getGeometryRange() const
+    {
+        return _range;
+    }
+
+
+    const AABB& Mesh::getBoundingBox() const
+    {
+        return _bounding_box;
+    }
+
+
+    const BoundingSphere& Mesh::getBoundingSphere() const
+    {
+        return _bounding_sphere;
+    }
+
+
+    bool Mesh::hasHostCopy() const
+    {
+        return _has_host_copy;
+    }
+
+
+    const std::vector<Vertex>& Mesh::getVertices() const
+    {
+        VV_ASSERT(_has_host_copy, "Mesh " + _name + " has no host copy of its vertices. Load it with keep_host_geometry.");
+        return _vertices;
+    }
+
+
+    const std::vector<uint32_t>& Mesh::getIndices() const
+    {
+        VV_ASSERT(_has_host_copy, "Mesh " + _name + " has no host copy of its indices. Load it with keep_host_geometry.");
+        return _indices;
+    }
+
+
+    uint64_t Mesh::releaseHostCopy()
+    {
+        uint64_t released = getHostCopySize();
+
+        // swap instead of clear() so the capacity is actually given back
+        std::vector<Vertex>().swap(_vertices);
+        std::vector<uint32_t>().swap(_indices);
+        _has_host_copy = false;
+
+        return released;
     }
 
 
-    void Mesh::render(VkCommandBuffer command_buffer)
+    uint64_t Mesh::getHostCopySize() const
     {
-        vkCmdDrawIndexed(command_buffer, (uint32_t)_indices.size(), 1, 0, 0, 0);
+        return _vertices.capacity() * sizeof(Vertex) + _indices.capacity() * sizeof(uint32_t);
     }
 
 
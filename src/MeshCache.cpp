@@ -0,0 +1,399 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "MeshCache.h"
+
+namespace vv
+{
+    static const char mesh_cache_magic[4] = { 'V', 'V', 'M', 'C' };
+    static const uint32_t mesh_cache_format_version = 1;
+
+    // followed by the sources, materials and submeshes. the geometry starts at data_offset.
+    struct MeshCacheHeader
+    {
+        char magic[4];
+        uint32_t format_version;
+        uint32_t importer_version;
+        uint32_t vertex_size;               // the vertex layout is stored as is, so it has to match the reader's
+        uint64_t vertex_count;
+        uint64_t index_count;
+        uint64_t data_offset;               // 16 byte aligned. the indices follow right after the vertices.
+    };
+
+
+    template<typename T>
+    static void writeValue(std::vector<char> &blob, const T &value)
+    {
+        const char *bytes = reinterpret_cast<const char *>(&value);
+        blob.insert(blob.end(), bytes, bytes + sizeof(T));
+    }
+
+
+    static void writeString(std::vector<char> &blob, const std::string &value)
+    {
+        writeValue(blob, static_cast<uint32_t>(value.size()));
+        blob.insert(blob.end(), value.begin(), value.end());
+    }
+
+
+    template<typename T>
+    static bool readValue(const char *&p, const char *end, T &value)
+    {
+        if (static_cast<std::size_t>(end - p) < sizeof(T))
+            return false;
+
+        std::memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+
+
+    static bool readString(const char *&p, const char *end, std::string &value)
+    {
+        uint32_t length = 0;
+        if (!readValue(p, end, length) || static_cast<std::size_t>(end - p) < length)
+            return false;
+
+        value.assign(p, length);
+        p += length;
+        return true;
+    }
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////// Public
+	MeshCache::MeshCache()
+	{
+	}
+
+
+	MeshCache::~MeshCache()
+	{
+	}
+
+
+    bool MeshCache::create(const std::string &path, const std::string &name, uint32_t importer_version)
+    {
+        if (!_file.create(path + name))
+            return false;
+
+        if (!parse(path, importer_version))
+        {
+            shutDown();
+            return false;
+        }
+
+        _mapped = true;
+        return true;
+    }
+
+
+	void MeshCache::shutDown()
+	{
+        _file.shutDown();
+        _mapped = false;
+        _vertices = nullptr;
+        _indices = nullptr;
+
+        submeshes.clear();
+        materials.clear();
+        sources.clear();
+        vertices.clear();
+        indices.clear();
+	}
+
+
+    bool MeshCache::write(const std::string &path, const std::string &name, uint32_t importer_version) const
+    {
+        std::vector<char> blob;
+
+        writeValue(blob, static_cast<uint32_t>(sources.size()));
+        for (const auto &source : sources)
+        {
+            uint64_t hash = 0;
+            if (!MappedFile::hashFile(path + source, hash))
+                return false;
+
+            writeString(blob, source);
+            writeValue(blob, hash);
+        }
+
+        writeValue(blob, static_cast<uint32_t>(materials.size()));
+        for (const auto &m : materials)
+        {
+            writeString(blob, m.name);
+            writeValue(blob, m.ambient);
+            writeValue(blob, m.diffuse);
+            writeValue(blob, m.specular);
+            writeValue(blob, m.shininess);
+            writeString(blob, m.ambient_texname);
+            writeString(blob, m.diffuse_texname);
+            writeString(blob, m.specular_texname);
+            writeString(blob, m.normal_texname);
+            writeString(blob, m.bump_texname);
+            writeString(blob, m.roughness_texname);
+            writeString(blob, m.metallic_texname);
+            writeString(blob, m.emissive_texname);
+        }
+
+        writeValue(blob, static_cast<uint32_t>(submeshes.size()));
+        for (const auto &s : submeshes)
+        {
+            writeString(blob, s.name);
+            writeValue(blob, static_cast<int32_t>(s.material_id));
+            writeValue(blob, s.first_vertex);
+            writeValue(blob, s.vertex_count);
+            writeValue(blob, s.first_index);
+            writeValue(blob, s.index_count);
+            writeValue(blob, s.bounding_box.min);
+            writeValue(blob, s.bounding_box.max);
+            writeValue(blob, s.bounding_sphere.center);
+            writeValue(blob, s.bounding_sphere.radius);
+        }
+
+        // the mapping is page aligned, so aligning within the file is enough for the geometry to be read in place
+        std::size_t header_size = sizeof(MeshCacheHeader) + blob.size();
+        blob.resize(blob.size() + ((16 - header_size % 16) % 16), 0);
+
+        MeshCacheHeader header = {};
+        std::memcpy(header.magic, mesh_cache_magic, sizeof(header.magic));
+        header.format_version = mesh_cache_format_version;
+        header.importer_version = importer_version;
+        header.vertex_size = sizeof(Vertex);
+        header.vertex_count = vertices.size();
+        header.index_count = indices.size();
+        header.data_offset = sizeof(MeshCacheHeader) + blob.size();
+
+        // written next to the old cache first, so a failed write never leaves a truncated one behind
+        std::string temp_path = path + name + ".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+                return false;
+
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(blob.data(), blob.size());
+            file.write(reinterpret_cast<const char *>(vertices.data()), sizeof(Vertex) * vertices.size());
+            file.write(reinterpret_cast<const char *>(indices.data()), sizeof(uint32_t) * indices.size());
+
+            if (!file.good())
+            {
+                file.close();
+                std::remove(temp_path.c_str());
+                return false;
+            }
+        }
+
+        std::remove((path + name).c_str());
+        return std::rename(temp_path.c_str(), (path + name).c_str()) == 0;
+    }
+
+
+    bool MeshCache::importOBJ(const std::string &path, const std::string &name, ThreadPool *thread_pool, ImportStatistics &statistics,
+                              std::string &error)
+    {
+        ObjImporter importer;
+
+        auto parse_start = std::chrono::high_resolution_clock::now();
+        if (!importer.load(path, name, thread_pool, error))
+            return false;
+
+        std::chrono::duration<double, std::milli> parse_time = std::chrono::high_resolution_clock::now() - parse_start;
+        statistics.parse_time += parse_time.count();
+
+        // everything the result depends on. the cache is rebuilt as soon as one of them changes.
+        sources.push_back(name);
+        sources.insert(sources.end(), importer.material_libraries.begin(), importer.material_libraries.end());
+        materials = std::move(importer.materials);
+
+        // shared by all shapes. corners are deduplicated by their index triple, before any vertex is built.
+        ObjVertexMap vertex_map;
+
+        // parse through all loaded geometry. every shape becomes a submesh.
+		for (const auto& shape : importer.shapes)
+		{
+            MeshCacheSubmesh submesh;
+            submesh.name = shape.name;
+            submesh.material_id = (shape.material_id < 0) ? 0 : shape.material_id;
+            submesh.first_vertex = static_cast<uint32_t>(vertices.size());
+            submesh.first_index = static_cast<uint32_t>(indices.size());
+
+            AABB &bounding_box = submesh.bounding_box;
+            bool missing_normals = false;
+            bool missing_uvs = false;
+
+            auto dedup_start = std::chrono::high_resolution_clock::now();
+            vertex_map.reset(shape.indices.size());
+            indices.reserve(indices.size() + shape.indices.size());
+
+			for (const auto& index : shape.indices)
+			{
+                // indices are relative to the first vertex of the submesh
+                bool inserted = false;
+                uint32_t next_vertex = static_cast<uint32_t>(vertices.size()) - submesh.first_vertex;
+                indices.push_back(vertex_map.findOrInsert(index, next_vertex, inserted));
+                if (!inserted)
+                    continue;
+
+				Vertex vertex = {};
+
+                // Vertices
+				vertex.position = glm::vec3(
+					importer.positions[3 * index.vertex_index + 0],
+					importer.positions[3 * index.vertex_index + 1],
+					importer.positions[3 * index.vertex_index + 2]
+				);
+
+                // Normals
+                if (index.normal_index >= 0)
+                    vertex.normal = glm::vec3(
+                        importer.normals[3 * index.normal_index + 0],
+                        importer.normals[3 * index.normal_index + 1],
+                        importer.normals[3 * index.normal_index + 2]
+                    );
+                else
+                {
+				    vertex.normal = glm::vec3(0.0, 0.0, 1.0);
+                    missing_normals = true;
+                }
+
+                // UVs
+                if (index.texcoord_index >= 0)
+                    vertex.texCoord = glm::vec2(
+                        importer.texcoords[2 * index.texcoord_index + 0],
+                        1.0f - importer.texcoords[2 * index.texcoord_index + 1]
+                    );
+                else
+                {
+                    vertex.texCoord = glm::vec2(0.0f, 0.0f);
+                    missing_uvs = true;
+                }
+
+				vertices.push_back(vertex);
+                bounding_box.expand(vertex.position);
+			}
+
+            submesh.vertex_count = static_cast<uint32_t>(vertices.size()) - submesh.first_vertex;
+            submesh.index_count = static_cast<uint32_t>(indices.size()) - submesh.first_index;
+
+            std::chrono::duration<double, std::milli> dedup_time = std::chrono::high_resolution_clock::now() - dedup_start;
+            statistics.deduplication_time += dedup_time.count();
+            statistics.index_count += submesh.index_count;
+            statistics.unique_vertex_count += submesh.vertex_count;
+
+            if (missing_normals)
+                VV_ALERT("Model does not have normals.");
+            if (missing_uvs)
+                VV_ALERT("Model does not have UV coordinates.");
+
+            // sphere around the box center. slightly looser than a minimal sphere but needs only one more pass.
+            BoundingSphere &bounding_sphere = submesh.bounding_sphere;
+            bounding_sphere.center = (submesh.vertex_count == 0) ? glm::vec3(0.0f) : bounding_box.getCenter();
+            for (uint32_t i = submesh.first_vertex; i < submesh.first_vertex + submesh.vertex_count; ++i)
+                bounding_sphere.radius = std::max(bounding_sphere.radius, glm::length(vertices[i].position - bounding_sphere.center));
+            if (submesh.vertex_count == 0)
+                bounding_box.min = bounding_box.max = glm::vec3(0.0f);
+
+            submeshes.push_back(submesh);
+		}
+
+        return true;
+    }
+
+
+    const Vertex* MeshCache::getVertices() const
+    {
+        return _mapped ? _vertices : vertices.data();
+    }
+
+
+    const uint32_t* MeshCache::getIndices() const
+    {
+        return _mapped ? _indices : indices.data();
+    }
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////// Private
+    bool MeshCache::parse(const std::string &path, uint32_t importer_version)
+    {
+        const char *data = _file.getData();
+        const char *end = data + _file.getSize();
+        const char *p = data;
+
+        MeshCacheHeader header;
+        if (!readValue(p, end, header))
+            return false;
+
+        if (std::memcmp(header.magic, mesh_cache_magic, sizeof(header.magic)) != 0 || header.format_version != mesh_cache_format_version ||
+            header.importer_version != importer_version || header.vertex_size != sizeof(Vertex))
+            return false;
+
+        // every entry takes at least 4 bytes, which keeps a corrupt count from allocating a huge array
+        uint32_t source_count = 0;
+        if (!readValue(p, end, source_count) || source_count > static_cast<std::size_t>(end - p) / 4)
+            return false;
+
+        sources.resize(source_count);
+        for (auto &source : sources)
+        {
+            uint64_t stored_hash = 0, current_hash = 0;
+            if (!readString(p, end, source) || !readValue(p, end, stored_hash))
+                return false;
+
+            // a source that was edited or removed makes the whole cache stale
+            if (!MappedFile::hashFile(path + source, current_hash) || current_hash != stored_hash)
+                return false;
+        }
+
+        uint32_t material_count = 0;
+        if (!readValue(p, end, material_count) || material_count > static_cast<std::size_t>(end - p) / 4)
+            return false;
+
+        materials.resize(material_count);
+        for (auto &m : materials)
+        {
+            if (!readString(p, end, m.name) || !readValue(p, end, m.ambient) || !readValue(p, end, m.diffuse) ||
+                !readValue(p, end, m.specular) || !readValue(p, end, m.shininess) || !readString(p, end, m.ambient_texname) ||
+                !readString(p, end, m.diffuse_texname) || !readString(p, end, m.specular_texname) || !readString(p, end, m.normal_texname) ||
+                !readString(p, end, m.bump_texname) || !readString(p, end, m.roughness_texname) || !readString(p, end, m.metallic_texname) ||
+                !readString(p, end, m.emissive_texname))
+                return false;
+        }
+
+        uint32_t submesh_count = 0;
+        if (!readValue(p, end, submesh_count) || submesh_count > static_cast<std::size_t>(end - p) / 4)
+            return false;
+
+        submeshes.resize(submesh_count);
+        for (auto &s : submeshes)
+        {
+            int32_t material_id = 0;
+            if (!readString(p, end, s.name) || !readValue(p, end, material_id) || !readValue(p, end, s.first_vertex) ||
+                !readValue(p, end, s.vertex_count) || !readValue(p, end, s.first_index) || !readValue(p, end, s.index_count) ||
+                !readValue(p, end, s.bounding_box.min) || !readValue(p, end, s.bounding_box.max) ||
+                !readValue(p, end, s.bounding_sphere.center) || !readValue(p, end, s.bounding_sphere.radius))
+                return false;
+
+            s.material_id = material_id;
+            if (static_cast<uint64_t>(s.first_vertex) + s.vertex_count > header.vertex_count ||
+                static_cast<uint64_t>(s.first_index) + s.index_count > header.index_count)
+                return false;
+        }
+
+        // the geometry itself is never copied here, only checked to be in bounds
+        uint64_t file_size = _file.getSize();
+        if (header.data_offset % 16 != 0 || header.data_offset < static_cast<uint64_t>(p - data) || header.data_offset > file_size)
+            return false;
+
+        uint64_t available = file_size - header.data_offset;
+        if (header.vertex_count > available / sizeof(Vertex) ||
+            header.index_count > (available - header.vertex_count * sizeof(Vertex)) / sizeof(uint32_t))
+            return false;
+
+        _vertices = reinterpret_cast<const Vertex *>(data + header.data_offset);
+        _indices = reinterpret_cast<const uint32_t *>(data + header.data_offset + header.vertex_count * sizeof(Vertex));
+        return true;
+    }
+}
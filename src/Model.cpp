@@ -27,22 +27,17 @@ namespace vv
         _material_id_set = material_id_set;
 
         _model_ubo = { glm::mat4(), glm::mat4() };
-        _model_uniform_buffer = new VulkanBuffer();
-        _model_uniform_buffer->create(device, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(ModelUBO));
 	}
 
 
 	void Model::shutDown()
 	{
-        _model_uniform_buffer->shutDown();
-        delete _model_uniform_buffer;
 	}
 
 
     void Model::updateModelUBO()
     {
         _model_ubo = { _pose, glm::transpose(glm::inverse(_pose)) };
-        _model_uniform_buffer->updateAndTransfer(&_model_ubo);
     }
 
 
@@ -1,10 +1,14 @@
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "tiny_obj_loader.h"
-
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstring>
+#include <utility>
 
 #include "ModelManager.h"
+#include "ObjImporter.h"
+#include "MeshCache.h"
+#include "GltfImporter.h"
 
 namespace vv
 {
@@ -19,15 +23,28 @@ namespace vv
 	}
 
 
-	void ModelManager::create(VulkanDevice *device, TextureManager *texture_manager, VkDescriptorPool descriptor_pool)
+	void ModelManager::create(VulkanDevice *device, TextureManager *texture_manager, VkDescriptorPool descriptor_pool,
+                              MaterialTable *material_table)
 	{
 		_device = device;
         _texture_manager = texture_manager;
         _descriptor_pool = descriptor_pool;
+        _material_table = material_table;
+
+        _geometry_buffer = new GeometryBuffer();
+        _geometry_buffer->create(_device);
+
+        // a single worker parses inline instead
+        uint32_t import_thread_count = Settings::inst()->getImportThreadCount();
+        if (import_thread_count > 1)
+        {
+            _import_thread_pool = new ThreadPool();
+            _import_thread_pool->create(import_thread_count);
+        }
 
         // load primitive mesh to cache
         Model *temp_model = new Model();
-        loadOBJ(Settings::inst()->getModelDirectory() + "primitives/", "sphere.obj", nullptr, temp_model);
+        loadOBJ(Settings::inst()->getModelDirectory() + "primitives/", "sphere.obj", nullptr, temp_model, true, false);
         delete temp_model;
 	}
 
@@ -41,6 +58,9 @@ namespace vv
                 delete mesh;
             }
 
+        _geometry_buffer->shutDown();
+        delete _geometry_buffer;
+
         for (auto &m : _loaded_materials)
             for (auto &mat : m.second)
                 for (auto & material : mat.second)
@@ -48,10 +68,17 @@ namespace vv
                     material->shutDown();
                     delete material;
                 }
+
+        if (_import_thread_pool)
+        {
+            _import_thread_pool->shutDown();
+            delete _import_thread_pool;
+        }
 	}
 
 
-    bool ModelManager::loadModel(std::string path, std::string name, MaterialTemplate *material_template, Model *model)
+    bool ModelManager::loadModel(std::string path, std::string name, MaterialTemplate *material_template, Model *model,
+                                 bool keep_host_geometry)
     {
         bool load_geometry = true;
         path = Settings::inst()->getModelDirectory() + path;
@@ -60,6 +87,9 @@ namespace vv
         // check if geometry has already been loaded
         if (_loaded_meshes.count(path + name) > 0)
         {
+            if (keep_host_geometry && !_loaded_meshes[path + name].empty() && !_loaded_meshes[path + name][0]->hasHostCopy())
+                VV_ALERT("Host geometry of " + path + name + " was already released. Request it on the first load.");
+
             // materials have been loaded as well
             if (_loaded_materials[path + name].count(material_template->name) > 0)
             {
@@ -72,10 +102,10 @@ namespace vv
         }
 
         if (file_type == "obj")
-            return loadOBJ(path, name, material_template, model);
+            return loadOBJ(path, name, material_template, model, load_geometry, keep_host_geometry);
 
-        else if (file_type == "gltf")
-            return loadGLTF();
+        else if (file_type == "gltf" || file_type == "glb")
+            return loadGLTF(path, name, material_template, model, load_geometry, keep_host_geometry);
 
         else
         {
@@ -91,91 +121,96 @@ namespace vv
     }
 
 
+    HostMemoryStatistics ModelManager::getHostMemoryStatistics() const
+    {
+        HostMemoryStatistics stats = {};
+        stats.reclaimed_bytes = _reclaimed_host_bytes;
+
+        for (const auto &m : _loaded_meshes)
+            for (const auto &mesh : m.second)
+                stats.resident_bytes += mesh->getHostCopySize();
+
+        return stats;
+    }
+
+
+    const ImportStatistics& ModelManager::getImportStatistics() const
+    {
+        return _import_statistics;
+    }
+
+
     ///////////////////////////////////////////////////////////////////////////////////////////// Private
-    bool ModelManager::loadOBJ(std::string path, std::string name, MaterialTemplate *material_template, Model *model)
+    bool ModelManager::loadOBJ(std::string path, std::string name, MaterialTemplate *material_template, Model *model, bool load_geometry,
+                               bool keep_host_geometry)
     {
         bool success = true;
-        std::string full_path(path + name);
-    	tinyobj::attrib_t attrib;
-		std::vector<tinyobj::shape_t> tiny_shapes;
-		std::vector<tinyobj::material_t> tiny_materials;
-		std::string err;
-
         std::vector<Mesh *> meshes;
         std::vector<Material *> materials;
 
-		VV_ASSERT(tinyobj::LoadObj(&attrib, &tiny_shapes, &tiny_materials, &err,
-                  full_path.c_str(), path.c_str()),
-                  "Model, " + name + ", not loaded correctly\n\n" + err);
-
-        // parse through all loaded geometry and create internal abstractions.
-		for (const auto& shape : tiny_shapes)
-		{
-		    std::vector<Vertex> vertices;
-		    std::vector<uint32_t> indices;
-		    std::unordered_map<Vertex, int> vertex_map;
-
-			for (const auto& index : shape.mesh.indices)
-			{
-				Vertex vertex = {};
-
-                // Vertices
-				vertex.position = glm::vec3(
-					attrib.vertices[3 * index.vertex_index + 0],
-					attrib.vertices[3 * index.vertex_index + 1],
-					attrib.vertices[3 * index.vertex_index + 2]
-				);
-
-                // Normals
-                if (!attrib.normals.empty())
-                    vertex.normal = glm::vec3(
-                        attrib.normals[3 * index.normal_index + 0],
-                        attrib.normals[3 * index.normal_index + 1],
-                        attrib.normals[3 * index.normal_index + 2]
-                    );
-                else
-                {
-				    vertex.normal = glm::vec3(0.0, 0.0, 1.0);
-                    VV_ALERT("Model does not have normals.");
-                }
+        MeshCache cache;
+        std::string cache_name = name + ".vvmesh";
+        bool use_cache = Settings::inst()->isMeshCacheEnabled();
 
-                // UVs
-                if (!attrib.texcoords.empty())
-                    vertex.texCoord = glm::vec2(
-                        attrib.texcoords[2 * index.texcoord_index + 0],
-                        1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-                    );
-                else
-                {
-                    vertex.texCoord = glm::vec2(0.0f, 0.0f);
-                    VV_ALERT("Model does not have UV coordinates.");
-                }
+        auto cache_start = std::chrono::high_resolution_clock::now();
+        if (use_cache && cache.create(path, cache_name, ObjImporter::version))
+        {
+            std::chrono::duration<double, std::milli> cache_time = std::chrono::high_resolution_clock::now() - cache_start;
+            _import_statistics.cache_load_time += cache_time.count();
+            ++_import_statistics.cached_model_count;
+        }
+        else
+        {
+            std::string err;
+            VV_ASSERT(cache.importOBJ(path, name, _import_thread_pool, _import_statistics, err), "Model, " + name + ", not loaded correctly\n\n" + err);
+
+            // not fatal, the model is just imported from source again next time
+            if (use_cache && !cache.write(path, cache_name, ObjImporter::version))
+                VV_ALERT("WARNING: Mesh cache could not be written to " + path + cache_name);
+        }
 
-				if (vertex_map.count(vertex) == 0)
-				{
-					vertex_map[vertex] = (int)vertices.size();
-					vertices.push_back(vertex);
-				}
+        const auto &obj_materials = cache.materials;
+        const Vertex *vertices = cache.getVertices();
+        const uint32_t *indices = cache.getIndices();
 
-				indices.push_back(vertex_map[vertex]);
-			}
+        // a file loaded before only needs the materials of the new template. its meshes are shared.
+        if (load_geometry)
+        {
+            for (const auto &s : cache.submeshes)
+            {
+                const Vertex *first_vertex = vertices + s.first_vertex;
+                const uint32_t *first_index = indices + s.first_index;
 
-            int curr_material_id = shape.mesh.material_ids[0];
+                Mesh *mesh = new Mesh();
+                if (keep_host_geometry)
+                    mesh->create(_geometry_buffer, s.name, std::vector<Vertex>(first_vertex, first_vertex + s.vertex_count),
+                                 std::vector<uint32_t>(first_index, first_index + s.index_count), s.material_id, s.bounding_box, s.bounding_sphere);
+                else
+                {
+                    // the upload queue copies straight out of the cache into staging memory. it's released right after.
+                    mesh->create(_geometry_buffer, s.name, first_vertex, s.vertex_count, first_index, s.index_count, s.material_id,
+                                 s.bounding_box, s.bounding_sphere);
+                    _reclaimed_host_bytes += sizeof(Vertex) * s.vertex_count + sizeof(uint32_t) * s.index_count;
+                }
 
-            Mesh *mesh = new Mesh();
-            mesh->create(_device, shape.name, vertices, indices, ((curr_material_id < 0) ? 0 : curr_material_id));
-            meshes.push_back(mesh);
-		}
+                meshes.push_back(mesh);
+            }
 
-        _loaded_meshes[path + name] = meshes;
+            _loaded_meshes[path + name] = meshes;
+        }
 
         if (material_template)
         {
+            // bindless materials are written into the shared table instead of descriptor sets of their own
+            bool bindless = material_template->uses_bindless_materials;
+            VV_ASSERT(!bindless || _material_table, "ERROR: bindless material template without a material table");
+
             // parse through all loaded materials and create internal abstractions.
-            for (const auto &m : tiny_materials)
+            for (const auto &m : obj_materials)
             {
                 Material *material = new Material();
                 material->create(_device, material_template, _descriptor_pool);
+                MaterialData material_data = {};
 
                 // store required descriptor set data in correct binding order
                 auto orderings = material_template->shader->material_descriptor_orderings;
@@ -189,6 +224,15 @@ namespace vv
                         glm::vec4 spec(m.specular[0], m.specular[1], m.specular[2], 0.0);
                         MaterialProperties properties = { amb, dif, spec, static_cast<int>(m.shininess) };
 
+                        if (bindless)
+                        {
+                            material_data.ambient = amb;
+                            material_data.diffuse = dif;
+                            material_data.specular = spec;
+                            material_data.shininess = m.shininess;
+                            continue;
+                        }
+
                         VulkanBuffer *buffer = new VulkanBuffer();
                         buffer->create(_device, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(properties));
                         buffer->updateAndTransfer(&properties);
@@ -214,7 +258,10 @@ namespace vv
                             temp_name = m.emissive_texname;
 
                         auto texture = _texture_manager->load2DImage(path, temp_name, VK_FORMAT_R8G8B8A8_UNORM, false);
-                        material->addTexture(texture, o.binding);
+                        if (bindless)
+                            MaterialTable::setTextureIndex(material_data, o.name, _material_table->addTexture(texture));
+                        else
+                            material->addTexture(texture, o.binding);
                     }
                     else // descriptor type not populated
                     {
@@ -224,15 +271,19 @@ namespace vv
                     }
                 }
 
-                material->updateDescriptorSets();
+                if (bindless)
+                    material->material_index = _material_table->addMaterial(material_data);
+                else
+                    material->updateDescriptorSets();
                 materials.push_back(material);
             }
 
             // if no mtl file was found
-            if (tiny_materials.empty())
+            if (obj_materials.empty())
             {
                 Material *material = new Material();
                 material->create(_device, material_template, _descriptor_pool);
+                MaterialData material_data = {};
 
                 //VV_ALERT("MTL file not found. Assuming PBR textures present.");
                 
@@ -256,10 +307,134 @@ namespace vv
                         temp_name = "ambient_occlusion.dds";
 
                     auto texture = _texture_manager->load2DImage(path + "textures/", temp_name);
-                    material->addTexture(texture, o.binding);
+                    if (bindless)
+                        MaterialTable::setTextureIndex(material_data, o.name, _material_table->addTexture(texture));
+                    else
+                        material->addTexture(texture, o.binding);
+                }
+
+                if (bindless)
+                    material->material_index = _material_table->addMaterial(material_data);
+                else
+                    material->updateDescriptorSets();
+                materials.push_back(material);
+            }
+
+            _loaded_materials[path + name][material_template->name] = materials;
+            model->create(_device, name, path + name, material_template->name, material_template);
+        }
+
+        cache.shutDown();
+        return success;
+    }
+
+
+
+    bool ModelManager::loadGLTF(std::string path, std::string name, MaterialTemplate *material_template, Model *model, bool load_geometry,
+                                bool keep_host_geometry)
+    {
+        bool success = true;
+        std::vector<Mesh *> meshes;
+        std::vector<Material *> materials;
+
+        auto load_start = std::chrono::high_resolution_clock::now();
+
+        GltfImporter importer;
+        std::string err;
+        VV_ASSERT(importer.load(path, name, err), "Model, " + name + ", not loaded correctly\n\n" + err);
+
+        // primitives without a material share a default one behind those of the file
+        int default_material_id = static_cast<int>(importer.materials.size());
+        bool uses_default_material = importer.materials.empty();
+        for (const auto &p : importer.primitives)
+            uses_default_material = uses_default_material || p.material_id < 0;
+        if (uses_default_material)
+            importer.materials.push_back(GltfMaterial());
+
+        // a file loaded before only needs the materials of the new template. its meshes are shared.
+        if (load_geometry)
+        {
+            for (const auto &p : importer.primitives)
+            {
+                int material_id = (p.material_id < 0) ? default_material_id : p.material_id;
+
+                Mesh *mesh = new Mesh();
+                if (keep_host_geometry)
+                    mesh->create(_geometry_buffer, p.name, std::vector<Vertex>(p.vertices, p.vertices + p.vertex_count),
+                                 std::vector<uint32_t>(p.indices, p.indices + p.index_count), material_id, p.bounding_box, p.bounding_sphere);
+                else
+                {
+                    // the upload queue copies straight out of the mapped file, or the importer if the layout had to be converted
+                    mesh->create(_geometry_buffer, p.name, p.vertices, p.vertex_count, p.indices, p.index_count, material_id,
+                                 p.bounding_box, p.bounding_sphere);
+                    _reclaimed_host_bytes += sizeof(Vertex) * p.vertex_count + sizeof(uint32_t) * p.index_count;
+                }
+
+                meshes.push_back(mesh);
+            }
+
+            _loaded_meshes[path + name] = meshes;
+
+            std::chrono::duration<double, std::milli> load_time = std::chrono::high_resolution_clock::now() - load_start;
+            _import_statistics.gltf_load_time += load_time.count();
+            _import_statistics.mapped_vertex_count += importer.mapped_vertex_count;
+            ++_import_statistics.gltf_model_count;
+        }
+
+        if (material_template)
+        {
+            bool bindless = material_template->uses_bindless_materials;
+            VV_ASSERT(!bindless || _material_table, "ERROR: bindless material template without a material table");
+
+            for (const auto &m : importer.materials)
+            {
+                Material *material = new Material();
+                material->create(_device, material_template, _descriptor_pool);
+                MaterialData material_data = {};
+
+                auto orderings = material_template->shader->material_descriptor_orderings;
+                for (size_t i = 0; i < orderings.size(); ++i)
+                {
+                    auto o = orderings[i];
+                    if (o.name == "properties")
+                    {
+                        // the base color is the closest thing to a diffuse color the phong templates get
+                        glm::vec4 dif(m.base_color_factor[0], m.base_color_factor[1], m.base_color_factor[2], 0.0);
+                        MaterialProperties properties = { glm::vec4(0.0f), dif, glm::vec4(0.0f), 1 };
+
+                        if (bindless)
+                        {
+                            material_data.diffuse = dif;
+                            material_data.shininess = 1.0f;
+                            continue;
+                        }
+
+                        VulkanBuffer *buffer = new VulkanBuffer();
+                        buffer->create(_device, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(properties));
+                        buffer->updateAndTransfer(&properties);
+
+                        material->addUniformBuffer(buffer, o.binding);
+                    }
+                    else if (o.name.find("map") != std::string::npos)
+                    {
+                        auto texture = loadGLTFTexture(path, name, importer, m, o.name);
+                        if (bindless)
+                            MaterialTable::setTextureIndex(material_data, o.name, _material_table->addTexture(texture));
+                        else
+                            material->addTexture(texture, o.binding);
+                    }
+                    else // descriptor type not populated
+                    {
+                        VV_ALERT("WARNING: Descriptor Type not populated for model: " + name + ". Using dummy material.");
+                        success = false;
+                        break;
+                    }
                 }
 
-                material->updateDescriptorSets();
+                if (bindless)
+                    material->material_index = _material_table->addMaterial(material_data);
+                else
+                    material->updateDescriptorSets();
                 materials.push_back(material);
             }
 
@@ -267,12 +442,75 @@ namespace vv
             model->create(_device, name, path + name, material_template->name, material_template);
         }
 
+        // embedded images were needed up to here
+        importer.shutDown();
         return success;
     }
 
 
-    bool ModelManager::loadGLTF()
+    SampledTexture* ModelManager::loadGLTFTexture(const std::string &path, const std::string &name, const GltfImporter &importer,
+                                                  const GltfMaterial &material, const std::string &descriptor_name)
     {
-        return false;
+        std::string key;
+        auto loadImage = [&](int image) -> SampledTexture* {
+            const GltfImage &i = importer.images[image];
+            if (i.uri.empty())
+            {
+                key = path + name + "#image" + std::to_string(image);
+                return _texture_manager->loadEncodedImage(key, i.data, i.size);
+            }
+
+            // files go through load2DImage, so cooked versions of them are picked up as well
+            std::size_t slash = i.uri.find_last_of('/');
+            std::string directory = (slash == std::string::npos) ? "" : i.uri.substr(0, slash + 1);
+            key = path + i.uri;
+            return _texture_manager->load2DImage(path + directory, i.uri.substr(directory.size()));
+        };
+
+        const GltfMaterial &m = material;
+        glm::vec4 metallic_roughness(m.metallic_factor, m.roughness_factor, 0.0f, 1.0f);
+
+        if (descriptor_name == "albedo_map" || descriptor_name == "diffuse_map")
+        {
+            if (m.base_color_texture >= 0)
+                return loadImage(m.base_color_texture);
+
+            // the factor is linear, while the templates decode albedo maps from gamma space
+            glm::vec4 base_color(std::pow(m.base_color_factor[0], 1.0f / 2.2f), std::pow(m.base_color_factor[1], 1.0f / 2.2f),
+                                 std::pow(m.base_color_factor[2], 1.0f / 2.2f), m.base_color_factor[3]);
+            return _texture_manager->loadSolidImage(base_color);
+        }
+        else if (descriptor_name == "roughness_map")
+        {
+            // roughness is read from g, which is where glTF keeps it as well
+            return (m.metallic_roughness_texture >= 0) ? loadImage(m.metallic_roughness_texture) :
+                                                         _texture_manager->loadSolidImage(metallic_roughness);
+        }
+        else if (descriptor_name == "metalness_map")
+        {
+            if (m.metallic_roughness_texture < 0)
+                return _texture_manager->loadSolidImage(metallic_roughness);
+
+            // metalness is read from r, but glTF keeps it in b
+            SampledTexture *texture = loadImage(m.metallic_roughness_texture);
+            VkComponentMapping components = { VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+                                              VK_COMPONENT_SWIZZLE_IDENTITY };
+            return _texture_manager->createSwizzledView(texture, key + "#metalness", components);
+        }
+        else if (descriptor_name == "normal_map")
+        {
+            return (m.normal_texture >= 0) ? loadImage(m.normal_texture) :
+                                             _texture_manager->loadSolidImage(glm::vec4(0.5f, 0.5f, 1.0f, 1.0f));
+        }
+        else if (descriptor_name == "emissiveness_map")
+        {
+            return (m.emissive_texture >= 0) ? loadImage(m.emissive_texture) :
+                   _texture_manager->loadSolidImage(glm::vec4(m.emissive_factor[0], m.emissive_factor[1], m.emissive_factor[2], 1.0f));
+        }
+        else if (descriptor_name == "ambient_occlusion_map")
+            return (m.occlusion_texture >= 0) ? loadImage(m.occlusion_texture) : _texture_manager->loadSolidImage(glm::vec4(1.0f));
+
+        // ambient and specular maps of the phong templates have no glTF counterpart
+        return _texture_manager->load2DImage(path, "");
     }
 }
@@ -0,0 +1,630 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "ObjImporter.h"
+#include "MappedFile.h"
+
+namespace vv
+{
+    // below this, splitting costs more than parsing in parallel saves
+    static const std::size_t min_chunk_size = 256 * 1024;
+
+
+    static bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+
+    static const char* skipSpaces(const char *p, const char *end)
+    {
+        while (p < end && isSpace(*p))
+            ++p;
+        return p;
+    }
+
+
+    static const char* findLineEnd(const char *p, const char *end)
+    {
+        const char *line_end = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        return line_end ? line_end : end;
+    }
+
+
+    /*
+     * Reads the next whitespace separated token of the line.
+     */
+    static const char* parseToken(const char *p, const char *end, std::string &token)
+    {
+        p = skipSpaces(p, end);
+        const char *start = p;
+        while (p < end && !isSpace(*p) && *p != '\n')
+            ++p;
+        token.assign(start, p);
+        return p;
+    }
+
+
+    /*
+     * Returns the last token of the line. Texture statements put their options in front of the file name.
+     */
+    static std::string parseLastToken(const char *p, const char *end)
+    {
+        while (end > p && isSpace(end[-1]))
+            --end;
+        const char *start = end;
+        while (start > p && !isSpace(start[-1]))
+            --start;
+        return std::string(start, end);
+    }
+
+
+    static bool startsWithKeyword(const char *p, const char *end, const char *keyword)
+    {
+        std::size_t length = std::strlen(keyword);
+        return static_cast<std::size_t>(end - p) > length && std::strncmp(p, keyword, length) == 0 && isSpace(p[length]);
+    }
+
+
+    /*
+     * Decimal float parser. Doesn't look at the locale like strtod does. Mantissas of up to 19 digits with exponents
+     * within +-22 are converted exactly, which covers what exporters write. Anything longer loses at most an ulp.
+     * Returns nullptr if there is no number at p.
+     */
+    static const char* parseFloat(const char *p, const char *end, float &value)
+    {
+        static const double powers_of_ten[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        p = skipSpaces(p, end);
+
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negative = (*p++ == '-');
+
+        uint64_t mantissa = 0;
+        int exponent = 0;
+        int digit_count = 0;
+        bool has_digits = false;
+
+        for (; p < end && *p >= '0' && *p <= '9'; ++p, has_digits = true)
+        {
+            if (digit_count < 19)
+            {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                digit_count += (mantissa != 0);
+            }
+            else
+                ++exponent; // digits past what fits only scale the value
+        }
+
+        if (p < end && *p == '.')
+        {
+            for (++p; p < end && *p >= '0' && *p <= '9'; ++p, has_digits = true)
+            {
+                if (digit_count < 19)
+                {
+                    mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                    digit_count += (mantissa != 0);
+                    --exponent;
+                }
+            }
+        }
+
+        if (!has_digits)
+            return nullptr;
+
+        if (p < end && (*p == 'e' || *p == 'E'))
+        {
+            const char *exponent_start = p++;
+            bool negative_exponent = false;
+            if (p < end && (*p == '-' || *p == '+'))
+                negative_exponent = (*p++ == '-');
+
+            if (p < end && *p >= '0' && *p <= '9')
+            {
+                int written_exponent = 0;
+                for (; p < end && *p >= '0' && *p <= '9'; ++p)
+                    written_exponent = std::min(written_exponent * 10 + (*p - '0'), 10000);
+                exponent += negative_exponent ? -written_exponent : written_exponent;
+            }
+            else
+                p = exponent_start; // not an exponent after all
+        }
+
+        // both operands are exact below 2^53 and 1e22, so a single rounding happens
+        double result = static_cast<double>(mantissa);
+        if (exponent < 0 && exponent >= -22 && mantissa < (1ull << 53))
+            result /= powers_of_ten[-exponent];
+        else if (exponent > 0 && exponent <= 22 && mantissa < (1ull << 53))
+            result *= powers_of_ten[exponent];
+        else if (exponent != 0)
+            result *= std::pow(10.0, exponent);
+
+        value = static_cast<float>(negative ? -result : result);
+        return p;
+    }
+
+
+    static const char* parseInt(const char *p, const char *end, int &value, bool &found)
+    {
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negative = (*p++ == '-');
+
+        int result = 0;
+        found = false;
+        for (; p < end && *p >= '0' && *p <= '9'; ++p, found = true)
+            result = result * 10 + (*p - '0');
+
+        value = negative ? -result : result;
+        return p;
+    }
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////// Public
+	ObjVertexMap::ObjVertexMap()
+	{
+	}
+
+
+	ObjVertexMap::~ObjVertexMap()
+	{
+	}
+
+
+    void ObjVertexMap::reset(std::size_t max_count)
+    {
+        std::size_t capacity = 16;
+        while (capacity < max_count * 2)
+            capacity *= 2;
+
+        const ObjIndex empty = { -1, -1, -1 };
+        _keys.assign(capacity, empty);
+        _values.resize(capacity);
+        _mask = capacity - 1;
+    }
+
+
+    uint32_t ObjVertexMap::findOrInsert(const ObjIndex &index, uint32_t next_vertex, bool &inserted)
+    {
+        // the three indices are spread over 64 bits and folded back. neighbouring corners land far apart.
+        uint64_t key = static_cast<uint32_t>(index.vertex_index) | (static_cast<uint64_t>(static_cast<uint32_t>(index.normal_index)) << 32);
+        uint64_t hash = key * 0x9E3779B97F4A7C15ull ^ static_cast<uint64_t>(static_cast<uint32_t>(index.texcoord_index)) * 0xC2B2AE3D27D4EB4Full;
+        hash ^= hash >> 29;
+
+        for (std::size_t slot = static_cast<std::size_t>(hash) & _mask; ; slot = (slot + 1) & _mask)
+        {
+            const ObjIndex &k = _keys[slot];
+            if (k.vertex_index == -1)
+            {
+                _keys[slot] = index;
+                _values[slot] = next_vertex;
+                inserted = true;
+                return next_vertex;
+            }
+
+            if (k.vertex_index == index.vertex_index && k.normal_index == index.normal_index && k.texcoord_index == index.texcoord_index)
+            {
+                inserted = false;
+                return _values[slot];
+            }
+        }
+    }
+
+
+	ObjImporter::ObjImporter()
+	{
+	}
+
+
+	ObjImporter::~ObjImporter()
+	{
+	}
+
+
+    bool ObjImporter::load(const std::string &path, const std::string &name, ThreadPool *thread_pool, std::string &error)
+    {
+        MappedFile file;
+        if (!file.create(path + name))
+        {
+            error = "Failed to open " + path + name;
+            return false;
+        }
+
+        const char *data = file.getData();
+        const char *data_end = data + file.getSize();
+
+        std::size_t chunk_count = 1;
+        if (thread_pool)
+        {
+            // a few chunks per worker, so one slow chunk doesn't hold everything up
+            std::size_t max_chunk_count = std::max<std::size_t>(1, file.getSize() / min_chunk_size);
+            chunk_count = std::min<std::size_t>(thread_pool->getThreadCount() * 4, max_chunk_count);
+        }
+
+        // cut at newlines, so every line is parsed by exactly one chunk
+        std::vector<Chunk> chunks(std::max<std::size_t>(1, chunk_count));
+        const std::size_t chunk_size = file.getSize() / chunks.size();
+        const char *chunk_begin = data;
+        for (std::size_t i = 0; i < chunks.size(); ++i)
+        {
+            const char *chunk_end = data_end;
+            if (i + 1 < chunks.size())
+            {
+                chunk_end = std::max(chunk_begin, data + (i + 1) * chunk_size);
+                chunk_end = std::min(findLineEnd(chunk_end, data_end) + 1, data_end);
+            }
+
+            chunks[i].begin = chunk_begin;
+            chunks[i].end = chunk_end;
+            chunk_begin = chunk_end;
+        }
+
+        if (thread_pool && chunks.size() > 1)
+        {
+            for (auto &chunk : chunks)
+            {
+                Chunk *c = &chunk;
+                thread_pool->enqueue([c]() { parseChunk(*c); });
+            }
+            thread_pool->wait();
+        }
+        else
+            parseChunk(chunks[0]);
+
+        bool success = mergeChunks(chunks, path, error);
+        if (!success)
+            error = path + name + ": " + error;
+
+        file.shutDown();
+        return success;
+    }
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////// Private
+    void ObjImporter::parseChunk(Chunk &chunk)
+    {
+        // rough guesses so the common case doesn't keep reallocating
+        const std::size_t size = chunk.end - chunk.begin;
+        chunk.positions.reserve(size / 16);
+        chunk.indices.reserve(size / 8);
+
+        std::vector<ObjIndex> corners;
+        std::vector<int> corner_relative_masks;
+        std::string token;
+
+        const char *line = chunk.begin;
+        while (line < chunk.end)
+        {
+            const char *line_end = findLineEnd(line, chunk.end);
+            const char *p = skipSpaces(line, line_end);
+            const std::size_t remaining = line_end - p;
+
+            if (remaining >= 2 && p[0] == 'v' && isSpace(p[1]))
+            {
+                float xyz[3] = {};
+                p += 2;
+                for (int i = 0; i < 3 && p; ++i)
+                    p = parseFloat(p, line_end, xyz[i]);
+                if (!p)
+                {
+                    chunk.error = "Malformed vertex: " + std::string(line, line_end);
+                    return;
+                }
+                chunk.positions.insert(chunk.positions.end(), xyz, xyz + 3);
+            }
+            else if (remaining >= 3 && p[0] == 'v' && p[1] == 'n' && isSpace(p[2]))
+            {
+                float xyz[3] = {};
+                p += 3;
+                for (int i = 0; i < 3 && p; ++i)
+                    p = parseFloat(p, line_end, xyz[i]);
+                if (!p)
+                {
+                    chunk.error = "Malformed normal: " + std::string(line, line_end);
+                    return;
+                }
+                chunk.normals.insert(chunk.normals.end(), xyz, xyz + 3);
+            }
+            else if (remaining >= 3 && p[0] == 'v' && p[1] == 't' && isSpace(p[2]))
+            {
+                // a missing v defaults to 0. an optional w is ignored.
+                float uv[2] = {};
+                p = parseFloat(p + 3, line_end, uv[0]);
+                if (!p)
+                {
+                    chunk.error = "Malformed texture coordinate: " + std::string(line, line_end);
+                    return;
+                }
+                parseFloat(p, line_end, uv[1]);
+                chunk.texcoords.insert(chunk.texcoords.end(), uv, uv + 2);
+            }
+            else if (remaining >= 2 && p[0] == 'f' && isSpace(p[1]))
+            {
+                corners.clear();
+                corner_relative_masks.clear();
+                p += 2;
+
+                // every corner is v, v/vt, v//vn or v/vt/vn
+                const int counts[3] = {
+                    static_cast<int>(chunk.positions.size() / 3),
+                    static_cast<int>(chunk.normals.size() / 3),
+                    static_cast<int>(chunk.texcoords.size() / 2)
+                };
+
+                while ((p = skipSpaces(p, line_end)) < line_end)
+                {
+                    int raw[3] = { 0, 0, 0 }; // vertex, normal, texcoord
+                    bool found[3] = { false, false, false };
+
+                    p = parseInt(p, line_end, raw[0], found[0]);
+                    if (p < line_end && *p == '/')
+                    {
+                        ++p;
+                        if (p < line_end && *p != '/')
+                            p = parseInt(p, line_end, raw[2], found[2]);
+                        if (p < line_end && *p == '/')
+                            p = parseInt(p + 1, line_end, raw[1], found[1]);
+                    }
+
+                    if (!found[0] || (p < line_end && !isSpace(*p)))
+                    {
+                        chunk.error = "Malformed face: " + std::string(line, line_end);
+                        return;
+                    }
+
+                    int resolved[3] = { -1, -1, -1 };
+                    int relative_mask = 0;
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        if (!found[c])
+                            continue;
+
+                        if (raw[c] > 0)
+                            resolved[c] = raw[c] - 1;
+                        else if (raw[c] < 0)
+                        {
+                            resolved[c] = counts[c] + raw[c];
+                            relative_mask |= 1 << c;
+                        }
+                        else
+                        {
+                            chunk.error = "Face index 0 is not valid: " + std::string(line, line_end);
+                            return;
+                        }
+                    }
+
+                    corners.push_back({ resolved[0], resolved[1], resolved[2] });
+                    corner_relative_masks.push_back(relative_mask);
+                }
+
+                if (corners.size() < 3)
+                {
+                    chunk.error = "Face with less than three corners: " + std::string(line, line_end);
+                    return;
+                }
+
+                // fan around the first corner
+                for (std::size_t k = 2; k < corners.size(); ++k)
+                {
+                    const std::size_t triangle[3] = { 0, k - 1, k };
+                    for (std::size_t t = 0; t < 3; ++t)
+                    {
+                        const std::size_t corner = triangle[t];
+                        for (int c = 0; c < 3; ++c)
+                            if (corner_relative_masks[corner] & (1 << c))
+                                chunk.relative_indices.push_back(std::make_pair(chunk.indices.size(), c));
+
+                        chunk.indices.push_back(corners[corner]);
+                    }
+                }
+            }
+            else if (remaining >= 2 && (p[0] == 'o' || p[0] == 'g') && isSpace(p[1]))
+            {
+                parseToken(p + 2, line_end, token);
+                chunk.directives.push_back({ (p[0] == 'o') ? DirectiveType::Object : DirectiveType::Group, token, chunk.indices.size() });
+            }
+            else if (startsWithKeyword(p, line_end, "usemtl"))
+            {
+                parseToken(p + 7, line_end, token);
+                chunk.directives.push_back({ DirectiveType::UseMaterial, token, chunk.indices.size() });
+            }
+            else if (startsWithKeyword(p, line_end, "mtllib"))
+            {
+                parseToken(p + 7, line_end, token);
+                chunk.directives.push_back({ DirectiveType::MaterialLibrary, token, chunk.indices.size() });
+            }
+            // everything else, comments, smoothing groups, lines and points are skipped
+
+            line = (line_end < chunk.end) ? line_end + 1 : chunk.end;
+        }
+    }
+
+
+    bool ObjImporter::mergeChunks(std::vector<Chunk> &chunks, const std::string &path, std::string &error)
+    {
+        std::size_t position_count = 0, normal_count = 0, texcoord_count = 0;
+        for (const auto &chunk : chunks)
+        {
+            if (!chunk.error.empty())
+            {
+                error = chunk.error;
+                return false;
+            }
+
+            position_count += chunk.positions.size();
+            normal_count += chunk.normals.size();
+            texcoord_count += chunk.texcoords.size();
+        }
+
+        positions.reserve(position_count);
+        normals.reserve(normal_count);
+        texcoords.reserve(texcoord_count);
+
+        ObjShape shape;
+        auto flush = [&]() {
+            if (shape.indices.empty())
+                return;
+
+            shapes.push_back(std::move(shape));
+            shape.indices = std::vector<ObjIndex>();
+            shape.name = shapes.back().name;
+            shape.material_id = shapes.back().material_id;
+        };
+
+        for (auto &chunk : chunks)
+        {
+            // what the relative indices of this chunk are relative to
+            const int bases[3] = {
+                static_cast<int>(positions.size() / 3),
+                static_cast<int>(normals.size() / 3),
+                static_cast<int>(texcoords.size() / 2)
+            };
+
+            positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+            normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+            texcoords.insert(texcoords.end(), chunk.texcoords.begin(), chunk.texcoords.end());
+
+            for (const auto &r : chunk.relative_indices)
+            {
+                ObjIndex &index = chunk.indices[r.first];
+                int32_t &component = (r.second == 0) ? index.vertex_index : ((r.second == 1) ? index.normal_index : index.texcoord_index);
+                component += bases[r.second];
+            }
+
+            // indices may only point at attributes defined in front of them. the totals so far are an upper bound.
+            const int limits[3] = {
+                static_cast<int>(positions.size() / 3),
+                static_cast<int>(normals.size() / 3),
+                static_cast<int>(texcoords.size() / 2)
+            };
+
+            for (const auto &index : chunk.indices)
+            {
+                if (index.vertex_index < 0 || index.vertex_index >= limits[0] || index.normal_index >= limits[1] ||
+                    index.texcoord_index >= limits[2] || index.normal_index < -1 || index.texcoord_index < -1)
+                {
+                    error = "Face index out of range";
+                    return false;
+                }
+            }
+
+            std::size_t copied = 0;
+            for (const auto &directive : chunk.directives)
+            {
+                shape.indices.insert(shape.indices.end(), chunk.indices.begin() + copied, chunk.indices.begin() + directive.index_offset);
+                copied = directive.index_offset;
+
+                switch (directive.type)
+                {
+                case DirectiveType::Object:
+                case DirectiveType::Group:
+                    flush();
+                    shape.name = directive.name;
+                    break;
+
+                case DirectiveType::UseMaterial:
+                {
+                    auto it = _material_map.find(directive.name);
+                    int material_id = (it != _material_map.end()) ? it->second : -1;
+                    if (material_id != shape.material_id)
+                    {
+                        flush();
+                        shape.material_id = material_id;
+                    }
+                    break;
+                }
+
+                case DirectiveType::MaterialLibrary:
+                    if (!loadMaterialLibrary(path + directive.name, error))
+                        return false;
+                    material_libraries.push_back(directive.name);
+                    break;
+                }
+            }
+
+            shape.indices.insert(shape.indices.end(), chunk.indices.begin() + copied, chunk.indices.end());
+
+            // parsed data isn't needed anymore
+            chunk = Chunk();
+        }
+
+        flush();
+        return true;
+    }
+
+
+    bool ObjImporter::loadMaterialLibrary(const std::string &file_path, std::string &error)
+    {
+        MappedFile file;
+        if (!file.create(file_path))
+        {
+            error = "Material library not found: " + file_path;
+            return false;
+        }
+
+        const char *line = file.getData();
+        const char *end = line + file.getSize();
+        ObjMaterial *material = nullptr;
+
+        auto parseColor = [](const char *p, const char *line_end, float *color) {
+            for (int i = 0; i < 3 && p; ++i)
+                p = parseFloat(p, line_end, color[i]);
+        };
+
+        while (line < end)
+        {
+            const char *line_end = findLineEnd(line, end);
+            const char *p = skipSpaces(line, line_end);
+
+            if (startsWithKeyword(p, line_end, "newmtl"))
+            {
+                std::string name;
+                parseToken(p + 7, line_end, name);
+
+                _material_map[name] = static_cast<int>(materials.size());
+                materials.push_back(ObjMaterial());
+                material = &materials.back();
+                material->name = name;
+            }
+            else if (material)
+            {
+                if (startsWithKeyword(p, line_end, "Ka"))
+                    parseColor(p + 3, line_end, material->ambient);
+                else if (startsWithKeyword(p, line_end, "Kd"))
+                    parseColor(p + 3, line_end, material->diffuse);
+                else if (startsWithKeyword(p, line_end, "Ks"))
+                    parseColor(p + 3, line_end, material->specular);
+                else if (startsWithKeyword(p, line_end, "Ns"))
+                    parseFloat(p + 3, line_end, material->shininess);
+                else if (startsWithKeyword(p, line_end, "map_Ka"))
+                    material->ambient_texname = parseLastToken(p + 7, line_end);
+                else if (startsWithKeyword(p, line_end, "map_Kd"))
+                    material->diffuse_texname = parseLastToken(p + 7, line_end);
+                else if (startsWithKeyword(p, line_end, "map_Ks"))
+                    material->specular_texname = parseLastToken(p + 7, line_end);
+                else if (startsWithKeyword(p, line_end, "map_Ke"))
+                    material->emissive_texname = parseLastToken(p + 7, line_end);
+                else if (startsWithKeyword(p, line_end, "map_Pr"))
+                    material->roughness_texname = parseLastToken(p + 7, line_end);
+                else if (startsWithKeyword(p, line_end, "map_Pm"))
+                    material->metallic_texname = parseLastToken(p + 7, line_end);
+                else if (startsWithKeyword(p, line_end, "map_Bump") || startsWithKeyword(p, line_end, "map_bump"))
+                    material->bump_texname = parseLastToken(p + 9, line_end);
+                else if (startsWithKeyword(p, line_end, "bump"))
+                    material->bump_texname = parseLastToken(p + 5, line_end);
+                else if (startsWithKeyword(p, line_end, "norm"))
+                    material->normal_texname = parseLastToken(p + 5, line_end);
+            }
+
+            line = (line_end < end) ? line_end + 1 : end;
+        }
+
+        file.shutDown();
+        return true;
+    }
+}
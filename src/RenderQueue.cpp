@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <array>
+
+#include "RenderQueue.h"
+
+namespace vv
+{
+	///////////////////////////////////////////////////////////////////////////////////////////// Public
+	RenderQueue::RenderQueue()
+	{
+	}
+
+
+	RenderQueue::~RenderQueue()
+	{
+	}
+
+
+    uint64_t RenderQueue::createSortKey(DrawPass pass, uint32_t pipeline_id, uint32_t material_id, uint32_t geometry_page,
+                                        uint32_t mesh_id, float depth)
+    {
+        // ids sharing a key would interleave by depth, so buckets would no longer be stable between frames
+        VV_ASSERT(pipeline_id <= 0xFF, "ERROR: more pipelines than the sort key can tell apart");
+        VV_ASSERT(material_id <= 0x3FFF, "ERROR: more materials than the sort key can tell apart");
+        VV_ASSERT(geometry_page <= 0x3F, "ERROR: more geometry pages than the sort key can tell apart");
+        VV_ASSERT(mesh_id <= 0xFFFF, "ERROR: more meshes than the sort key can tell apart");
+
+        uint64_t sort_key = (static_cast<uint64_t>(pass) & 0xF) << 60 |
+                            (static_cast<uint64_t>(pipeline_id) & 0xFF) << 52 |
+                            (static_cast<uint64_t>(material_id) & 0x3FFF) << 38 |
+                            (static_cast<uint64_t>(geometry_page) & 0x3F) << 32 |
+                            (static_cast<uint64_t>(mesh_id) & 0xFFFF) << 16;
+
+        return setSortKeyDepth(sort_key, depth);
+    }
+
+
+    uint64_t RenderQueue::setSortKeyDepth(uint64_t sort_key, float depth)
+    {
+        float clamped_depth = std::min(std::max(depth, 0.0f), 1.0f);
+        uint64_t depth_bits = static_cast<uint64_t>(clamped_depth * 65535.0f);
+
+        // blending needs the farthest surfaces first
+        if (static_cast<DrawPass>(sort_key >> 60) == DrawPass::Transparent)
+            depth_bits = 65535 - depth_bits;
+
+        return (sort_key & ~0xFFFFull) | depth_bits;
+    }
+
+
+    void RenderQueue::clear()
+    {
+        _packets.clear();
+        _items.clear();
+    }
+
+
+    void RenderQueue::push(const DrawPacket &packet)
+    {
+        _items.push_back({ packet.sort_key, static_cast<uint32_t>(_packets.size()) });
+        _packets.push_back(packet);
+    }
+
+
+    void RenderQueue::sort()
+    {
+        const std::size_t count = _items.size();
+        _scratch.resize(count);
+
+        for (uint32_t shift = 0; shift < 64; shift += 8)
+        {
+            std::array<std::size_t, 256> histogram = {};
+            for (const auto &item : _items)
+                ++histogram[(item.key >> shift) & 0xFF];
+
+            // high bytes (pass, pipeline) rarely differ across a scene. skip bytes every key shares.
+            if (histogram[(_items.empty() ? 0 : (_items[0].key >> shift) & 0xFF)] == count)
+                continue;
+
+            std::size_t offset = 0;
+            for (auto &h : histogram)
+            {
+                std::size_t bucket_size = h;
+                h = offset;
+                offset += bucket_size;
+            }
+
+            for (const auto &item : _items)
+                _scratch[histogram[(item.key >> shift) & 0xFF]++] = item;
+
+            _items.swap(_scratch);
+        }
+    }
+
+
+    std::size_t RenderQueue::size() const
+    {
+        return _packets.size();
+    }
+
+
+    const DrawPacket& RenderQueue::operator[](std::size_t i) const
+    {
+        return _packets[_items[i].packet_index];
+    }
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////// Private
+}
@@ -1,9 +1,12 @@
 
 #include "Scene.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <string>
 #include <fstream>
 #include <chrono>
+#include <cstring>
 
 #include "Settings.h"
 #include "glm/glm.hpp"
@@ -24,21 +27,33 @@ namespace vv
     }
 
 
-    void Scene::create(VulkanDevice *device, VulkanRenderPass *render_pass)
+    void Scene::create(VulkanDevice *device, VulkanRenderPass *render_pass, VulkanSwapChain *swap_chain)
     {
         _device = device;
         _render_pass = render_pass;
+        _swap_chain = swap_chain;
+        _frame_count = Settings::inst()->getMaxFramesInFlight();
 
         createDescriptorPool();
         createSceneDescriptorSetLayout();
         createEnvironmentUniforms();
+
+        // has to exist before the templates, which pick their shader variant and set layout by it
+        if (Settings::inst()->isBindlessMaterialsEnabled() && _device->descriptor_indexing)
+        {
+            _material_table = new MaterialTable();
+            _material_table->create(_device);
+        }
+
         createMaterialTemplates(); // Load material templates to prepare for model loading queries
+        createDepthPrePassPipeline();
+        _depth_pre_pass_enabled = Settings::inst()->isDepthPrePassEnabled();
 
         _texture_manager = new TextureManager();
         _texture_manager->create(_device);
 
         _model_manager = new ModelManager();
-        _model_manager->create(_device, _texture_manager, _descriptor_pool);
+        _model_manager->create(_device, _texture_manager, _descriptor_pool, _material_table);
 
         _initialized = true;
     }
@@ -53,10 +68,18 @@ namespace vv
 
             vkDestroyPipelineLayout(_device->logical_device, t.second->pipeline_layout, nullptr);
             t.second->pipeline->shutDown(); delete t.second->pipeline;
+            if (t.second->depth_equal_pipeline)
+            {
+                t.second->depth_equal_pipeline->shutDown(); delete t.second->depth_equal_pipeline;
+            }
 
             delete t.second;
         }
 
+        _depth_pipeline->shutDown(); delete _depth_pipeline;
+        vkDestroyPipelineLayout(_device->logical_device, _depth_pipeline_layout, nullptr);
+        _depth_shader->shutDown(); delete _depth_shader;
+
         for (auto &l : _lights)
         {
             l->shutDown();
@@ -81,8 +104,19 @@ namespace vv
             delete s;
         }
 
-        _scene_uniform_buffer->shutDown(); delete _scene_uniform_buffer;
-        _lights_uniform_buffer->shutDown(); delete _lights_uniform_buffer;
+        if (_culling_pass)
+        {
+            _culling_pass->shutDown();
+            delete _culling_pass;
+        }
+
+        if (_material_table)
+        {
+            _material_table->shutDown();
+            delete _material_table;
+        }
+
+        _uniform_ring_buffer->shutDown(); delete _uniform_ring_buffer;
         vkDestroyDescriptorSetLayout(_device->logical_device, _scene_descriptor_set_layout, nullptr);
         vkDestroyDescriptorSetLayout(_device->logical_device, _environment_descriptor_set_layout, nullptr);
         vkDestroyDescriptorSetLayout(_device->logical_device, _radiance_descriptor_set_layout, nullptr);
@@ -103,13 +137,14 @@ namespace vv
     }
 
 
-    Model* Scene::addModel(std::string path, std::string name, std::string material_template)
+    Model* Scene::addModel(std::string path, std::string name, std::string material_template, bool keep_host_geometry)
     {
         VV_ASSERT(_initialized, "ERROR: scene needs to be initialized before adding models");
         VV_ASSERT(material_templates[material_template], "ERROR: material_template does not exist");
         Model *model = new Model();
-        _model_manager->loadModel(path, name, material_templates[material_template], model);
+        _model_manager->loadModel(path, name, material_templates[material_template], model, keep_host_geometry);
         _models.push_back(model);
+        _draw_packets_dirty = true;
         return model;
     }
 
@@ -170,7 +205,69 @@ namespace vv
     }
 
 
-    void Scene::updateUniformData(VkExtent2D extent, float delta_time)
+    const CullingStatistics& Scene::getCullingStatistics() const
+    {
+        return _culling_statistics;
+    }
+
+
+    void Scene::setDepthPrePassEnabled(bool enabled)
+    {
+        _depth_pre_pass_enabled = enabled;
+    }
+
+
+    bool Scene::isDepthPrePassEnabled() const
+    {
+        return _depth_pre_pass_enabled;
+    }
+
+
+    void Scene::queryModels(const BoundingSphere &sphere, std::vector<Model *> &models) const
+    {
+        std::vector<uint32_t> packets;
+        _bvh.querySphere(sphere, packets);
+
+        // a model is reported once even if several of its submeshes touch the sphere
+        std::size_t first_model = models.size();
+        for (auto i : packets)
+            models.push_back(const_cast<Model *>(_scene_packets[i].model));
+
+        std::sort(models.begin() + first_model, models.end());
+        models.erase(std::unique(models.begin() + first_model, models.end()), models.end());
+    }
+
+
+    Model* Scene::pickModel(const glm::vec3 &origin, const glm::vec3 &direction, float max_distance) const
+    {
+        uint32_t packet = 0;
+        float distance = 0.0f;
+        if (!_bvh.raycast(origin, direction, max_distance, packet, distance))
+            return nullptr;
+
+        return const_cast<Model *>(_scene_packets[packet].model);
+    }
+
+
+    HostMemoryStatistics Scene::getHostMemoryStatistics() const
+    {
+        HostMemoryStatistics geometry = _model_manager->getHostMemoryStatistics();
+        HostMemoryStatistics textures = _texture_manager->getHostMemoryStatistics();
+
+        HostMemoryStatistics stats = {};
+        stats.resident_bytes = geometry.resident_bytes + textures.resident_bytes;
+        stats.reclaimed_bytes = geometry.reclaimed_bytes + textures.reclaimed_bytes;
+        return stats;
+    }
+
+
+    const ImportStatistics& Scene::getImportStatistics() const
+    {
+        return _model_manager->getImportStatistics();
+    }
+
+
+    void Scene::updateUniformData(VkExtent2D extent, float delta_time, uint32_t frame_index)
     {
         VV_ASSERT(_active_camera != nullptr, "ERROR: main camera has not been initialized");
 
@@ -179,66 +276,468 @@ namespace vv
             _lights_ubo.lights[i].position = glm::vec4(_lights[i]->getPosition(), 0.0f);
             _lights_ubo.lights[i].irradiance = _lights[i]->irradiance;
         }
-        _lights_uniform_buffer->updateAndTransfer(&_lights_ubo);
 
         _scene_ubo.view_mat = _active_camera->getViewMatrix();
         _scene_ubo.projection_mat = _active_camera->getProjectionMatrix(extent.width / static_cast<float>(extent.height));
         _scene_ubo.camera_position = glm::vec4(_active_camera->getPosition(), 1.0);
-        _scene_uniform_buffer->updateAndTransfer(&_scene_ubo);
 
         for (auto &m : _models)
-            m->updateModelUBO();
+        {
+            if (m->_has_moved)
+                m->updateModelUBO();
+        }
+
+        writeFrameUniforms(frame_index);
+
+        // the depth rendered with this camera is what next frame's occlusion test compares against
+        _previous_view_projection = _scene_ubo.projection_mat * _scene_ubo.view_mat;
+        _has_previous_frame = true;
     }
 
 
-    void Scene::render(VkCommandBuffer command_buffer)
+    void Scene::render(VulkanCommandEncoder &encoder, uint32_t frame_index)
     {
-        bool first_run = true;
-        MaterialTemplate *curr_template = nullptr;
+        // the skybox goes after the pre-pass, so it isn't shaded behind models either
+        if (_depth_pre_pass_enabled)
+            renderDepthPrePass(encoder, frame_index, 0, _draw_buckets.size());
 
-        if (_has_active_skybox)
+        renderSkyBox(encoder, frame_index);
+        renderModels(encoder, frame_index, 0, _draw_buckets.size());
+    }
+
+
+    void Scene::recordCulling(VkCommandBuffer command_buffer, uint32_t frame_index)
+    {
+        if (!usesGpuCulling())
+            return;
+
+        _culling_pass->recordCulling(command_buffer, _culling_uniform_offsets[frame_index], _instance_data_offsets[frame_index],
+                                     static_cast<uint32_t>(_instance_models.size()));
+    }
+
+
+    void Scene::recordDepthPyramid(VkCommandBuffer command_buffer)
+    {
+        if (usesGpuCulling() && Settings::inst()->isOcclusionCullingEnabled())
+            _culling_pass->recordDepthPyramid(command_buffer);
+    }
+
+
+    ///////////////////////////////////////////////////////////////////////////////////////////// Private
+    void Scene::writeFrameUniforms(uint32_t frame_index)
+    {
+        if (_draw_packets_dirty)
+            buildDrawPackets();
+        updateBoundingVolumes();
+        buildDrawBuckets();
+
+        // the fence for frame_index has been waited on, so its whole region can be handed out again
+        _uniform_ring_buffer->beginFrame(frame_index);
+
+        // instance data has to come first. its descriptor range covers a whole frame region starting at this offset.
+        VkDeviceSize instance_offset = 0;
+        std::size_t instance_count = _instance_models.size();
+        std::size_t draw_count = _draw_commands.size();
+        // sized for every packet, not just the visible ones. culling then never moves the offsets behind it, which
+        // command buffers recorded once keep using.
+        std::size_t instance_capacity = std::max(_scene_packets.size(), std::size_t(1));
+
+        if (usesGpuCulling())
+        {
+            // one block for the cull shader: compacted instances, then the unculled ones, their bounds and the draw commands
+            VkDeviceSize source_bytes = sizeof(ModelUBO) * instance_capacity;
+            VkDeviceSize bounds_bytes = source_bytes + sizeof(ModelUBO) * instance_count;
+            VkDeviceSize command_bytes = bounds_bytes + sizeof(glm::vec4) * 2 * instance_count;
+            VkDeviceSize block_size = command_bytes + sizeof(VkDrawIndexedIndirectCommand) * draw_count;
+            uint8_t *block = static_cast<uint8_t *>(_uniform_ring_buffer->allocate(block_size, instance_offset));
+
+            ModelUBO *source_data = reinterpret_cast<ModelUBO *>(block + source_bytes);
+            glm::vec4 *bounds_data = reinterpret_cast<glm::vec4 *>(block + bounds_bytes);
+            for (std::size_t i = 0; i < instance_count; ++i)
+            {
+                source_data[i] = _instance_models[i]->_model_ubo;
+                bounds_data[i * 2] = glm::vec4(_instance_bounds[i].getCenter(), 0.0f);
+                bounds_data[i * 2 + 1] = glm::vec4(_instance_bounds[i].getExtents(), glm::uintBitsToFloat(_instance_commands[i]));
+            }
+
+            // instanceCount starts at zero. every surviving instance adds itself.
+            if (draw_count > 0)
+                std::memcpy(block + command_bytes, _draw_commands.data(), sizeof(VkDrawIndexedIndirectCommand) * draw_count);
+            _draw_command_offsets[frame_index] = instance_offset + command_bytes;
+
+            CullingUniforms culling_uniforms = {};
+            const auto &planes = _frustum.getPlanes();
+            std::copy(planes.begin(), planes.end(), culling_uniforms.frustum_planes);
+            culling_uniforms.previous_view_projection = _previous_view_projection;
+            culling_uniforms.pyramid_extent = glm::vec4(_culling_pass->getPyramidExtent().width, _culling_pass->getPyramidExtent().height,
+                                                        _culling_pass->getPyramidLevelCount(), 0.0f);
+            culling_uniforms.instance_count = static_cast<uint32_t>(instance_count);
+            culling_uniforms.source_offset = static_cast<uint32_t>(instance_capacity);
+            culling_uniforms.bounds_offset = static_cast<uint32_t>(bounds_bytes / sizeof(glm::vec4));
+            culling_uniforms.command_offset = static_cast<uint32_t>(command_bytes / sizeof(uint32_t));
+            culling_uniforms.occlusion_enabled = (Settings::inst()->isOcclusionCullingEnabled() && _has_previous_frame) ? 1 : 0;
+            _culling_uniform_offsets[frame_index] = static_cast<uint32_t>(_uniform_ring_buffer->write(&culling_uniforms, sizeof(CullingUniforms)));
+        }
+        else
+        {
+            ModelUBO *instance_data = static_cast<ModelUBO *>(_uniform_ring_buffer->allocate(sizeof(ModelUBO) * instance_capacity, instance_offset));
+            for (std::size_t i = 0; i < instance_count; ++i)
+                instance_data[i] = _instance_models[i]->_model_ubo;
+        }
+        _instance_data_offsets[frame_index] = static_cast<uint32_t>(instance_offset);
+
+        _scene_ubo_offsets[frame_index] = static_cast<uint32_t>(_uniform_ring_buffer->write(&_scene_ubo, sizeof(SceneUBO)));
+        _lights_ubo_offsets[frame_index] = static_cast<uint32_t>(_uniform_ring_buffer->write(&_lights_ubo, sizeof(LightUBO)));
+
+        if (draw_count > 0 && !usesGpuCulling())
+            _draw_command_offsets[frame_index] = _uniform_ring_buffer->write(_draw_commands.data(), sizeof(VkDrawIndexedIndirectCommand) * draw_count);
+
+        // every command of a bucket is counted. culling works through instanceCount instead, set by the cpu above or
+        // by the cull shader, so a command with no visible instances is simply empty.
+        if (_device->cmd_draw_indexed_indirect_count && !_draw_buckets.empty())
+        {
+            VkDeviceSize count_offset = 0;
+            uint32_t *counts = static_cast<uint32_t *>(_uniform_ring_buffer->allocate(sizeof(uint32_t) * _draw_buckets.size(), count_offset));
+            for (std::size_t i = 0; i < _draw_buckets.size(); ++i)
+                counts[i] = _draw_buckets[i].draw_count;
+            _draw_count_offsets[frame_index] = count_offset;
+        }
+    }
+
+
+    void Scene::buildDrawPackets()
+    {
+        // small dense ids keep the sort key compact. handed out in first use order, so they are stable between rebuilds.
+        std::unordered_map<const void *, uint32_t> pipeline_ids, material_ids, mesh_ids;
+        auto getId = [](std::unordered_map<const void *, uint32_t> &ids, const void *object) {
+            auto it = ids.find(object);
+            if (it != ids.end())
+                return it->second;
+            uint32_t id = static_cast<uint32_t>(ids.size());
+            ids[object] = id;
+            return id;
+        };
+
+        _scene_packets.clear();
+        _model_packets.clear();
+        for (const auto &model : _models)
+        {
+            _model_packets.push_back(std::make_pair(static_cast<uint32_t>(_scene_packets.size()), 0u));
+            const auto &materials = _model_manager->_loaded_materials.at(model->_data_handle).at(model->_material_id_set);
+            for (const auto &mesh : _model_manager->_loaded_meshes.at(model->_data_handle))
+            {
+                DrawPacket packet = {};
+                packet.material_template = model->material_template;
+                packet.material = materials[mesh->material_id];
+                packet.mesh = mesh;
+                packet.model = model;
+
+                // depth is filled in every frame
+                packet.sort_key = RenderQueue::createSortKey(DrawPass::Opaque, getId(pipeline_ids, packet.material_template),
+                                                             getId(material_ids, packet.material), mesh->getGeometryRange().page,
+                                                             getId(mesh_ids, mesh), 0.0f);
+                _scene_packets.push_back(packet);
+                ++_model_packets.back().second;
+            }
+
+            // packet indices changed. every packet gets a new leaf in updateBoundingVolumes().
+            model->_has_moved = true;
+        }
+
+        _bvh.clear();
+        _packet_proxies.assign(_scene_packets.size(), BoundingVolumeHierarchy::null_proxy);
+        _packet_spheres.resize(_scene_packets.size());
+
+        _draw_packets_dirty = false;
+    }
+
+
+    void Scene::updateBoundingVolumes()
+    {
+        for (std::size_t m = 0; m < _models.size(); ++m)
+        {
+            Model *model = _models[m];
+            if (!model->_has_moved)
+                continue;
+
+            const glm::mat4 &model_mat = model->_model_ubo.model_mat;
+            uint32_t first_packet = _model_packets[m].first;
+            for (uint32_t i = first_packet; i < first_packet + _model_packets[m].second; ++i)
+            {
+                const Mesh *mesh = _scene_packets[i].mesh;
+                AABB box = mesh->getBoundingBox().transform(model_mat);
+                _packet_spheres[i] = mesh->getBoundingSphere().transform(model_mat);
+
+                if (_packet_proxies[i] == BoundingVolumeHierarchy::null_proxy)
+                    _packet_proxies[i] = _bvh.insert(box, i);
+                else
+                    _bvh.refit(_packet_proxies[i], box);
+            }
+
+            model->_has_moved = false;
+        }
+    }
+
+
+    void Scene::buildDrawBuckets()
+    {
+        // sort keys only differ in depth from frame to frame, which only reorders instances of the same mesh. bucket
+        // and command layout stay the same, so pre-recorded command buffers remain valid.
+        _render_queue.clear();
+
+        glm::mat4 view_mat = _has_active_camera ? _active_camera->getViewMatrix() : glm::mat4();
+        float far_plane = _has_active_camera ? _active_camera->getFarPlane() : 1.0f;
+
+        // the sphere gives the depth of the nearest point for sorting
+        std::size_t packet_count = _scene_packets.size();
+        std::vector<float> packet_depths(packet_count);
+        for (std::size_t i = 0; i < packet_count; ++i)
         {
-            auto skybox_template = material_templates["skybox"];
-            skybox_template->pipeline->bind(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS);
-            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, skybox_template->pipeline_layout, 0, 1, &_scene_descriptor_sets[0], 0, nullptr);
+            const BoundingSphere &sphere = _packet_spheres[i];
+            packet_depths[i] = (-(view_mat * glm::vec4(sphere.center, 1.0f)).z - sphere.radius) / far_plane;
+        }
+
+        // draws baked into pre-recorded command buffers can't change. everything has to stay visible for those.
+        // the gpu culls on its own and needs every instance.
+        bool cull = Settings::inst()->isFrustumCullingEnabled() && (usesIndirectDraws() || Settings::inst()->isPerFrameRecordingEnabled()) &&
+                    !usesGpuCulling();
+        _frustum.update(_scene_ubo.projection_mat * _scene_ubo.view_mat);
+        if (cull)
+        {
+            _inside_packets.clear();
+            _intersecting_packets.clear();
+            _bvh.queryFrustum(_frustum, _inside_packets, _intersecting_packets);
+
+            _packet_visibility.assign(packet_count, 0);
+            for (auto i : _inside_packets)
+                _packet_visibility[i] = 1;
 
-            _active_skybox->bindSkyBoxDescriptorSets(command_buffer, skybox_template->pipeline_layout);
-            _active_skybox->render(command_buffer);
+            _cull_bounds.resize(_intersecting_packets.size());
+            for (std::size_t j = 0; j < _intersecting_packets.size(); ++j)
+                _cull_bounds.set(j, _bvh.getBox(_packet_proxies[_intersecting_packets[j]]));
+
+            _frustum.cull(_cull_bounds, _intersecting_visibility);
+            for (std::size_t j = 0; j < _intersecting_packets.size(); ++j)
+                _packet_visibility[_intersecting_packets[j]] = _intersecting_visibility[j];
         }
+        else
+            _packet_visibility.assign(packet_count, 1);
 
-        int i = 0;
         for (auto &model : _models)
+            model->_is_visible = false;
+
+        _culling_statistics = CullingStatistics();
+        for (std::size_t i = 0; i < packet_count; ++i)
         {
-            // reduce pipeline state switches as much as possible
-            if (first_run || (curr_template->name != model->material_template->name))
+            DrawPacket packet = _scene_packets[i];
+            packet.sort_key = RenderQueue::setSortKeyDepth(packet.sort_key, packet_depths[i]);
+            packet.is_visible = _packet_visibility[i] != 0;
+            _render_queue.push(packet);
+
+            if (packet.is_visible)
             {
-                first_run = false;
-                curr_template = model->material_template;
-                curr_template->pipeline->bind(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS);
+                const_cast<Model *>(packet.model)->_is_visible = true;
+                ++_culling_statistics.visible_count;
             }
+            else
+                ++_culling_statistics.culled_count;
+        }
+
+        _render_queue.sort();
 
-            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, curr_template->pipeline_layout, 0, 1, &_scene_descriptor_sets[i++], 0, nullptr);
+        _draw_buckets.clear();
+        _draw_commands.clear();
+        _instance_models.clear();
+        _instance_commands.clear();
+        _instance_bounds.clear();
 
-            // Bind environment lighting descriptor sets
-            if (model->material_template->uses_environment_lighting)
+        bool gpu_culling = usesGpuCulling();
+        const Mesh *prev_mesh = nullptr;
+        for (std::size_t i = 0; i < _render_queue.size(); ++i)
+        {
+            const DrawPacket &packet = _render_queue[i];
+            const GeometryRange &range = packet.mesh->getGeometryRange();
+
+            if (_draw_buckets.empty() || _draw_buckets.back().material_template != packet.material_template ||
+                _draw_buckets.back().material != packet.material || _draw_buckets.back().geometry_page != range.page)
             {
-                _active_skybox->bindIBLDescriptorSets(command_buffer, curr_template->pipeline_layout);
-                _active_skybox->submitMipLevelPushConstants(command_buffer, curr_template->pipeline_layout);
+                DrawBucket bucket = {};
+                bucket.material_template = packet.material_template;
+                bucket.material = packet.material;
+                bucket.geometry_page = range.page;
+                bucket.first_draw = static_cast<uint32_t>(_draw_commands.size());
+                _draw_buckets.push_back(bucket);
+                prev_mesh = nullptr;
             }
 
-            // Render all submeshes within this model
-            for (auto &mesh : _model_manager->_loaded_meshes[model->_data_handle])
+            // another copy of the mesh drawn last is the next entry of the same instance range
+            if (packet.mesh != prev_mesh)
+            {
+                VkDrawIndexedIndirectCommand command = {};
+                command.indexCount = range.index_count;
+                command.instanceCount = 0;
+                command.firstIndex = range.first_index;
+                command.vertexOffset = range.vertex_offset;
+                command.firstInstance = static_cast<uint32_t>(_instance_models.size());
+
+                _draw_commands.push_back(command);
+                ++_draw_buckets.back().draw_count;
+                prev_mesh = packet.mesh;
+            }
+
+            // culled instances are left out of the instance data. commands stay in place with fewer instances.
+            if (!packet.is_visible)
+                continue;
+
+            _instance_models.push_back(packet.model);
+
+            // the gpu fills instanceCount in itself
+            if (gpu_culling)
             {
-                Material *material = _model_manager->_loaded_materials[model->_data_handle][model->_material_id_set][mesh->material_id];
-                material->bindDescriptorSets(command_buffer);
-                mesh->bindBuffers(command_buffer);
-                mesh->render(command_buffer);
+                _instance_commands.push_back(static_cast<uint32_t>(_draw_commands.size() - 1));
+                _instance_bounds.push_back(packet.mesh->getBoundingBox().transform(packet.model->_model_ubo.model_mat));
             }
+            else
+                ++_draw_commands.back().instanceCount;
+        }
+    }
+
+
+    void Scene::renderDepthPrePass(VulkanCommandEncoder &encoder, uint32_t frame_index, std::size_t first_bucket, std::size_t bucket_count)
+    {
+        std::array<uint32_t, 3> dynamic_offsets = { _scene_ubo_offsets[frame_index], _instance_data_offsets[frame_index], _lights_ubo_offsets[frame_index] };
+
+        encoder.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, _depth_pipeline->pipeline);
+        encoder.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, _depth_pipeline_layout, 0, 1, &_scene_descriptor_set,
+                                   static_cast<uint32_t>(dynamic_offsets.size()), dynamic_offsets.data());
+
+        // materials don't matter here. buckets only differ in geometry page and draws.
+        for (std::size_t i = first_bucket; i < first_bucket + bucket_count; ++i)
+        {
+            _model_manager->_geometry_buffer->bind(encoder, _draw_buckets[i].geometry_page);
+            drawBucket(encoder, frame_index, i);
+        }
+    }
+
+
+    void Scene::renderSkyBox(VulkanCommandEncoder &encoder, uint32_t frame_index)
+    {
+        if (_has_active_skybox)
+        {
+            auto skybox_template = material_templates.at("skybox");
+            encoder.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, skybox_template->pipeline->pipeline);
+            // the skybox never reads instance data, binding 1 is only bound to satisfy the layout
+            std::array<uint32_t, 3> dynamic_offsets = { _scene_ubo_offsets[frame_index], _instance_data_offsets[frame_index], _lights_ubo_offsets[frame_index] };
+            encoder.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, skybox_template->pipeline_layout, 0, 1, &_scene_descriptor_set,
+                                       static_cast<uint32_t>(dynamic_offsets.size()), dynamic_offsets.data());
+
+            _active_skybox->bindSkyBoxDescriptorSets(encoder, skybox_template->pipeline_layout);
+            _active_skybox->render(encoder);
+        }
+    }
+
+
+    void Scene::renderModels(VulkanCommandEncoder &encoder, uint32_t frame_index, std::size_t first_bucket, std::size_t bucket_count)
+    {
+        // note: this may be called concurrently from several recording threads. only read shared state in here.
+        std::array<uint32_t, 3> dynamic_offsets = { _scene_ubo_offsets[frame_index], _instance_data_offsets[frame_index], _lights_ubo_offsets[frame_index] }; // ordered by binding
+
+        MaterialTemplate *curr_template = nullptr;
+
+        for (std::size_t i = first_bucket; i < first_bucket + bucket_count; ++i)
+        {
+            const DrawBucket &bucket = _draw_buckets[i];
+
+            // buckets are sorted by template, so every pipeline is bound once per command buffer
+            if (bucket.material_template != curr_template)
+            {
+                curr_template = bucket.material_template;
+                VulkanPipeline *pipeline = (_depth_pre_pass_enabled && curr_template->depth_equal_pipeline) ? curr_template->depth_equal_pipeline : curr_template->pipeline;
+                encoder.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipeline);
+
+                // same descriptor set for every draw. draws find their instance data through gl_InstanceIndex.
+                encoder.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, curr_template->pipeline_layout, 0, 1, &_scene_descriptor_set,
+                                           static_cast<uint32_t>(dynamic_offsets.size()), dynamic_offsets.data());
+
+                if (curr_template->uses_bindless_materials)
+                    _material_table->bind(encoder, curr_template->pipeline_layout);
+
+                // Bind environment lighting descriptor sets
+                if (curr_template->uses_environment_lighting)
+                {
+                    _active_skybox->bindIBLDescriptorSets(encoder, curr_template->pipeline_layout);
+                    _active_skybox->submitMipLevelPushConstants(encoder, curr_template->pipeline_layout,
+                                                                curr_template->shader->getPushConstantStages(0, sizeof(uint32_t)));
+                }
+            }
+
+            // the encoder drops these when consecutive buckets share a material or geometry page, which is the common case
+            bucket.material->bind(encoder);
+            _model_manager->_geometry_buffer->bind(encoder, bucket.geometry_page);
+
+            drawBucket(encoder, frame_index, i);
+        }
+    }
+
+
+    bool Scene::usesIndirectDraws() const
+    {
+        // indirect commands may only use a non zero firstInstance with drawIndirectFirstInstance
+        return Settings::inst()->isIndirectDrawingEnabled() && _device->physical_device_features.drawIndirectFirstInstance;
+    }
+
+
+    bool Scene::usesGpuCulling() const
+    {
+        return _culling_pass != nullptr;
+    }
+
+
+    bool Scene::usesBindlessMaterials() const
+    {
+        return _material_table != nullptr;
+    }
+
+
+    void Scene::drawBucket(VulkanCommandEncoder &encoder, uint32_t frame_index, std::size_t bucket_index) const
+    {
+        VkCommandBuffer command_buffer = encoder.command_buffer;
+        const DrawBucket &bucket = _draw_buckets[bucket_index];
+        const VkPhysicalDeviceFeatures &features = _device->physical_device_features;
+        const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+        if (!usesIndirectDraws())
+        {
+            for (uint32_t i = bucket.first_draw; i < bucket.first_draw + bucket.draw_count; ++i)
+            {
+                const VkDrawIndexedIndirectCommand &c = _draw_commands[i];
+                if (c.instanceCount == 0)
+                    continue; // every instance was culled
+
+                vkCmdDrawIndexed(command_buffer, c.indexCount, c.instanceCount, c.firstIndex, c.vertexOffset, c.firstInstance);
+            }
+            return;
+        }
+
+        VkBuffer buffer = _uniform_ring_buffer->buffer;
+        VkDeviceSize offset = _draw_command_offsets[frame_index] + bucket.first_draw * stride;
+
+        if (_device->cmd_draw_indexed_indirect_count)
+        {
+            VkDeviceSize count_offset = _draw_count_offsets[frame_index] + bucket_index * sizeof(uint32_t);
+            _device->cmd_draw_indexed_indirect_count(command_buffer, buffer, offset, buffer, count_offset, bucket.draw_count, stride);
+        }
+        else if (features.multiDrawIndirect)
+            vkCmdDrawIndexedIndirect(command_buffer, buffer, offset, bucket.draw_count, stride);
+        else
+        {
+            // without multiDrawIndirect every indirect call is limited to a single draw
+            for (uint32_t i = 0; i < bucket.draw_count; ++i)
+                vkCmdDrawIndexedIndirect(command_buffer, buffer, offset + i * stride, 1, stride);
         }
     }
 
 
-    ///////////////////////////////////////////////////////////////////////////////////////////// Private
     void Scene::createMaterialTemplates()
     {
         std::string shader_file = Settings::inst()->getShaderDirectory() + "shader_info.txt";
@@ -255,9 +754,10 @@ namespace vv
 
             // Construct shader
             Shader *shader = new Shader();
-            shader->create(_device, material_template->name);
+            shader->create(_device, material_template->name, usesBindlessMaterials());
             material_template->shader = shader;
             material_template->uses_environment_lighting = shader->uses_environmental_lighting;
+            material_template->uses_bindless_materials = shader->uses_bindless_materials;
 
             // Construct Descriptor Set Layouts
             std::vector<VkDescriptorSetLayout> descriptor_set_layouts;
@@ -265,6 +765,12 @@ namespace vv
 
             if (curr_shader_name == "skybox")
                 descriptor_set_layouts.push_back(_radiance_descriptor_set_layout);
+            else if (material_template->uses_bindless_materials)
+            {
+                descriptor_set_layouts.push_back(_material_table->descriptor_set_layout);
+                if (material_template->uses_environment_lighting)
+                    descriptor_set_layouts.push_back(_environment_descriptor_set_layout);
+            }
             else
             {
                 std::vector<VkDescriptorSetLayoutBinding> temp_bindings_buffer;
@@ -296,7 +802,14 @@ namespace vv
             if (curr_shader_name == "skybox")
                 pipeline->create(_device, material_template->shader, material_template->pipeline_layout, _render_pass, VK_FRONT_FACE_CLOCKWISE, true, true); // todo: add option for settings passed.
             else
+            {
                 pipeline->create(_device, material_template->shader, material_template->pipeline_layout, _render_pass, VK_FRONT_FACE_COUNTER_CLOCKWISE, true, true);
+
+                // identical except for depth state, so both can be switched between at record time
+                material_template->depth_equal_pipeline = new VulkanPipeline();
+                material_template->depth_equal_pipeline->create(_device, material_template->shader, material_template->pipeline_layout, _render_pass,
+                                                                VK_FRONT_FACE_COUNTER_CLOCKWISE, true, false, VK_COMPARE_OP_EQUAL);
+            }
             material_template->pipeline = pipeline;
 
             // Finished
@@ -308,13 +821,35 @@ namespace vv
     }
 
 
+    void Scene::createDepthPrePassPipeline()
+    {
+        _depth_shader = new Shader();
+        _depth_shader->createVertexOnly(_device, "depth");
+
+        VkPipelineLayoutCreateInfo pipeline_layout_create_info = {};
+        pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipeline_layout_create_info.flags = 0;
+        pipeline_layout_create_info.setLayoutCount = 1;
+        pipeline_layout_create_info.pSetLayouts = &_scene_descriptor_set_layout;
+
+        VV_CHECK_SUCCESS(vkCreatePipelineLayout(_device->logical_device, &pipeline_layout_create_info, nullptr, &_depth_pipeline_layout));
+
+        _depth_pipeline = new VulkanPipeline();
+        _depth_pipeline->create(_device, _depth_shader, _depth_pipeline_layout, _render_pass, VK_FRONT_FACE_COUNTER_CLOCKWISE, true, true);
+    }
+
+
     void Scene::createDescriptorPool()
     {
-        std::array<VkDescriptorPoolSize, 2> pool_sizes = {};
+        std::array<VkDescriptorPoolSize, 4> pool_sizes = {};
         pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         pool_sizes[0].descriptorCount = Settings::inst()->getMaxUniformBuffers();
         pool_sizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         pool_sizes[1].descriptorCount = Settings::inst()->getMaxCombinedImageSamplers();
+        pool_sizes[2].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        pool_sizes[2].descriptorCount = Settings::inst()->getMaxDynamicUniformBuffers();
+        pool_sizes[3].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+        pool_sizes[3].descriptorCount = Settings::inst()->getMaxDynamicStorageBuffers();
 
         VkDescriptorPoolCreateInfo create_info = {};
         create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -332,26 +867,46 @@ namespace vv
     {
         // MVP matrix data
         _scene_ubo = { glm::mat4(), glm::mat4(), glm::vec4() };
-        _scene_uniform_buffer = new VulkanBuffer();
-        _scene_uniform_buffer->create(_device, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(SceneUBO));
 
         // Lights data
         for (auto i = 0; i < VV_MAX_LIGHTS; ++i)
             _lights_ubo.lights[i] = { glm::vec4(), glm::vec4() };
 
-        _lights_uniform_buffer = new VulkanBuffer();
-        _lights_uniform_buffer->create(_device, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(LightUBO));
+        // one region per frame in flight so the cpu never overwrites data the gpu might still be reading
+        _uniform_ring_buffer = new VulkanRingBuffer();
+        _uniform_ring_buffer->create(_device, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                                     Settings::inst()->getUniformRingBufferSize(), _frame_count);
+
+        // offsets have to be valid before the first update since command buffers may be recorded ahead of it
+        _scene_ubo_offsets.resize(_frame_count);
+        _lights_ubo_offsets.resize(_frame_count);
+        _instance_data_offsets.resize(_frame_count);
+        _draw_command_offsets.resize(_frame_count);
+        _draw_count_offsets.resize(_frame_count);
+        _culling_uniform_offsets.resize(_frame_count);
+
+        // reads its instances, bounds and draw commands straight out of the ring buffer
+        if (Settings::inst()->isGpuCullingEnabled() && usesIndirectDraws())
+        {
+            _culling_pass = new CullingPass();
+            _culling_pass->create(_device, _swap_chain, _uniform_ring_buffer);
+        }
+
+        for (uint32_t i = 0; i < _frame_count; ++i)
+            writeFrameUniforms(i);
 
         /// Layout
         std::vector<VkDescriptorSetLayoutBinding> temp_bindings_buffer;
-        temp_bindings_buffer.push_back(createDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT));
-        temp_bindings_buffer.push_back(createDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT));
-        temp_bindings_buffer.push_back(createDescriptorSetLayoutBinding(2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT));
+        temp_bindings_buffer.push_back(createDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_VERTEX_BIT));
+        temp_bindings_buffer.push_back(createDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_VERTEX_BIT));
+        temp_bindings_buffer.push_back(createDescriptorSetLayoutBinding(2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_FRAGMENT_BIT));
         createVulkanDescriptorSetLayout(_device->logical_device, temp_bindings_buffer, _scene_descriptor_set_layout);
+
+        allocateSceneDescriptorSet();
     }
 
 
-    void Scene::allocateSceneDescriptorSets()
+    void Scene::allocateSceneDescriptorSet()
     {
 		VkDescriptorSetAllocateInfo scene_alloc_info = {};
 		scene_alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
@@ -359,54 +914,36 @@ namespace vv
 		scene_alloc_info.descriptorSetCount = 1;
 		scene_alloc_info.pSetLayouts = &_scene_descriptor_set_layout;
 
-        _scene_descriptor_sets.resize(_models.size());
+		VV_CHECK_SUCCESS(vkAllocateDescriptorSets(_device->logical_device, &scene_alloc_info, &_scene_descriptor_set));
+
+        // every binding points at the ring buffer. the actual location is supplied per frame through dynamic offsets.
+        std::array<VkDescriptorBufferInfo, 3> buffer_infos = {};
+        buffer_infos[0].buffer = _uniform_ring_buffer->buffer;
+        buffer_infos[0].offset = 0;
+        buffer_infos[0].range = sizeof(SceneUBO);
 
-        for (int i = 0; i < _models.size(); ++i)
+        // instance data of all draws. spans a whole frame region since the number of draws isn't fixed.
+        buffer_infos[1].buffer = _uniform_ring_buffer->buffer;
+        buffer_infos[1].offset = 0;
+        buffer_infos[1].range = _uniform_ring_buffer->getFrameSize();
+
+        buffer_infos[2].buffer = _uniform_ring_buffer->buffer;
+        buffer_infos[2].offset = 0;
+        buffer_infos[2].range = sizeof(LightUBO);
+
+        std::array<VkWriteDescriptorSet, 3> write_sets = {};
+        for (uint32_t i = 0; i < write_sets.size(); ++i)
         {
-		    VV_CHECK_SUCCESS(vkAllocateDescriptorSets(_device->logical_device, &scene_alloc_info, &_scene_descriptor_sets[i]));
-            std::array<VkWriteDescriptorSet, 3> write_sets;
-
-		    VkDescriptorBufferInfo scene_buffer_info = {};
-		    scene_buffer_info.buffer = _scene_uniform_buffer->buffer;
-		    scene_buffer_info.offset = 0;
-		    scene_buffer_info.range = sizeof(SceneUBO);
-
-		    write_sets[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		    write_sets[0].dstSet = _scene_descriptor_sets[i];
-		    write_sets[0].dstBinding = 0;
-		    write_sets[0].dstArrayElement = 0;
-		    write_sets[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		    write_sets[0].descriptorCount = 1; // how many elements to update
-		    write_sets[0].pBufferInfo = &scene_buffer_info;
-
-            VkDescriptorBufferInfo lights_buffer_info = {};
-		    lights_buffer_info.buffer = _lights_uniform_buffer->buffer;
-		    lights_buffer_info.offset = 0;
-            lights_buffer_info.range = sizeof(LightUBO);
-
-		    write_sets[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		    write_sets[1].dstSet = _scene_descriptor_sets[i];
-		    write_sets[1].dstBinding = 2;
-		    write_sets[1].dstArrayElement = 0;
-		    write_sets[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		    write_sets[1].descriptorCount = 1;
-		    write_sets[1].pBufferInfo = &lights_buffer_info;
-
-            VkDescriptorBufferInfo model_buffer_info = {};
-		    model_buffer_info.buffer = _models[i]->_model_uniform_buffer->buffer;
-		    model_buffer_info.offset = 0;
-		    model_buffer_info.range = sizeof(ModelUBO);
-
-            write_sets[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		    write_sets[2].dstSet = _scene_descriptor_sets[i];
-		    write_sets[2].dstBinding = 1;
-		    write_sets[2].dstArrayElement = 0;
-		    write_sets[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		    write_sets[2].descriptorCount = 1;
-		    write_sets[2].pBufferInfo = &model_buffer_info;
-		
-            vkUpdateDescriptorSets(_device->logical_device, 3, write_sets.data(), 0, nullptr);
+		    write_sets[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		    write_sets[i].dstSet = _scene_descriptor_set;
+		    write_sets[i].dstBinding = i;
+		    write_sets[i].dstArrayElement = 0;
+		    write_sets[i].descriptorType = (i == 1) ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		    write_sets[i].descriptorCount = 1;
+		    write_sets[i].pBufferInfo = &buffer_infos[i];
         }
+
+        vkUpdateDescriptorSets(_device->logical_device, static_cast<uint32_t>(write_sets.size()), write_sets.data(), 0, nullptr);
     }
 
 
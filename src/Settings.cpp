@@ -1,6 +1,9 @@
 
 #include "Settings.h"
 
+#include <algorithm>
+#include <thread>
+
 namespace vv
 {
     Settings* Settings::instance_ = nullptr;
@@ -36,6 +39,70 @@ namespace vv
         _max_descriptor_sets = 100;
         _max_uniform_buffers = 100;
         _max_combined_image_samplers = 100;
+        _max_dynamic_uniform_buffers = 100;
+        _max_dynamic_storage_buffers = 10;
+
+        // bytes of streamed uniform data available to each frame in flight
+        _uniform_ring_buffer_size = 4 * 1024 * 1024;
+
+        // size of the device memory blocks resources are sub-allocated from. capped to 1/8th of small heaps.
+        _memory_block_size = 64 * 1024 * 1024;
+
+        // bytes of copies recorded into one transfer submission before it is sent off without an explicit flush
+        _upload_batch_size = 32 * 1024 * 1024;
+
+        // host visible memory shared by all pending uploads. recycled as upload batches complete.
+        _staging_arena_size = 64 * 1024 * 1024;
+
+        // bytes of each shared vertex and index buffer static geometry is packed into
+        _geometry_buffer_size = 32 * 1024 * 1024;
+
+        // capacity of the shared texture array and material buffer every bindless material is indexed from
+        _max_bindless_textures = 4096;
+        _max_bindless_materials = 4096;
+
+        // number of frames the cpu is allowed to record/update ahead of the gpu.
+        // each frame in flight owns its own sync primitives and copies of all per-frame uniform data.
+        _max_frames_in_flight = 2;
+
+        // when enabled, command buffers are re-recorded every frame from transient pools instead of once at startup.
+        // this is required for any per-frame decision (late model additions, culling, sorting) to reach the gpu.
+        _per_frame_recording = false;
+        _recording_budget = 2.0f; // milliseconds
+
+        // worker threads used to record secondary command buffers in parallel. 1 records everything inline.
+        _recording_thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+        // worker threads parsing model files. read when the scene is created.
+        _import_thread_count = std::max(1u, std::thread::hardware_concurrency());
+        _report_frame_statistics = false;
+
+        // submit each material bucket with one indirect draw instead of one vkCmdDrawIndexed per submesh.
+        // falls back to direct draws when the device can't offset instance indices from indirect commands.
+        _indirect_drawing = true;
+
+        // skip submeshes whose bounds are outside the camera frustum. only takes effect when draws aren't baked into
+        // pre-recorded command buffers, i.e. with indirect drawing or per frame recording.
+        _frustum_culling = true;
+
+        // cull instances in a compute pass right before drawing instead. needs indirect drawing, replaces the cpu test.
+        _gpu_culling = true;
+
+        // also skip instances hidden behind the depth of the previous frame. only read when gpu culling is active.
+        // note: read at startup, since it decides whether depth is kept after the render pass.
+        _occlusion_culling = true;
+
+        // bind all material textures and parameters once through descriptor indexing instead of one descriptor set per
+        // material. falls back to per material sets when the device lacks descriptor indexing. read at startup.
+        _bindless_materials = true;
+
+        // lay down depth with a position only pipeline first, so the main pass shades every pixel at most once.
+        // only the default for new scenes, each scene can toggle it on its own.
+        _depth_pre_pass = false;
+
+        // keep the final vertex and index arrays of imported models in a .vvmesh file next to the source and map that
+        // on later loads. stale caches are detected by a hash of the source files and rewritten.
+        _mesh_cache = true;
     }
 
 
@@ -111,6 +178,138 @@ namespace vv
     }
 
 
+    uint32_t Settings::getMaxDynamicUniformBuffers() const
+    {
+        return _max_dynamic_uniform_buffers;
+    }
+
+
+    uint32_t Settings::getMaxDynamicStorageBuffers() const
+    {
+        return _max_dynamic_storage_buffers;
+    }
+
+
+    uint32_t Settings::getUniformRingBufferSize() const
+    {
+        return _uniform_ring_buffer_size;
+    }
+
+
+    uint32_t Settings::getMemoryBlockSize() const
+    {
+        return _memory_block_size;
+    }
+
+
+    uint32_t Settings::getUploadBatchSize() const
+    {
+        return _upload_batch_size;
+    }
+
+
+    uint32_t Settings::getStagingArenaSize() const
+    {
+        return _staging_arena_size;
+    }
+
+
+    uint32_t Settings::getGeometryBufferSize() const
+    {
+        return _geometry_buffer_size;
+    }
+
+
+    uint32_t Settings::getMaxBindlessTextures() const
+    {
+        return _max_bindless_textures;
+    }
+
+
+    uint32_t Settings::getMaxBindlessMaterials() const
+    {
+        return _max_bindless_materials;
+    }
+
+
+    uint32_t Settings::getMaxFramesInFlight() const
+    {
+        return _max_frames_in_flight;
+    }
+
+
+    bool Settings::isPerFrameRecordingEnabled() const
+    {
+        return _per_frame_recording;
+    }
+
+
+    float Settings::getRecordingBudget() const
+    {
+        return _recording_budget;
+    }
+
+
+    uint32_t Settings::getRecordingThreadCount() const
+    {
+        return _recording_thread_count;
+    }
+
+
+    uint32_t Settings::getImportThreadCount() const
+    {
+        return _import_thread_count;
+    }
+
+
+    bool Settings::isFrameStatisticsReportingEnabled() const
+    {
+        return _report_frame_statistics;
+    }
+
+
+    bool Settings::isIndirectDrawingEnabled() const
+    {
+        return _indirect_drawing;
+    }
+
+
+    bool Settings::isFrustumCullingEnabled() const
+    {
+        return _frustum_culling;
+    }
+
+
+    bool Settings::isGpuCullingEnabled() const
+    {
+        return _gpu_culling;
+    }
+
+
+    bool Settings::isOcclusionCullingEnabled() const
+    {
+        return _occlusion_culling;
+    }
+
+
+    bool Settings::isBindlessMaterialsEnabled() const
+    {
+        return _bindless_materials;
+    }
+
+
+    bool Settings::isDepthPrePassEnabled() const
+    {
+        return _depth_pre_pass;
+    }
+
+
+    bool Settings::isMeshCacheEnabled() const
+    {
+        return _mesh_cache;
+    }
+
+
     bool Settings::isComputeRequired() const
     {
         return _compute_required;
@@ -129,5 +328,77 @@ namespace vv
     }
 
 
+    void Settings::setMaxFramesInFlight(uint32_t frame_count)
+    {
+        _max_frames_in_flight = std::max(1u, frame_count);
+    }
+
+
+    void Settings::setPerFrameRecordingEnabled(bool enabled)
+    {
+        _per_frame_recording = enabled;
+    }
+
+
+    void Settings::setFrameStatisticsReportingEnabled(bool enabled)
+    {
+        _report_frame_statistics = enabled;
+    }
+
+
+    void Settings::setRecordingThreadCount(uint32_t thread_count)
+    {
+        _recording_thread_count = std::max(1u, thread_count);
+    }
+
+
+    void Settings::setImportThreadCount(uint32_t thread_count)
+    {
+        _import_thread_count = std::max(1u, thread_count);
+    }
+
+
+    void Settings::setIndirectDrawingEnabled(bool enabled)
+    {
+        _indirect_drawing = enabled;
+    }
+
+
+    void Settings::setFrustumCullingEnabled(bool enabled)
+    {
+        _frustum_culling = enabled;
+    }
+
+
+    void Settings::setGpuCullingEnabled(bool enabled)
+    {
+        _gpu_culling = enabled;
+    }
+
+
+    void Settings::setOcclusionCullingEnabled(bool enabled)
+    {
+        _occlusion_culling = enabled;
+    }
+
+
+    void Settings::setBindlessMaterialsEnabled(bool enabled)
+    {
+        _bindless_materials = enabled;
+    }
+
+
+    void Settings::setDepthPrePassEnabled(bool enabled)
+    {
+        _depth_pre_pass = enabled;
+    }
+
+
+    void Settings::setMeshCacheEnabled(bool enabled)
+    {
+        _mesh_cache = enabled;
+    }
+
+
     ///////////////////////////////////////////////////////////////////////////////////////////// Private
 }
\ No newline at end of file
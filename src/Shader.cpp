@@ -6,6 +6,7 @@
 
 #include "Shader.h"
 #include "Utils.h"
+#include "MappedFile.h"
 
 namespace vv
 {
@@ -29,22 +30,48 @@ namespace vv
     }
 
 
-	void Shader::create(VulkanDevice *device, std::string name)
+	void Shader::create(VulkanDevice *device, std::string name, bool bindless_materials)
 	{
 		_device = device;
-		_name = name;
+        loadPrograms(name, bindless_materials);
 
-        std::string dir = Settings::inst()->getShaderDirectory();
+        // spirv-cross only runs for programs that weren't cooked since they were last compiled
+        if (!loadReflection())
+            reflect();
 
-		_vert_path = dir + name + "_vert" + ".spv";
-		_frag_path = dir + name + "_frag" + ".spv";
-        _vert_binary_data = loadSpirVBinary(_vert_path);
-		_frag_binary_data = loadSpirVBinary(_frag_path);
+		createShaderModule(_vert_binary_data, vert_module);
+		createShaderModule(_frag_binary_data, frag_module);
+	}
+
+
+    bool Shader::cook(std::string name, bool bindless_materials)
+    {
+        loadPrograms(name, bindless_materials);
+        reflect();
+        return writeReflection();
+    }
 
-        reflectDescriptorTypes(convert(_frag_binary_data), VK_SHADER_STAGE_FRAGMENT_BIT);
 
+	void Shader::createVertexOnly(VulkanDevice *device, std::string name)
+	{
+		_device = device;
+		_name = name;
+
+		_vert_path = Settings::inst()->getShaderDirectory() + name + "_vert" + ".spv";
+		_vert_binary_data = loadSpirVBinary(_vert_path);
+
+		reflectPushConstants(convert(_vert_binary_data), VK_SHADER_STAGE_VERTEX_BIT);
 		createShaderModule(_vert_binary_data, vert_module);
-		createShaderModule(_frag_binary_data, frag_module);
+	}
+
+
+	void Shader::createCompute(VulkanDevice *device, std::string name)
+	{
+		_device = device;
+		_name = name;
+
+		_comp_path = Settings::inst()->getShaderDirectory() + name + "_comp" + ".spv";
+		createShaderModule(loadSpirVBinary(_comp_path), comp_module);
 	}
 
 
@@ -52,10 +79,166 @@ namespace vv
 	{
 		if (vert_module) vkDestroyShaderModule(_device->logical_device, vert_module, nullptr);
 		if (frag_module) vkDestroyShaderModule(_device->logical_device, frag_module, nullptr);
+		if (comp_module) vkDestroyShaderModule(_device->logical_device, comp_module, nullptr);
 	}
 
+
+    VkShaderStageFlags Shader::getPushConstantStages(uint32_t offset, uint32_t size) const
+    {
+        VkShaderStageFlags stages = 0;
+        for (const auto &r : push_constant_ranges)
+            if (r.offset < offset + size && offset < r.offset + r.size)
+                stages |= r.stageFlags;
+        return stages;
+    }
+
 	
 	///////////////////////////////////////////////////////////////////////////////////////////// Private
+    void Shader::loadPrograms(std::string name, bool bindless_materials)
+    {
+		_name = name;
+        std::string dir = Settings::inst()->getShaderDirectory();
+
+		_vert_path = dir + name + "_vert" + ".spv";
+		_frag_path = dir + name + "_frag" + ".spv";
+        _material_frag_path = _frag_path;
+        _reflection_path = dir + name + ".vvshader";
+
+        // only templates with material inputs have a bindless variant
+        std::string bindless_frag_path = dir + name + "_bindless_frag" + ".spv";
+        if (bindless_materials && std::ifstream(bindless_frag_path).good())
+        {
+            _frag_path = bindless_frag_path;
+            _reflection_path = dir + name + "_bindless" + ".vvshader";
+            uses_bindless_materials = true;
+        }
+
+        _vert_binary_data = loadSpirVBinary(_vert_path);
+		_frag_binary_data = loadSpirVBinary(_frag_path);
+    }
+
+
+    void Shader::reflect()
+    {
+        material_descriptor_orderings.clear();
+        push_constant_ranges.clear();
+        uses_environmental_lighting = false;
+
+        // material descriptors always come from the regular variant
+        if (_material_frag_path == _frag_path)
+            reflectDescriptorTypes(convert(_frag_binary_data), VK_SHADER_STAGE_FRAGMENT_BIT);
+        else
+            reflectDescriptorTypes(convert(loadSpirVBinary(_material_frag_path)), VK_SHADER_STAGE_FRAGMENT_BIT);
+
+        // from the programs actually used. the bindless variant reads its material index from push constants.
+        reflectPushConstants(convert(_vert_binary_data), VK_SHADER_STAGE_VERTEX_BIT);
+        reflectPushConstants(convert(_frag_binary_data), VK_SHADER_STAGE_FRAGMENT_BIT);
+    }
+
+
+    bool Shader::loadReflection()
+    {
+        std::ifstream file(_reflection_path);
+        if (!file.is_open())
+            return false;
+
+        std::string magic;
+        uint32_t version = 0;
+        if (!(file >> magic >> version) || magic != "vvshader" || version != reflection_version)
+            return false;
+
+        std::vector<DescriptorInfo> descriptors;
+        std::vector<VkPushConstantRange> ranges;
+        bool environmental_lighting = false;
+        std::vector<std::string> sources = getReflectionSources();
+        std::size_t matched_sources = 0;
+
+        std::string key;
+        while (file >> key)
+        {
+            if (key == "source")
+            {
+                // every program has to be listed in order with the hash it had when it was cooked
+                std::string source;
+                uint64_t stored_hash = 0, current_hash = 0;
+                if (!(file >> source >> stored_hash) || matched_sources >= sources.size() || source != sources[matched_sources] ||
+                    !MappedFile::hashFile(Settings::inst()->getShaderDirectory() + source, current_hash) || current_hash != stored_hash)
+                    return false;
+                ++matched_sources;
+            }
+            else if (key == "environmental_lighting")
+            {
+                if (!(file >> environmental_lighting))
+                    return false;
+            }
+            else if (key == "descriptor")
+            {
+                DescriptorInfo descriptor = {};
+                uint32_t stage = 0, type = 0;
+                if (!(file >> descriptor.binding >> descriptor.name >> stage >> type))
+                    return false;
+
+                descriptor.shader_stage = static_cast<VkShaderStageFlagBits>(stage);
+                descriptor.type = static_cast<VkDescriptorType>(type);
+                descriptors.push_back(descriptor);
+            }
+            else if (key == "push_constant")
+            {
+                VkPushConstantRange range = {};
+                if (!(file >> range.offset >> range.size >> range.stageFlags))
+                    return false;
+                ranges.push_back(range);
+            }
+            else
+                return false;
+        }
+
+        if (matched_sources != sources.size())
+            return false;
+
+        material_descriptor_orderings = descriptors;
+        push_constant_ranges = ranges;
+        uses_environmental_lighting = environmental_lighting;
+        return true;
+    }
+
+
+    bool Shader::writeReflection() const
+    {
+        std::ofstream file(_reflection_path, std::ios::trunc);
+        if (!file.is_open())
+            return false;
+
+        file << "vvshader " << reflection_version << "\n";
+        for (const auto &source : getReflectionSources())
+        {
+            uint64_t hash = 0;
+            if (!MappedFile::hashFile(Settings::inst()->getShaderDirectory() + source, hash))
+                return false;
+            file << "source " << source << " " << hash << "\n";
+        }
+
+        file << "environmental_lighting " << uses_environmental_lighting << "\n";
+        for (const auto &d : material_descriptor_orderings)
+            file << "descriptor " << d.binding << " " << d.name << " " << static_cast<uint32_t>(d.shader_stage) << " " << static_cast<uint32_t>(d.type) << "\n";
+        for (const auto &r : push_constant_ranges)
+            file << "push_constant " << r.offset << " " << r.size << " " << r.stageFlags << "\n";
+
+        return file.good();
+    }
+
+
+    std::vector<std::string> Shader::getReflectionSources() const
+    {
+        // relative to the shader directory
+        std::string dir = Settings::inst()->getShaderDirectory();
+        std::vector<std::string> sources = { _vert_path.substr(dir.size()), _frag_path.substr(dir.size()) };
+        if (_material_frag_path != _frag_path)
+            sources.push_back(_material_frag_path.substr(dir.size()));
+        return sources;
+    }
+
+
 	std::vector<char> Shader::loadSpirVBinary(std::string file_name)
 	{
 		std::ifstream file(file_name, std::ios::ate | std::ios::binary);
@@ -90,19 +273,6 @@ namespace vv
         spirv_cross::CompilerGLSL glsl(spirv_binary);
         spirv_cross::ShaderResources resources = glsl.get_shader_resources();
 
-        for (auto &resource : resources.push_constant_buffers)
-        {
-            auto ranges = glsl.get_active_buffer_ranges(resource.id);
-            for (auto &r : ranges)
-            {
-                VkPushConstantRange push_constant_range = {};
-                push_constant_range.offset = r.offset;
-                push_constant_range.size = r.range;
-                push_constant_range.stageFlags = shader_stage;
-                push_constant_ranges.push_back(push_constant_range);
-            }
-        }
-
         // Get all sampled uniform buffers in the shader.
         for (auto &resource : resources.uniform_buffers)
         {
@@ -173,4 +343,39 @@ namespace vv
             }
         );
     }
-}
\ No newline at end of file
+
+
+    void Shader::reflectPushConstants(std::vector<uint32_t> spirv_binary, VkShaderStageFlagBits shader_stage)
+    {
+        spirv_cross::CompilerGLSL glsl(spirv_binary);
+        spirv_cross::ShaderResources resources = glsl.get_shader_resources();
+
+        for (auto &resource : resources.push_constant_buffers)
+        {
+            for (auto &r : glsl.get_active_buffer_ranges(resource.id))
+            {
+                VkPushConstantRange range = {};
+                range.offset = static_cast<uint32_t>(r.offset);
+                range.size = static_cast<uint32_t>(r.range);
+                range.stageFlags = shader_stage;
+
+                // fold in every range this one touches. vkCmdPushConstants then names a single set of stages per byte.
+                for (auto it = push_constant_ranges.begin(); it != push_constant_ranges.end();)
+                {
+                    if (it->offset <= range.offset + range.size && range.offset <= it->offset + it->size)
+                    {
+                        uint32_t end = std::max(range.offset + range.size, it->offset + it->size);
+                        range.offset = std::min(range.offset, it->offset);
+                        range.size = end - range.offset;
+                        range.stageFlags |= it->stageFlags;
+                        it = push_constant_ranges.erase(it);
+                    }
+                    else
+                        ++it;
+                }
+
+                push_constant_ranges.push_back(range);
+            }
+        }
+    }
+}
@@ -94,30 +94,28 @@ namespace vv
     }
 
 
-    void SkyBox::bindSkyBoxDescriptorSets(VkCommandBuffer command_buffer, VkPipelineLayout pipeline_layout) const
+    void SkyBox::bindSkyBoxDescriptorSets(VulkanCommandEncoder &encoder, VkPipelineLayout pipeline_layout) const
     {
-        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 1,
-                1, &_radiance_descriptor_set, 0, nullptr);
+        encoder.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 1, 1, &_radiance_descriptor_set);
     }
 
 
-    void SkyBox::bindIBLDescriptorSets(VkCommandBuffer command_buffer, VkPipelineLayout pipeline_layout) const
+    void SkyBox::bindIBLDescriptorSets(VulkanCommandEncoder &encoder, VkPipelineLayout pipeline_layout) const
     {
-        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 2,
-                1, &_environment_descriptor_set, 0, nullptr);
+        encoder.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 2, 1, &_environment_descriptor_set);
     }
 
 
-    void SkyBox::submitMipLevelPushConstants(VkCommandBuffer command_buffer, VkPipelineLayout pipeline_layout) const
+    void SkyBox::submitMipLevelPushConstants(VulkanCommandEncoder &encoder, VkPipelineLayout pipeline_layout, VkShaderStageFlags stage_flags) const
     {
-        vkCmdPushConstants(command_buffer, pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(uint32_t), &_max_mip_levels);
+        encoder.pushConstants(pipeline_layout, stage_flags, 0, sizeof(uint32_t), &_max_mip_levels);
     }
 
 
-    void SkyBox::render(VkCommandBuffer command_buffer)
+    void SkyBox::render(VulkanCommandEncoder &encoder)
     {
-        _mesh->bindBuffers(command_buffer);
-        _mesh->render(command_buffer);
+        _mesh->bindBuffers(encoder);
+        _mesh->render(encoder);
     }
 
 
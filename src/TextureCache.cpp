@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "TextureCache.h"
+
+namespace vv
+{
+    static const char texture_cache_magic[4] = { 'V', 'V', 'T', 'X' };
+    static const uint32_t texture_cache_format_version = 1;
+
+    struct TextureCacheHeader
+    {
+        char magic[4];
+        uint32_t format_version;
+        uint32_t format;                    // VkFormat
+        uint32_t width;
+        uint32_t height;
+        uint32_t mip_levels;
+        uint64_t source_hash;
+        uint64_t data_size;                 // texel data follows the header directly
+    };
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////// Public
+	TextureCache::TextureCache()
+	{
+	}
+
+
+	TextureCache::~TextureCache()
+	{
+	}
+
+
+    bool TextureCache::create(const std::string &path, const std::string &source_name)
+    {
+        if (!_file.create(path + source_name + ".vvtex"))
+            return false;
+
+        TextureCacheHeader header;
+        uint64_t source_hash = 0;
+        bool valid = _file.getSize() >= sizeof(header);
+
+        if (valid)
+        {
+            std::memcpy(&header, _file.getData(), sizeof(header));
+            valid = std::memcmp(header.magic, texture_cache_magic, sizeof(header.magic)) == 0 &&
+                    header.format_version == texture_cache_format_version && header.mip_levels > 0 && header.mip_levels <= 32 &&
+                    MappedFile::hashFile(path + source_name, source_hash) && source_hash == header.source_hash;
+        }
+
+        if (valid)
+        {
+            format = static_cast<VkFormat>(header.format);
+            width = header.width;
+            height = header.height;
+            mip_levels = header.mip_levels;
+
+            // also rejects formats this version doesn't know the layout of
+            uint64_t expected_size = getSize(mip_levels);
+            valid = expected_size > 0 && header.data_size == expected_size && _file.getSize() - sizeof(header) >= expected_size;
+        }
+
+        if (!valid)
+        {
+            shutDown();
+            return false;
+        }
+
+        _data = _file.getData() + sizeof(header);
+        return true;
+    }
+
+
+	void TextureCache::shutDown()
+	{
+        _file.shutDown();
+        _data = nullptr;
+
+        format = VK_FORMAT_UNDEFINED;
+        width = height = mip_levels = 0;
+        data.clear();
+	}
+
+
+    bool TextureCache::write(const std::string &path, const std::string &source_name) const
+    {
+        TextureCacheHeader header = {};
+        std::memcpy(header.magic, texture_cache_magic, sizeof(header.magic));
+        header.format_version = texture_cache_format_version;
+        header.format = static_cast<uint32_t>(format);
+        header.width = width;
+        header.height = height;
+        header.mip_levels = mip_levels;
+        header.data_size = data.size();
+
+        if (!MappedFile::hashFile(path + source_name, header.source_hash) || data.size() != getSize(mip_levels))
+            return false;
+
+        // written next to the old cache first, so a failed write never leaves a truncated one behind
+        std::string cache_path = path + source_name + ".vvtex";
+        std::string temp_path = cache_path + ".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+                return false;
+
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(data.data(), data.size());
+
+            if (!file.good())
+            {
+                file.close();
+                std::remove(temp_path.c_str());
+                return false;
+            }
+        }
+
+        std::remove(cache_path.c_str());
+        return std::rename(temp_path.c_str(), cache_path.c_str()) == 0;
+    }
+
+
+    const char* TextureCache::getData() const
+    {
+        return _data ? _data : data.data();
+    }
+
+
+    uint64_t TextureCache::getSize(uint32_t level_count) const
+    {
+        uint64_t size = 0;
+        for (uint32_t level = 0; level < level_count; ++level)
+            size += getLevelSize(format, width, height, level);
+        return size;
+    }
+
+
+    uint64_t TextureCache::getLevelSize(VkFormat format, uint32_t width, uint32_t height, uint32_t level)
+    {
+        uint64_t level_width = std::max(1u, width >> level);
+        uint64_t level_height = std::max(1u, height >> level);
+        uint64_t block_count = ((level_width + 3) / 4) * ((level_height + 3) / 4);
+
+        switch (format)
+        {
+        case VK_FORMAT_R8G8B8A8_UNORM:
+            return level_width * level_height * 4;
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            return block_count * 8;
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+            return block_count * 16;
+        default:
+            return 0;
+        }
+    }
+}
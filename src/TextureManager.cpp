@@ -34,15 +34,18 @@ namespace vv
 
 	void TextureManager::shutDown()
 	{
+        for (auto &v : _swizzled_views)
+        {
+            v.second->image_view->shutDown(); delete v.second->image_view;
+            delete v.second;
+        }
+
         for (auto &t : _loaded_textures)
         {
             t.second->image->shutDown(); delete t.second->image;
             t.second->image_view->shutDown(); delete t.second->image_view;
             t.second->sampler->shutDown(); delete t.second->sampler;
         }
-
-        for (auto &d : _ldr_texture_array_data_cache)
-            stbi_image_free(d.second);
 	}
 
 
@@ -59,6 +62,14 @@ namespace vv
 
         if (file_type == "png" || file_type == "jpg")
         {
+            // cooked textures were made from the rgba8 texels, so they only stand in for those
+            SampledTexture *cooked = (format == VK_FORMAT_R8G8B8A8_UNORM) ? loadCookedImage(path, name, create_mip_levels) : nullptr;
+            if (cooked)
+            {
+                _loaded_textures[path + name] = cooked;
+                return cooked;
+            }
+
 		    int stb_format = (format == VK_FORMAT_R8G8B8A8_UNORM) ? STBI_rgb_alpha : 0; // todo: figure out how other formats play with stb
             int width, height, depth, channels;
 
@@ -71,8 +82,6 @@ namespace vv
                 return _loaded_textures[_texture_directory + "dummy.png"];
             }
 
-            _ldr_texture_array_data_cache[path + name] = texels;
-
             uint32_t size = width * height * 4;
             VkExtent3D extent = {};
             extent.width = static_cast<uint32_t>(width);
@@ -81,12 +90,16 @@ namespace vv
             uint32_t mip_levels = (create_mip_levels) ? std::floor(std::log2(std::max(extent.width, extent.height))) + 1 : 1;
 
             _loaded_textures[path + name] = loadTexture(texels, size, extent, format, 0, 1, 1, VK_IMAGE_VIEW_TYPE_2D);
+
+            // the upload queue copied the texels into staging memory, so the decoded image can go right away
+            stbi_image_free(texels);
+            _reclaimed_host_bytes += size;
+
             return _loaded_textures[path + name];
         }
         else if (file_type == "dds" || file_type == "ktx")
         {
             gli::texture_cube texels(gli::load((path + name).c_str()));
-            _hdr_texture_array_data_cache[path + name] = static_cast<float *>(texels.data());
 
             // todo: should implement a fallback
             if (texels.empty())
@@ -103,6 +116,9 @@ namespace vv
             _loaded_textures[path + name] = loadTexture(texels.data(), texels.size(), extent, fmt,
                                             0, mip_levels, 1, VK_IMAGE_VIEW_TYPE_2D);
 
+            // texels is released when it goes out of scope
+            _reclaimed_host_bytes += texels.size();
+
             return _loaded_textures[path + name];
         }
                 
@@ -111,6 +127,72 @@ namespace vv
     }
 
 
+    SampledTexture* TextureManager::loadEncodedImage(const std::string &key, const char *data, std::size_t size)
+    {
+        if (_loaded_textures.count(key) > 0)
+            return _loaded_textures[key];
+
+        int width, height, channels;
+        unsigned char *texels = stbi_load_from_memory(reinterpret_cast<const stbi_uc *>(data), static_cast<int>(size),
+                                                      &width, &height, &channels, STBI_rgb_alpha);
+
+        if (!texels)
+        {
+            VV_ALERT("WARNING: Could not decode image " + key + ". Using dummy texture.");
+            return _loaded_textures[_texture_directory + "dummy.png"];
+        }
+
+        uint32_t texel_size = width * height * 4;
+        VkExtent3D extent = {};
+        extent.width = static_cast<uint32_t>(width);
+        extent.height = static_cast<uint32_t>(height);
+        extent.depth = 1;
+
+        _loaded_textures[key] = loadTexture(texels, texel_size, extent, VK_FORMAT_R8G8B8A8_UNORM, 0, 1, 1, VK_IMAGE_VIEW_TYPE_2D);
+
+        stbi_image_free(texels);
+        _reclaimed_host_bytes += texel_size;
+
+        return _loaded_textures[key];
+    }
+
+
+    SampledTexture* TextureManager::loadSolidImage(const glm::vec4 &color)
+    {
+        uint8_t texel[4];
+        for (int i = 0; i < 4; ++i)
+            texel[i] = static_cast<uint8_t>(std::round(glm::clamp(color[i], 0.0f, 1.0f) * 255.0f));
+
+        // materials repeat the same few constants, so they are shared by value
+        std::string key = "solid:" + std::to_string(texel[0]) + "," + std::to_string(texel[1]) + "," +
+                          std::to_string(texel[2]) + "," + std::to_string(texel[3]);
+        if (_loaded_textures.count(key) > 0)
+            return _loaded_textures[key];
+
+        VkExtent3D extent = { 1, 1, 1 };
+        _loaded_textures[key] = loadTexture(texel, sizeof(texel), extent, VK_FORMAT_R8G8B8A8_UNORM, 0, 1, 1, VK_IMAGE_VIEW_TYPE_2D);
+        return _loaded_textures[key];
+    }
+
+
+    SampledTexture* TextureManager::createSwizzledView(SampledTexture *texture, const std::string &key, VkComponentMapping components)
+    {
+        if (_swizzled_views.count(key) > 0)
+            return _swizzled_views[key];
+
+        SampledTexture *view = new SampledTexture();
+        view->image = texture->image;
+        view->sampler = texture->sampler;
+
+        view->image_view = new VulkanImageView();
+        view->image_view->create(_device, texture->image, texture->image_view->type, texture->image->aspect_flags, 0,
+                                 texture->image->mip_levels, components);
+
+        _swizzled_views[key] = view;
+        return view;
+    }
+
+
     SampledTexture* TextureManager::loadCubeMap(std::string path, std::string name, VkFormat format, bool create_mip_levels)
     {
         std::string file_type = name.substr(name.find_first_of('.') + 1);
@@ -137,6 +219,7 @@ namespace vv
 
             _loaded_textures[path + name] = loadTexture(cube.data(), cube.size(), extent, fmt,
                                             VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT, mip_levels, 6, VK_IMAGE_VIEW_TYPE_CUBE);
+            _reclaimed_host_bytes += cube.size();
 
             return _loaded_textures[path + name];
         }
@@ -145,6 +228,14 @@ namespace vv
     }
 
 
+    HostMemoryStatistics TextureManager::getHostMemoryStatistics() const
+    {
+        HostMemoryStatistics stats = {};
+        stats.reclaimed_bytes = _reclaimed_host_bytes;
+        return stats;
+    }
+
+
     SampledTexture* TextureManager::loadTexture(void *data, VkDeviceSize size_in_bytes, VkExtent3D extent, VkFormat format,
         VkImageCreateFlags flags, uint32_t mip_levels, uint32_t array_layers, VkImageViewType image_view_type)
     {
@@ -170,4 +261,31 @@ namespace vv
 
 
 	///////////////////////////////////////////////////////////////////////////////////////////// Private
+    SampledTexture* TextureManager::loadCookedImage(const std::string &path, const std::string &name, bool create_mip_levels)
+    {
+        TextureCache cache;
+        if (!cache.create(path, name))
+            return nullptr;
+
+        // block compression is optional. such devices decode the source instead.
+        bool compressed = cache.format != VK_FORMAT_R8G8B8A8_UNORM;
+        if (compressed && !_device->physical_device_features.textureCompressionBC)
+        {
+            cache.shutDown();
+            return nullptr;
+        }
+
+        VkExtent3D extent = {};
+        extent.width = cache.width;
+        extent.height = cache.height;
+        extent.depth = 1;
+        uint32_t mip_levels = create_mip_levels ? cache.mip_levels : 1;
+
+        // the upload queue copies the levels straight out of the mapping into staging memory
+        SampledTexture *texture = loadTexture(const_cast<char *>(cache.getData()), cache.getSize(mip_levels), extent, cache.format,
+                                              0, mip_levels, 1, VK_IMAGE_VIEW_TYPE_2D);
+
+        cache.shutDown();
+        return texture;
+    }
 }
@@ -0,0 +1,92 @@
+#include "ThreadPool.h"
+
+namespace vv
+{
+	///////////////////////////////////////////////////////////////////////////////////////////// Public
+	ThreadPool::ThreadPool()
+	{
+	}
+
+
+	ThreadPool::~ThreadPool()
+	{
+	}
+
+
+	void ThreadPool::create(uint32_t thread_count)
+	{
+        _stopping = false;
+        for (uint32_t i = 0; i < thread_count; ++i)
+            _workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+	}
+
+
+	void ThreadPool::shutDown()
+	{
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _task_available.notify_all();
+
+        for (auto &worker : _workers)
+            if (worker.joinable())
+                worker.join();
+
+        _workers.clear();
+	}
+
+
+    void ThreadPool::enqueue(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _tasks.push(task);
+            _pending_tasks++;
+        }
+        _task_available.notify_one();
+    }
+
+
+    void ThreadPool::wait()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _tasks_finished.wait(lock, [this]() { return _pending_tasks == 0; });
+    }
+
+
+    uint32_t ThreadPool::getThreadCount() const
+    {
+        return static_cast<uint32_t>(_workers.size());
+    }
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////// Private
+    void ThreadPool::workerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _task_available.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+
+                // drain remaining work before exiting so no waiter is left hanging
+                if (_stopping && _tasks.empty())
+                    return;
+
+                task = _tasks.front();
+                _tasks.pop();
+            }
+
+            task();
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _pending_tasks--;
+                if (_pending_tasks == 0)
+                    _tasks_finished.notify_all();
+            }
+        }
+    }
+}
@@ -1,5 +1,6 @@
 
 #include <stdexcept>
+#include <iostream>
 #include <chrono>
 
 #include "VirtualVistaEngine.h"
@@ -54,6 +55,7 @@ namespace vv
         _renderer->recordCommandBuffers();
 
         auto last_time = glfwGetTime();
+        auto last_report_time = last_time;
 
 		while (!_renderer->shouldStop())
 		{
@@ -63,10 +65,59 @@ namespace vv
 
             input_handler(_scene, delta_time);
 			_renderer->run(delta_time);
+
+            if (Settings::inst()->isFrameStatisticsReportingEnabled() && (curr_time - last_report_time) >= 1.0)
+            {
+                reportFrameStatistics();
+                last_report_time = curr_time;
+            }
 		}
 	}
 
 
 	///////////////////////////////////////////////////////////////////////////////////////////// Private
+    void VirtualVistaEngine::reportFrameStatistics()
+    {
+        const FrameStatistics &stats = _renderer->getFrameStatistics();
+
+        std::cout << "frame " << stats.frame_count
+                  << " | record (ms) last: " << stats.last_record_time
+                  << " avg: " << stats.average_record_time
+                  << " max: " << stats.max_record_time
+                  << " over budget: " << stats.frames_over_budget << std::endl;
+
+        std::cout << "culling | visible: " << stats.visible_draws
+                  << " culled: " << stats.culled_draws << std::endl;
+
+        std::cout << "state changes | issued: " << stats.issued_state_calls
+                  << " elided: " << stats.elided_state_calls << std::endl;
+
+        const MemoryStatistics memory_stats = _renderer->getMemoryStatistics();
+        std::cout << "memory | blocks: " << memory_stats.block_count
+                  << " dedicated: " << memory_stats.dedicated_allocation_count
+                  << " allocations: " << memory_stats.allocation_count
+                  << " used (MB): " << memory_stats.bytes_used / (1024.0 * 1024.0)
+                  << " / " << memory_stats.bytes_reserved / (1024.0 * 1024.0)
+                  << " fragmentation: " << memory_stats.fragmentation << std::endl;
+
+        const HostMemoryStatistics host_stats = _renderer->getHostMemoryStatistics();
+        std::cout << "host assets | resident (MB): " << host_stats.resident_bytes / (1024.0 * 1024.0)
+                  << " reclaimed (MB): " << host_stats.reclaimed_bytes / (1024.0 * 1024.0) << std::endl;
+
+        const ImportStatistics &import_stats = _renderer->getImportStatistics();
+        double dedup_ratio = (import_stats.unique_vertex_count > 0) ? static_cast<double>(import_stats.index_count) / import_stats.unique_vertex_count : 0.0;
+        std::cout << "import | indices: " << import_stats.index_count
+                  << " unique vertices: " << import_stats.unique_vertex_count
+                  << " dedup ratio: " << dedup_ratio
+                  << " parse (ms): " << import_stats.parse_time
+                  << " dedup (ms): " << import_stats.deduplication_time
+                  << " cached models: " << import_stats.cached_model_count
+                  << " cache (ms): " << import_stats.cache_load_time
+                  << " gltf models: " << import_stats.gltf_model_count
+                  << " gltf (ms): " << import_stats.gltf_load_time
+                  << " mapped vertices: " << import_stats.mapped_vertex_count << std::endl;
+
+        _renderer->resetFrameStatistics();
+    }
 
 }
\ No newline at end of file
@@ -14,76 +14,76 @@ namespace vv
     }
 
 
-    void VulkanBuffer::create(VulkanDevice *device, VkBufferUsageFlags usage_flags, VkDeviceSize size)
+    void VulkanBuffer::create(VulkanDevice *device, VkBufferUsageFlags usage_flags, VkDeviceSize size, bool host_visible)
     {
         VV_ASSERT(device != VK_NULL_HANDLE, "VulkanDevice not present");
         _device = device;
         _usage_flags = usage_flags;
         this->size = size;
 
-        // Create temporary transfer buffer on CPU 
-        allocateMemory(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, _staging_buffer, _staging_memory);
+        if (host_visible)
+        {
+            // single buffer the cpu writes and the gpu reads directly. lands in vram when resizable BAR is exposed.
+            allocateMemory(size, usage_flags, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                           buffer, _buffer_allocation, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            _mapped_data = _buffer_allocation.mapped_data;
+            return;
+        }
 
-        // Create storage buffer for GPU
-        allocateMemory(size, usage_flags | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, _buffer_memory);	
+        // Create storage buffer for GPU. staging memory is borrowed from the upload queue per transfer.
+        allocateMemory(size, usage_flags | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, _buffer_allocation);	
     }
 
 
     void VulkanBuffer::shutDown()
     {
-        if (_staging_buffer)
-        	vkDestroyBuffer(_device->logical_device, _staging_buffer, nullptr);
-        if (_staging_memory)
-        	vkFreeMemory(_device->logical_device, _staging_memory, nullptr);
-
         vkDestroyBuffer(_device->logical_device, buffer, nullptr);
-        vkFreeMemory(_device->logical_device, _buffer_memory, nullptr);
+        _device->memory_allocator->free(_buffer_allocation);
+        _mapped_data = nullptr;
     }
 
 
     void VulkanBuffer::updateAndTransfer(void *data)
     {
-        update(data);
-        transferToDevice();
-    }
+        // host visible buffers are already where the gpu reads them from
+        if (_mapped_data)
+        {
+            update(data);
+            return;
+        }
 
+        VV_ASSERT(buffer != VK_NULL_HANDLE, "Buffer not allocated correctly. Perhaps create() wasn't called.");
 
-    void VulkanBuffer::update(void *data)
-    {
-        // Move raw data to staging Vulkan buffer.
-        void *mapped_data;
-        vkMapMemory(_device->logical_device, _staging_memory, 0, size, 0, &mapped_data);
-        memcpy(mapped_data, data, size);
-        vkUnmapMemory(_device->logical_device, _staging_memory);
+        // batched with other uploads and submitted later. ownership moves to the graphics queue once the copy is done.
+        _device->upload_queue->uploadBuffer(data, size, buffer, 0, _usage_flags);
     }
 
 
-    void VulkanBuffer::transferToDevice()
+    void VulkanBuffer::updateAndTransfer(const void *data, VkDeviceSize size, VkDeviceSize offset)
     {
-        VV_ASSERT(_staging_buffer && buffer, "Buffers not allocated correctly. Perhaps create() wasn't called.");
+        VV_ASSERT(offset + size <= this->size, "Buffer range written past the end of the buffer");
 
-        auto command_pool_used = _device->command_pools["graphics"];
-
-        // use transfer queue if available
-        if (_device->command_pools.count("transfer") > 0)
-            command_pool_used = _device->command_pools["transfer"];
+        if (_mapped_data)
+        {
+            memcpy(static_cast<uint8_t *>(_mapped_data) + offset, data, size);
+            return;
+        }
 
-        auto command_buffer = util::beginSingleUseCommand(_device->logical_device, command_pool_used);
+        VV_ASSERT(buffer != VK_NULL_HANDLE, "Buffer not allocated correctly. Perhaps create() wasn't called.");
+        _device->upload_queue->uploadBuffer(data, size, buffer, offset, _usage_flags);
+    }
 
-        VkBufferCopy buffer_copy = {};
-        buffer_copy.size = size;
-        vkCmdCopyBuffer(command_buffer, _staging_buffer, buffer, 1, &buffer_copy);
 
-        if (_device->transfer_family_index != -1)
-            util::endSingleUseCommand(_device->logical_device, command_pool_used, command_buffer, _device->transfer_queue);
-        else
-            util::endSingleUseCommand(_device->logical_device, command_pool_used, command_buffer, _device->graphics_queue);
+    void VulkanBuffer::update(void *data)
+    {
+        VV_ASSERT(_mapped_data != nullptr, "update() requires a host visible buffer. Use updateAndTransfer() instead.");
+        memcpy(_mapped_data, data, size);
     }
 
 
     ///////////////////////////////////////////////////////////////////////////////////////////// Private
-    void VulkanBuffer::allocateMemory(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memory_properties, VkBuffer &buffer, VkDeviceMemory &buffer_memory)
+    void VulkanBuffer::allocateMemory(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memory_properties, VkBuffer &buffer, VulkanAllocation &allocation,
+                                      VkMemoryPropertyFlags preferred_memory_properties)
     {
         // Create the Vulkan abstraction for a vertex buffer.
         VkBufferCreateInfo buffer_create_info = {};
@@ -92,39 +92,17 @@ namespace vv
         buffer_create_info.size = size;
         buffer_create_info.usage = usage; // use this as a vertex/index buffer
 
-        // use transfer queue if available
-        if (_device->transfer_family_index != -1)
-        {
-            buffer_create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
-            buffer_create_info.queueFamilyIndexCount = 2;
-            std::array<uint32_t, 2> queue_family_indices = {
-                static_cast<uint32_t>(_device->graphics_family_index),
-                static_cast<uint32_t>(_device->transfer_family_index)
-            };
-            buffer_create_info.pQueueFamilyIndices = queue_family_indices.data();
-        }
-        else
-        {
-            buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-            buffer_create_info.queueFamilyIndexCount = 1;
-            uint32_t queue_index = static_cast<uint32_t>(_device->graphics_family_index);
-            buffer_create_info.pQueueFamilyIndices = &queue_index;
-        }
+        // only ever owned by one queue family at a time. the upload queue transfers ownership explicitly.
+        buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
         VV_CHECK_SUCCESS(vkCreateBuffer(_device->logical_device, &buffer_create_info, nullptr, &buffer));
 
         // Determine requirements for memory (where it's allocated, type of memory, etc.)
         VkMemoryRequirements memory_requirements = {};
         vkGetBufferMemoryRequirements(_device->logical_device, buffer, &memory_requirements);
-        auto memory_type = _device->findMemoryTypeIndex(memory_requirements.memoryTypeBits, memory_properties);
-
-        // Allocate and bind buffer memory.
-        VkMemoryAllocateInfo memory_allocate_info = {};
-        memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        memory_allocate_info.allocationSize = memory_requirements.size;
-        memory_allocate_info.memoryTypeIndex = memory_type;
 
-        VV_CHECK_SUCCESS(vkAllocateMemory(_device->logical_device, &memory_allocate_info, nullptr, &buffer_memory));
-        vkBindBufferMemory(_device->logical_device, buffer, buffer_memory, 0);
+        // Sub-allocate from a shared device memory block and bind.
+        _device->memory_allocator->allocate(memory_requirements, memory_properties, preferred_memory_properties, ResourceTiling::Linear, allocation);
+        VV_CHECK_SUCCESS(vkBindBufferMemory(_device->logical_device, buffer, allocation.memory, allocation.offset));
     }
 }
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <cstring>
+
+#include "VulkanCommandEncoder.h"
+
+namespace vv
+{
+    ///////////////////////////////////////////////////////////////////////////////////////////// Public
+    VulkanCommandEncoder::VulkanCommandEncoder()
+    {
+    }
+
+
+    VulkanCommandEncoder::~VulkanCommandEncoder()
+    {
+    }
+
+
+    void VulkanCommandEncoder::begin(VkCommandBuffer command_buffer)
+    {
+        VV_ASSERT(command_buffer != VK_NULL_HANDLE, "Command buffer not present");
+        this->command_buffer = command_buffer;
+
+        _bind_points = {};
+        _push_constant_layout = VK_NULL_HANDLE;
+        _push_constant_mask = 0;
+        _vertex_buffers.fill(VK_NULL_HANDLE);
+        _vertex_buffer_offsets.fill(0);
+        _index_buffer = VK_NULL_HANDLE;
+        _index_buffer_offset = 0;
+        _index_type = VK_INDEX_TYPE_UINT32;
+        _statistics = {};
+    }
+
+
+    void VulkanCommandEncoder::bindPipeline(VkPipelineBindPoint bind_point, VkPipeline pipeline)
+    {
+        BindPointState &state = getBindPointState(bind_point);
+        if (!track(state.pipeline == pipeline))
+            return;
+
+        vkCmdBindPipeline(command_buffer, bind_point, pipeline);
+        state.pipeline = pipeline;
+    }
+
+
+    void VulkanCommandEncoder::bindDescriptorSets(VkPipelineBindPoint bind_point, VkPipelineLayout pipeline_layout, uint32_t first_set,
+                                                  uint32_t set_count, const VkDescriptorSet *sets, uint32_t dynamic_offset_count,
+                                                  const uint32_t *dynamic_offsets)
+    {
+        BindPointState &state = getBindPointState(bind_point);
+
+        // dynamic offsets can only be matched to their set when a single set is bound
+        bool trackable = (first_set + set_count <= max_descriptor_sets) &&
+                         (dynamic_offset_count == 0 || (set_count == 1 && dynamic_offset_count <= max_dynamic_offsets));
+
+        bool redundant = trackable;
+        for (uint32_t i = 0; i < set_count && redundant; ++i)
+        {
+            const BoundSet &bound = state.sets[first_set + i];
+            redundant = bound.pipeline_layout == pipeline_layout && bound.set == sets[i] && bound.dynamic_offset_count == dynamic_offset_count &&
+                        (dynamic_offset_count == 0 || std::memcmp(bound.dynamic_offsets.data(), dynamic_offsets, dynamic_offset_count * sizeof(uint32_t)) == 0);
+        }
+
+        if (!track(redundant))
+            return;
+
+        vkCmdBindDescriptorSets(command_buffer, bind_point, pipeline_layout, first_set, set_count, sets, dynamic_offset_count, dynamic_offsets);
+
+        // sets bound through another layout may have been disturbed
+        for (auto &bound : state.sets)
+        {
+            if (bound.pipeline_layout != pipeline_layout)
+                bound = BoundSet();
+        }
+
+        for (uint32_t i = 0; i < set_count && first_set + i < max_descriptor_sets; ++i)
+        {
+            BoundSet &bound = state.sets[first_set + i];
+            bound = BoundSet();
+            if (!trackable)
+                continue;
+
+            bound.pipeline_layout = pipeline_layout;
+            bound.set = sets[i];
+            bound.dynamic_offset_count = dynamic_offset_count;
+            std::copy(dynamic_offsets, dynamic_offsets + dynamic_offset_count, bound.dynamic_offsets.begin());
+        }
+    }
+
+
+    void VulkanCommandEncoder::pushConstants(VkPipelineLayout pipeline_layout, VkShaderStageFlags stage_flags, uint32_t offset, uint32_t size, const void *values)
+    {
+        VV_ASSERT(offset % 4 == 0 && size % 4 == 0, "Push constant ranges have to be 4 byte aligned");
+
+        if (pipeline_layout != _push_constant_layout)
+        {
+            _push_constant_layout = pipeline_layout;
+            _push_constant_mask = 0;
+        }
+
+        bool trackable = offset + size <= max_push_constant_size;
+        const uint32_t first_word = offset / 4;
+        const uint32_t word_count = size / 4;
+        const uint32_t *words = static_cast<const uint32_t *>(values);
+
+        bool redundant = trackable;
+        for (uint32_t i = 0; i < word_count && redundant; ++i)
+        {
+            uint32_t w = first_word + i;
+            redundant = (_push_constant_mask & (1u << w)) && _push_constant_words[w] == words[i] && _push_constant_stages[w] == stage_flags;
+        }
+
+        if (!track(redundant))
+            return;
+
+        vkCmdPushConstants(command_buffer, pipeline_layout, stage_flags, offset, size, values);
+
+        for (uint32_t i = 0; i < word_count && trackable; ++i)
+        {
+            uint32_t w = first_word + i;
+            _push_constant_words[w] = words[i];
+            _push_constant_stages[w] = stage_flags;
+            _push_constant_mask |= 1u << w;
+        }
+    }
+
+
+    void VulkanCommandEncoder::bindVertexBuffer(uint32_t binding, VkBuffer buffer, VkDeviceSize offset)
+    {
+        bool trackable = binding < max_vertex_bindings;
+        if (!track(trackable && _vertex_buffers[binding] == buffer && _vertex_buffer_offsets[binding] == offset))
+            return;
+
+        vkCmdBindVertexBuffers(command_buffer, binding, 1, &buffer, &offset);
+
+        if (trackable)
+        {
+            _vertex_buffers[binding] = buffer;
+            _vertex_buffer_offsets[binding] = offset;
+        }
+    }
+
+
+    void VulkanCommandEncoder::bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType index_type)
+    {
+        if (!track(_index_buffer == buffer && _index_buffer_offset == offset && _index_type == index_type))
+            return;
+
+        vkCmdBindIndexBuffer(command_buffer, buffer, offset, index_type);
+        _index_buffer = buffer;
+        _index_buffer_offset = offset;
+        _index_type = index_type;
+    }
+
+
+    const CommandEncoderStatistics& VulkanCommandEncoder::getStatistics() const
+    {
+        return _statistics;
+    }
+
+
+    ///////////////////////////////////////////////////////////////////////////////////////////// Private
+    VulkanCommandEncoder::BindPointState& VulkanCommandEncoder::getBindPointState(VkPipelineBindPoint bind_point)
+    {
+        VV_ASSERT(bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS || bind_point == VK_PIPELINE_BIND_POINT_COMPUTE, "Unsupported pipeline bind point");
+        return _bind_points[(bind_point == VK_PIPELINE_BIND_POINT_COMPUTE) ? 1 : 0];
+    }
+
+
+    bool VulkanCommandEncoder::track(bool redundant)
+    {
+        if (redundant)
+            ++_statistics.elided_calls;
+        else
+            ++_statistics.issued_calls;
+
+        return !redundant;
+    }
+}
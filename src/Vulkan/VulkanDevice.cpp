@@ -14,7 +14,7 @@ namespace vv
 	}
 
 
-	void VulkanDevice::create(VkPhysicalDevice device)
+	void VulkanDevice::create(VkPhysicalDevice device, uint32_t instance_api_version)
 	{
 		physical_device = device;
 		VV_ASSERT(physical_device != VK_NULL_HANDLE, "Vulkan Physical Device NULL");
@@ -23,6 +23,8 @@ namespace vv
 		vkGetPhysicalDeviceProperties(physical_device, &physical_device_properties);
 		vkGetPhysicalDeviceFeatures(physical_device, &physical_device_features);
 		vkGetPhysicalDeviceMemoryProperties(physical_device, &physical_device_memory_properties);
+		api_version = std::min(instance_api_version, physical_device_properties.apiVersion);
+		queryDescriptorIndexingSupport();
 
 		uint32_t queue_family_properties_count = 0;
 		vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_properties_count, nullptr);
@@ -39,10 +41,25 @@ namespace vv
 	{
 		if (logical_device != VK_NULL_HANDLE)
 		{
+			// completion callbacks may still release staging memory, so this goes before the allocator
+			if (upload_queue)
+			{
+				upload_queue->shutDown();
+				delete upload_queue;
+				upload_queue = nullptr;
+			}
+
 			// Command Pool/Buffers
 			for (auto &pool : command_pools)
 				vkDestroyCommandPool(logical_device, pool.second, nullptr);
 
+			if (memory_allocator)
+			{
+				memory_allocator->shutDown();
+				delete memory_allocator;
+				memory_allocator = nullptr;
+			}
+
 			vkDestroyDevice(logical_device, nullptr);
 		}
 	}
@@ -101,12 +118,32 @@ namespace vv
 		if (swap_chain_support && checkDeviceExtensionSupport(VK_KHR_SWAPCHAIN_EXTENSION_NAME))
 			device_extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 
+		// lets the gpu decide how many indirect draws of a bucket actually run
+		bool draw_indirect_count_support = checkDeviceExtensionSupport(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+		if (draw_indirect_count_support)
+			device_extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
+		// only the features bindless materials use are turned on
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptor_indexing_features = {};
+		descriptor_indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+		if (descriptor_indexing)
+		{
+			device_extensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+			device_extensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+			descriptor_indexing_features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+			descriptor_indexing_features.runtimeDescriptorArray = VK_TRUE;
+			descriptor_indexing_features.descriptorBindingPartiallyBound = VK_TRUE;
+			descriptor_indexing_features.descriptorBindingVariableDescriptorCount = VK_TRUE;
+			descriptor_indexing_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		}
+
         VkDeviceCreateInfo device_create_info = {};
 		device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 		device_create_info.flags = 0;
 		device_create_info.pQueueCreateInfos = device_queue_create_infos.data();
 		device_create_info.queueCreateInfoCount = static_cast<uint32_t>(device_queue_create_infos.size());
 		device_create_info.pEnabledFeatures = &physical_device_features;
+		device_create_info.pNext = descriptor_indexing ? &descriptor_indexing_features : nullptr;
 
 		if (!device_extensions.empty())
 		{
@@ -118,6 +155,13 @@ namespace vv
 
 		VV_CHECK_SUCCESS(vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device));
 
+		if (draw_indirect_count_support)
+			cmd_draw_indexed_indirect_count = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+				vkGetDeviceProcAddr(logical_device, "vkCmdDrawIndexedIndirectCountKHR"));
+
+		memory_allocator = new VulkanMemoryAllocator();
+		memory_allocator->create(this);
+
 		// Set up queue handles.
         vkGetDeviceQueue(logical_device, graphics_family_index, 0, &graphics_queue);
 		createCommandPool("graphics", graphics_family_index, 0);
@@ -130,6 +174,9 @@ namespace vv
             vkGetDeviceQueue(logical_device, transfer_family_index, 0, &transfer_queue);
             createCommandPool("transfer", transfer_family_index, 0);
         }
+
+		upload_queue = new VulkanUploadQueue();
+		upload_queue->create(this);
 	}
 
 	
@@ -161,6 +208,21 @@ namespace vv
 		return 0;
 	}
 
+
+	uint32_t VulkanDevice::findMemoryTypeIndex(uint32_t filter_type, VkMemoryPropertyFlags required_flags, VkMemoryPropertyFlags preferred_flags)
+	{
+		auto memory_properties = physical_device_memory_properties;
+		VkMemoryPropertyFlags wanted_flags = required_flags | preferred_flags;
+
+		for (uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i)
+		{
+			if ((filter_type & (1 << i)) && (memory_properties.memoryTypes[i].propertyFlags & wanted_flags) == wanted_flags)
+				return i;
+		}
+
+		return findMemoryTypeIndex(filter_type, required_flags);
+	}
+
 	
 	///////////////////////////////////////////////////////////////////////////////////////////// Private
 	bool VulkanDevice::querySwapChainSupport(VkSurfaceKHR surface, VulkanSurfaceDetailsHandle &surface_details_handle)
@@ -232,4 +294,31 @@ namespace vv
 
 		return false;
 	}
-}
\ No newline at end of file
+
+
+	void VulkanDevice::queryDescriptorIndexingSupport()
+	{
+		if (api_version < VK_API_VERSION_1_1 || !checkDeviceExtensionSupport(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))
+			return;
+
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT features = {};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+		VkPhysicalDeviceFeatures2 features2 = {};
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features2.pNext = &features;
+		vkGetPhysicalDeviceFeatures2(physical_device, &features2);
+
+		VkPhysicalDeviceDescriptorIndexingPropertiesEXT properties = {};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+		VkPhysicalDeviceProperties2 properties2 = {};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &properties;
+		vkGetPhysicalDeviceProperties2(physical_device, &properties2);
+		max_bindless_sampled_images = std::min(properties.maxDescriptorSetUpdateAfterBindSampledImages,
+		                                       properties.maxPerStageDescriptorUpdateAfterBindSampledImages);
+
+		descriptor_indexing = features.shaderSampledImageArrayNonUniformIndexing && features.runtimeDescriptorArray &&
+		                      features.descriptorBindingPartiallyBound && features.descriptorBindingVariableDescriptorCount &&
+		                      features.descriptorBindingSampledImageUpdateAfterBind;
+	}
+}
@@ -1,4 +1,6 @@
 
+#include <algorithm>
+
 #include "VulkanImage.h"
 
 namespace vv
@@ -16,7 +18,7 @@ namespace vv
 
     void VulkanImage::create(VulkanDevice *device, VkExtent3D extent, VkFormat format, VkImageType type, VkImageCreateFlags flags,
                              VkImageAspectFlags aspect_flags, uint32_t mip_levels, uint32_t array_layers,
-                             VkImageLayout initial_layout, VkSampleCountFlagBits sample_count)
+                             VkImageLayout initial_layout, VkSampleCountFlagBits sample_count, VkImageUsageFlags usage)
     {
 		VV_ASSERT(device != VK_NULL_HANDLE, "VulkanDevice not present");
 		_device = device;
@@ -31,8 +33,8 @@ namespace vv
         this->sample_count = sample_count;
         this->initial_layout = initial_layout;
 
-        allocateMemory(VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-            flags, initial_layout, sample_count, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, _image_memory);
+        allocateMemory(VK_IMAGE_TILING_OPTIMAL, usage, flags, initial_layout, sample_count, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                       image, _image_allocation);
     }
 
 
@@ -49,7 +51,8 @@ namespace vv
 	}
 
 
-	void VulkanImage::createDepthAttachment(VulkanDevice *device, VkExtent2D extent, VkImageTiling tiling, VkFormatFeatureFlags features)
+	void VulkanImage::createDepthAttachment(VulkanDevice *device, VkExtent2D extent, VkImageTiling tiling, VkFormatFeatureFlags features,
+                                            VkImageUsageFlags additional_usage)
 	{
 		VV_ASSERT(device != VK_NULL_HANDLE, "VulkanDevice not present");
 		this->_device = device;
@@ -81,8 +84,8 @@ namespace vv
 			}
 		}
 
-		allocateMemory(VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED,
-                       VK_SAMPLE_COUNT_1_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, _image_memory);
+		allocateMemory(VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | additional_usage, 0, VK_IMAGE_LAYOUT_UNDEFINED,
+                       VK_SAMPLE_COUNT_1_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, _image_allocation);
 
 		if (hasStencilComponent())
 			this->aspect_flags |= VK_IMAGE_ASPECT_STENCIL_BIT;
@@ -98,31 +101,18 @@ namespace vv
 	void VulkanImage::shutDown()
 	{
 		vkDestroyImage(_device->logical_device, image, nullptr);
-		vkFreeMemory(_device->logical_device, _image_memory, nullptr);
+		_device->memory_allocator->free(_image_allocation);
 	}
 
     
     void VulkanImage::updateAndTransfer(void *data, VkDeviceSize size_in_bytes)
     {
-        auto command_pool_used = _device->command_pools["graphics"];
-        auto command_buffer = util::beginSingleUseCommand(_device->logical_device, command_pool_used);
-
         VkImageSubresourceRange subresource_range = {};
         subresource_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
         subresource_range.baseMipLevel = 0;
         subresource_range.levelCount = this->mip_levels;
         subresource_range.layerCount = this->array_layers;
 
-        transformImageLayout(command_buffer, image, subresource_range, initial_layout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-        // move host data to transfer buffer
-        allocateTransferMemory(size_in_bytes);
-        void *mapped_data;
-        vkMapMemory(_device->logical_device, _staging_memory, 0, size_in_bytes, 0, &mapped_data);
-        memcpy(mapped_data, data, size_in_bytes);
-        vkUnmapMemory(_device->logical_device, _staging_memory);
-        mapped_data = nullptr;
-
         const auto &format_info = _format_info_table.at(format);
 		const uint32_t block_size = format_info.block_size;
 		const uint32_t block_width = format_info.block_extent.width;
@@ -137,8 +127,8 @@ namespace vv
 		{
 			for (uint32_t level = 0; level < this->mip_levels; level++)
 			{
-				uint32_t image_width = (this->width >> level);
-				uint32_t image_height = (this->height >> level);
+				uint32_t image_width = std::max(1u, this->width >> level);
+				uint32_t image_height = std::max(1u, this->height >> level);
 				uint32_t block_count_x = (image_width + (block_width - 1)) / block_width;
 				uint32_t block_count_y = (image_height + (block_height - 1)) / block_height;
 				uint32_t block_count_z = (depth + (block_depth - 1)) / block_depth;
@@ -158,14 +148,9 @@ namespace vv
 			}
 		}
 
-		vkCmdCopyBufferToImage(command_buffer, _staging_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                               static_cast<uint32_t>(buffer_copy_regions.size()), buffer_copy_regions.data());
-
-        transformImageLayout(command_buffer, image, subresource_range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-        util::endSingleUseCommand(_device->logical_device, command_pool_used, command_buffer, _device->graphics_queue);
-
-        vkDestroyBuffer(_device->logical_device, _staging_buffer, nullptr);
-        vkFreeMemory(_device->logical_device, _staging_memory, nullptr);
+        // data is copied into the shared staging arena right away. the copy itself executes once the upload queue is flushed.
+        // copy offsets have to be a multiple of both 4 and the texel block size.
+        _device->upload_queue->uploadImage(data, size_in_bytes, block_size * 4, image, buffer_copy_regions, subresource_range, initial_layout);
     }
 
 
@@ -176,32 +161,9 @@ namespace vv
 
 
 	///////////////////////////////////////////////////////////////////////////////////////////// Private
-    void VulkanImage::allocateTransferMemory(VkDeviceSize size_in_bytes)
-    {
-        VkBufferCreateInfo buffer_create_info = {};
-        buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        buffer_create_info.flags = 0;
-        buffer_create_info.size = size_in_bytes;
-		buffer_create_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-		buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-		VV_CHECK_SUCCESS(vkCreateBuffer(_device->logical_device, &buffer_create_info, nullptr, &_staging_buffer));
-
-		VkMemoryRequirements memory_requirements = {};
-		vkGetBufferMemoryRequirements(_device->logical_device, _staging_buffer, &memory_requirements);
-
-        VkMemoryAllocateInfo memory_alloc_info = {};
-        memory_alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		memory_alloc_info.allocationSize = memory_requirements.size;
-		memory_alloc_info.memoryTypeIndex = _device->findMemoryTypeIndex(memory_requirements.memoryTypeBits,  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-		VV_CHECK_SUCCESS(vkAllocateMemory(_device->logical_device, &memory_alloc_info, nullptr, &_staging_memory));
-		VV_CHECK_SUCCESS(vkBindBufferMemory(_device->logical_device, _staging_buffer, _staging_memory, 0));
-    }
-
-
     void VulkanImage::allocateMemory(VkImageTiling tiling, VkImageUsageFlags usage, VkImageCreateFlags flags, VkImageLayout initial_layout,
                                      VkSampleCountFlagBits sample_count, VkMemoryPropertyFlags memory_properties, VkImage &image,
-                                     VkDeviceMemory &memory)
+                                     VulkanAllocation &allocation)
 	{
 		VkImageCreateInfo image_create_info = {};
 		image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -218,39 +180,19 @@ namespace vv
         image_create_info.initialLayout = initial_layout;
         image_create_info.samples = sample_count;
 
-        if (_device->transfer_family_index != -1)
-        {
-            image_create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
-            image_create_info.queueFamilyIndexCount = 2;
-            std::array<uint32_t, 2> queue_family_indices = {
-                static_cast<uint32_t>(_device->graphics_family_index),
-                static_cast<uint32_t>(_device->transfer_family_index)
-            };
-            image_create_info.pQueueFamilyIndices = queue_family_indices.data();
-        }
-        else
-        {
-            image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-            image_create_info.queueFamilyIndexCount = 1;
-            uint32_t queue_index = static_cast<uint32_t>(_device->graphics_family_index);
-            image_create_info.pQueueFamilyIndices = &queue_index;
-        }
+        // only ever owned by one queue family at a time. the upload queue transfers ownership explicitly.
+        image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
 		VV_CHECK_SUCCESS(vkCreateImage(_device->logical_device, &image_create_info, nullptr, &image));
 
 		// Determine requirements for memory (where it's allocated, type of memory, etc.)
 		VkMemoryRequirements memory_requirements = {};
 		vkGetImageMemoryRequirements(_device->logical_device, image, &memory_requirements);
-		auto memory_type = _device->findMemoryTypeIndex(memory_requirements.memoryTypeBits, memory_properties);
-
-		// Allocate and bind buffer memory.
-		VkMemoryAllocateInfo memory_allocate_info = {};
-		memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		memory_allocate_info.allocationSize = memory_requirements.size;
-		memory_allocate_info.memoryTypeIndex = memory_type;
 
-		VV_CHECK_SUCCESS(vkAllocateMemory(_device->logical_device, &memory_allocate_info, nullptr, &memory));
-		VV_CHECK_SUCCESS(vkBindImageMemory(_device->logical_device, image, memory, 0));
+		// Sub-allocate from a shared device memory block. tiled images never share a block with buffers.
+		ResourceTiling resource_tiling = (tiling == VK_IMAGE_TILING_LINEAR) ? ResourceTiling::Linear : ResourceTiling::Optimal;
+		_device->memory_allocator->allocate(memory_requirements, memory_properties, 0, resource_tiling, allocation);
+		VV_CHECK_SUCCESS(vkBindImageMemory(_device->logical_device, image, allocation.memory, allocation.offset));
 	}
 
 
@@ -265,22 +207,15 @@ namespace vv
 	void VulkanImage::transformImageLayout(VkImage image, VkImageSubresourceRange subresource_range, VkImageLayout old_layout, VkImageLayout new_layout,
                                            VkPipelineStageFlags old_stage, VkPipelineStageFlags new_stage)
 	{
+        // images are exclusively owned by the graphics family outside of uploads
         auto command_pool_used = _device->command_pools["graphics"];
-
-        // use transfer queue if available
-        if (_device->command_pools.count("transfer") > 0)
-            command_pool_used = _device->command_pools["transfer"];
-
 		auto command_buffer = util::beginSingleUseCommand(_device->logical_device, command_pool_used);
 
 		// using this ensures that writing is completed before reading.
         VkImageMemoryBarrier memory_barrier = determineAccessMasks(image, subresource_range, old_layout, new_layout);
 		vkCmdPipelineBarrier(command_buffer, old_stage, new_stage, 0, 0, nullptr, 0, nullptr, 1, &memory_barrier);
 
-        if (_device->transfer_family_index != -1)
-            util::endSingleUseCommand(_device->logical_device, command_pool_used, command_buffer, _device->transfer_queue);
-        else
-		    util::endSingleUseCommand(_device->logical_device, command_pool_used, command_buffer, _device->graphics_queue);
+		util::endSingleUseCommand(_device->logical_device, command_pool_used, command_buffer, _device->graphics_queue);
 	}
 
 
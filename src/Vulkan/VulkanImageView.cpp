@@ -14,6 +14,13 @@ namespace vv
 	}
 
 	void VulkanImageView::create(VulkanDevice *device, VulkanImage *image, VkImageViewType image_view_type, uint32_t base_mip_level)
+	{
+		create(device, image, image_view_type, image->aspect_flags, base_mip_level, image->mip_levels);
+	}
+
+
+	void VulkanImageView::create(VulkanDevice *device, VulkanImage *image, VkImageViewType image_view_type, VkImageAspectFlags aspect_flags,
+                                 uint32_t base_mip_level, uint32_t mip_level_count, VkComponentMapping components)
 	{
 		_device = device;
 		_image = image;
@@ -26,15 +33,11 @@ namespace vv
 		image_view_create_info.viewType = image_view_type;
 		image_view_create_info.format = image->format;
 
-		// todo: make general
-		image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-		image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-		image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-		image_view_create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+		image_view_create_info.components = components;
 
-		image_view_create_info.subresourceRange.aspectMask = image->aspect_flags;
+		image_view_create_info.subresourceRange.aspectMask = aspect_flags;
         image_view_create_info.subresourceRange.baseMipLevel = base_mip_level;
-		image_view_create_info.subresourceRange.levelCount = image->mip_levels;
+		image_view_create_info.subresourceRange.levelCount = mip_level_count;
 		image_view_create_info.subresourceRange.baseArrayLayer = 0;
 		image_view_create_info.subresourceRange.layerCount = image->array_layers;
 
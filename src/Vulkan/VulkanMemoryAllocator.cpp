@@ -0,0 +1,273 @@
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+#include "VulkanMemoryAllocator.h"
+#include "VulkanDevice.h"
+#include "Settings.h"
+
+namespace vv
+{
+    ///////////////////////////////////////////////////////////////////////////////////////////// Public
+    VulkanMemoryAllocator::VulkanMemoryAllocator()
+    {
+    }
+
+
+    VulkanMemoryAllocator::~VulkanMemoryAllocator()
+    {
+    }
+
+
+    void VulkanMemoryAllocator::create(VulkanDevice *device)
+    {
+        VV_ASSERT(device != VK_NULL_HANDLE, "VulkanDevice not present");
+        _device = device;
+        _pools.resize(_device->physical_device_memory_properties.memoryTypeCount * 2);
+    }
+
+
+    void VulkanMemoryAllocator::shutDown()
+    {
+        for (auto &pool : _pools)
+        {
+            for (auto &block : pool.blocks)
+            {
+                VV_ASSERT(block->allocation_count == 0, "Device memory block still has live allocations at shutdown");
+
+                if (block->mapped_data)
+                    vkUnmapMemory(_device->logical_device, block->memory);
+                vkFreeMemory(_device->logical_device, block->memory, nullptr);
+                delete block;
+            }
+            pool.blocks.clear();
+        }
+
+        VV_ASSERT(_dedicated_allocation_count == 0, "Dedicated device memory allocations leaked");
+    }
+
+
+    void VulkanMemoryAllocator::allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags required_flags, VkMemoryPropertyFlags preferred_flags,
+                                         ResourceTiling tiling, VulkanAllocation &allocation)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        uint32_t memory_type = _device->findMemoryTypeIndex(requirements.memoryTypeBits, required_flags, preferred_flags);
+        VkDeviceSize block_size = getBlockSize(memory_type);
+
+        allocation.memory_type = memory_type;
+        allocation.size = requirements.size;
+
+        // large resources (render targets, big textures) would waste most of a block. give them their own memory.
+        if (requirements.size > block_size / 2)
+        {
+            void *mapped_data = nullptr;
+            allocateDeviceMemory(memory_type, requirements.size, allocation.memory, mapped_data);
+            allocation.offset = 0;
+            allocation.mapped_data = mapped_data;
+            allocation.block = nullptr;
+
+            ++_dedicated_allocation_count;
+            _dedicated_bytes += requirements.size;
+            return;
+        }
+
+        uint32_t pool_index = memory_type * 2 + static_cast<uint32_t>(tiling);
+        auto &pool = _pools[pool_index];
+
+        VkDeviceSize offset = 0;
+        MemoryBlock *target_block = nullptr;
+        for (auto &block : pool.blocks)
+        {
+            if (block->size - block->used >= requirements.size && allocateFromBlock(block, requirements.size, requirements.alignment, offset))
+            {
+                target_block = block;
+                break;
+            }
+        }
+
+        // every block is full or too fragmented
+        if (!target_block)
+        {
+            target_block = new MemoryBlock();
+            target_block->size = block_size;
+
+            void *mapped_data = nullptr;
+            allocateDeviceMemory(memory_type, block_size, target_block->memory, mapped_data);
+            target_block->mapped_data = static_cast<uint8_t *>(mapped_data);
+            target_block->free_ranges[0] = block_size;
+            pool.blocks.push_back(target_block);
+
+            bool allocated = allocateFromBlock(target_block, requirements.size, requirements.alignment, offset);
+            VV_ASSERT(allocated, "Freshly created memory block could not hold the requested allocation");
+        }
+
+        target_block->used += requirements.size;
+        ++target_block->allocation_count;
+
+        allocation.memory = target_block->memory;
+        allocation.offset = offset;
+        allocation.mapped_data = target_block->mapped_data ? target_block->mapped_data + offset : nullptr;
+        allocation.block = target_block;
+        allocation.pool_index = pool_index;
+    }
+
+
+    void VulkanMemoryAllocator::free(VulkanAllocation &allocation)
+    {
+        if (allocation.memory == VK_NULL_HANDLE)
+            return;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (!allocation.block)
+        {
+            if (allocation.mapped_data)
+                vkUnmapMemory(_device->logical_device, allocation.memory);
+            vkFreeMemory(_device->logical_device, allocation.memory, nullptr);
+
+            --_dedicated_allocation_count;
+            _dedicated_bytes -= allocation.size;
+        }
+        else
+        {
+            MemoryBlock *block = allocation.block;
+            releaseToBlock(block, allocation.offset, allocation.size);
+            block->used -= allocation.size;
+            --block->allocation_count;
+
+            // keep one empty block around per pool so load/unload patterns don't thrash vkAllocateMemory
+            auto &pool = _pools[allocation.pool_index];
+            if (block->allocation_count == 0 && pool.blocks.size() > 1)
+            {
+                if (block->mapped_data)
+                    vkUnmapMemory(_device->logical_device, block->memory);
+                vkFreeMemory(_device->logical_device, block->memory, nullptr);
+                pool.blocks.erase(std::find(pool.blocks.begin(), pool.blocks.end(), block));
+                delete block;
+            }
+        }
+
+        allocation = VulkanAllocation();
+    }
+
+
+    MemoryStatistics VulkanMemoryAllocator::getStatistics()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        MemoryStatistics stats = {};
+        VkDeviceSize total_free = 0;
+
+        for (const auto &pool : _pools)
+        {
+            for (const auto &block : pool.blocks)
+            {
+                ++stats.block_count;
+                stats.allocation_count += block->allocation_count;
+                stats.bytes_reserved += block->size;
+                stats.bytes_used += block->used;
+
+                for (const auto &range : block->free_ranges)
+                {
+                    total_free += range.second;
+                    stats.largest_free_range = std::max(stats.largest_free_range, range.second);
+                }
+            }
+        }
+
+        stats.dedicated_allocation_count = _dedicated_allocation_count;
+        stats.allocation_count += _dedicated_allocation_count;
+        stats.bytes_reserved += _dedicated_bytes;
+        stats.bytes_used += _dedicated_bytes;
+
+        if (total_free > 0)
+            stats.fragmentation = 1.0f - static_cast<float>(stats.largest_free_range) / static_cast<float>(total_free);
+
+        return stats;
+    }
+
+
+    ///////////////////////////////////////////////////////////////////////////////////////////// Private
+    VkDeviceSize VulkanMemoryAllocator::getBlockSize(uint32_t memory_type) const
+    {
+        const auto &memory_properties = _device->physical_device_memory_properties;
+        VkDeviceSize heap_size = memory_properties.memoryHeaps[memory_properties.memoryTypes[memory_type].heapIndex].size;
+
+        return std::min(static_cast<VkDeviceSize>(Settings::inst()->getMemoryBlockSize()), heap_size / 8);
+    }
+
+
+    void VulkanMemoryAllocator::allocateDeviceMemory(uint32_t memory_type, VkDeviceSize size, VkDeviceMemory &memory, void *&mapped_data)
+    {
+        VkMemoryAllocateInfo memory_allocate_info = {};
+        memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        memory_allocate_info.allocationSize = size;
+        memory_allocate_info.memoryTypeIndex = memory_type;
+
+        if (vkAllocateMemory(_device->logical_device, &memory_allocate_info, nullptr, &memory) != VK_SUCCESS)
+            throw std::runtime_error("Failed to allocate device memory. The heap may be exhausted.");
+
+        // host visible blocks stay mapped for their whole lifetime. a VkDeviceMemory may only be mapped once, so
+        // every sub-allocation shares this pointer instead of mapping on its own.
+        mapped_data = nullptr;
+        if (_device->physical_device_memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+            VV_CHECK_SUCCESS(vkMapMemory(_device->logical_device, memory, 0, VK_WHOLE_SIZE, 0, &mapped_data));
+    }
+
+
+    bool VulkanMemoryAllocator::allocateFromBlock(MemoryBlock *block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset)
+    {
+        alignment = std::max(alignment, static_cast<VkDeviceSize>(1));
+
+        for (auto it = block->free_ranges.begin(); it != block->free_ranges.end(); ++it)
+        {
+            VkDeviceSize range_offset = it->first;
+            VkDeviceSize range_size = it->second;
+            VkDeviceSize aligned_offset = (range_offset + alignment - 1) / alignment * alignment;
+            VkDeviceSize padding = aligned_offset - range_offset;
+
+            if (padding + size > range_size)
+                continue;
+
+            block->free_ranges.erase(it);
+
+            // give back whatever this allocation does not cover on either side
+            if (padding > 0)
+                block->free_ranges[range_offset] = padding;
+            if (padding + size < range_size)
+                block->free_ranges[aligned_offset + size] = range_size - padding - size;
+
+            offset = aligned_offset;
+            return true;
+        }
+
+        return false;
+    }
+
+
+    void VulkanMemoryAllocator::releaseToBlock(MemoryBlock *block, VkDeviceSize offset, VkDeviceSize size)
+    {
+        auto next = block->free_ranges.lower_bound(offset);
+
+        // merge with the following range
+        if (next != block->free_ranges.end() && offset + size == next->first)
+        {
+            size += next->second;
+            next = block->free_ranges.erase(next);
+        }
+
+        // merge with the preceding range
+        if (next != block->free_ranges.begin())
+        {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset)
+            {
+                prev->second += size;
+                return;
+            }
+        }
+
+        block->free_ranges[offset] = size;
+    }
+}
@@ -15,9 +15,11 @@ namespace vv
 
 
 	void VulkanPipeline::create(VulkanDevice *device, Shader *shader, VkPipelineLayout pipeline_layout,
-                                VulkanRenderPass *render_pass, VkFrontFace front_face, bool depth_test_enable, bool depth_write_enable)
+                                VulkanRenderPass *render_pass, VkFrontFace front_face, bool depth_test_enable, bool depth_write_enable,
+                                VkCompareOp depth_compare_op)
 	{
 		_device = device;
+		const bool depth_only = (shader->frag_module == VK_NULL_HANDLE);
 
 		VkPipelineShaderStageCreateInfo vert_shader_create_info = {};
 		vert_shader_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -34,13 +36,15 @@ namespace vv
 		frag_shader_create_info.pName = "main";
 
 		std::array<VkPipelineShaderStageCreateInfo, 2> shaders = { vert_shader_create_info, frag_shader_create_info };
+		const uint32_t stage_count = depth_only ? 1 : 2;
 
 		// Fixed Function Pipeline Layout
 		VkPipelineVertexInputStateCreateInfo vertex_input_state_create_info = {};
 		vertex_input_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 		vertex_input_state_create_info.flags = 0;
 		vertex_input_state_create_info.vertexBindingDescriptionCount = 1;
-		vertex_input_state_create_info.vertexAttributeDescriptionCount = (uint32_t)Vertex::getAttributeDescriptions().size();
+		// position is the first attribute. depth only pipelines skip fetching the rest.
+		vertex_input_state_create_info.vertexAttributeDescriptionCount = depth_only ? 1 : (uint32_t)Vertex::getAttributeDescriptions().size();
 		vertex_input_state_create_info.pVertexBindingDescriptions = &Vertex::getBindingDesciption();
 		vertex_input_state_create_info.pVertexAttributeDescriptions = Vertex::getAttributeDescriptions().data();
 
@@ -101,7 +105,7 @@ namespace vv
 		depth_stencil_state_create_info.flags = 0;
 		depth_stencil_state_create_info.depthTestEnable = depth_test_enable;
 		depth_stencil_state_create_info.depthWriteEnable = depth_write_enable;
-		depth_stencil_state_create_info.depthCompareOp = VK_COMPARE_OP_LESS;
+		depth_stencil_state_create_info.depthCompareOp = depth_compare_op;
 		depth_stencil_state_create_info.depthBoundsTestEnable = VK_FALSE;
 		depth_stencil_state_create_info.minDepthBounds = 0.0f;
 		depth_stencil_state_create_info.maxDepthBounds = 1.0f;
@@ -112,7 +116,7 @@ namespace vv
 		// todo: for some reason, if this is activated the output color is overridden
 		// This along with color blend create info specify alpha blending operations
 		VkPipelineColorBlendAttachmentState color_blend_attachment_state = {};
-		color_blend_attachment_state.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+		color_blend_attachment_state.colorWriteMask = depth_only ? 0 : VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
 		color_blend_attachment_state.blendEnable = VK_FALSE;
 
 		VkPipelineColorBlendStateCreateInfo color_blend_state_create_info = {};
@@ -138,7 +142,7 @@ namespace vv
 		VkGraphicsPipelineCreateInfo graphics_pipeline_create_info = {};
 		graphics_pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 		graphics_pipeline_create_info.flags = 0;
-		graphics_pipeline_create_info.stageCount = 2;
+		graphics_pipeline_create_info.stageCount = stage_count;
 		graphics_pipeline_create_info.pStages = shaders.data();
 		graphics_pipeline_create_info.pVertexInputState = &vertex_input_state_create_info;
 		graphics_pipeline_create_info.pInputAssemblyState = &input_assembly_create_info;
@@ -159,6 +163,26 @@ namespace vv
 	}
 
 
+	void VulkanPipeline::createCompute(VulkanDevice *device, Shader *shader, VkPipelineLayout pipeline_layout)
+	{
+		_device = device;
+
+		VkPipelineShaderStageCreateInfo comp_shader_create_info = {};
+		comp_shader_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		comp_shader_create_info.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		comp_shader_create_info.module = shader->comp_module;
+		comp_shader_create_info.pName = "main";
+
+		VkComputePipelineCreateInfo compute_pipeline_create_info = {};
+		compute_pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		compute_pipeline_create_info.stage = comp_shader_create_info;
+		compute_pipeline_create_info.layout = pipeline_layout;
+		compute_pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
+
+		VV_CHECK_SUCCESS(vkCreateComputePipelines(_device->logical_device, VK_NULL_HANDLE, 1, &compute_pipeline_create_info, nullptr, &pipeline));
+	}
+
+
 	void VulkanPipeline::shutDown()
 	{
         vkDestroyPipeline(_device->logical_device, pipeline, nullptr);
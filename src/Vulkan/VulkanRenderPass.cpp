@@ -38,7 +38,7 @@ namespace vv
 		depth_attachment_description.format = swap_chain->depth_image->format;
 		depth_attachment_description.samples = VK_SAMPLE_COUNT_1_BIT;
 		depth_attachment_description.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		depth_attachment_description.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depth_attachment_description.storeOp = Settings::inst()->isOcclusionCullingEnabled() ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE; // read back for occlusion culling
 		depth_attachment_description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		depth_attachment_description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		depth_attachment_description.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
@@ -57,6 +57,12 @@ namespace vv
 		subpass_dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 		subpass_dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 
+		// the single depth attachment is shared by every frame in flight. order depth writes of consecutive frames.
+		subpass_dependency.srcStageMask |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		subpass_dependency.srcAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		subpass_dependency.dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		subpass_dependency.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
 		VkAttachmentReference color_attachment_reference = {};
 		color_attachment_reference.attachment = 0; // framebuffer at index 0
 		color_attachment_reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL; // use internal framebuffer as color texture
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "VulkanRingBuffer.h"
+
+namespace vv
+{
+    ///////////////////////////////////////////////////////////////////////////////////////////// Public
+    VulkanRingBuffer::VulkanRingBuffer()
+    {
+    }
+
+
+    VulkanRingBuffer::~VulkanRingBuffer()
+    {
+    }
+
+
+    void VulkanRingBuffer::create(VulkanDevice *device, VkBufferUsageFlags usage_flags, VkDeviceSize frame_size, uint32_t frame_count)
+    {
+        VV_ASSERT(device != VK_NULL_HANDLE, "VulkanDevice not present");
+        VV_ASSERT(frame_count > 0, "Ring buffer needs at least one frame region");
+        _device = device;
+
+        // every offset handed out has to be usable as a dynamic uniform/storage buffer offset
+        const auto &limits = _device->physical_device_properties.limits;
+        _alignment = std::max(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+        _alignment = std::max(_alignment, static_cast<VkDeviceSize>(1));
+
+        // keep every frame region aligned as well so the first allocation of each frame is valid
+        _frame_size = (frame_size + _alignment - 1) & ~(_alignment - 1);
+        this->size = _frame_size * frame_count;
+
+        VkBufferCreateInfo buffer_create_info = {};
+        buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        buffer_create_info.size = this->size;
+        buffer_create_info.usage = usage_flags;
+        buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE; // only ever read by the graphics queue
+
+        VV_CHECK_SUCCESS(vkCreateBuffer(_device->logical_device, &buffer_create_info, nullptr, &buffer));
+
+        VkMemoryRequirements memory_requirements = {};
+        vkGetBufferMemoryRequirements(_device->logical_device, buffer, &memory_requirements);
+
+        // write straight into vram when the whole of it is cpu addressable (resizable BAR). fall back to system memory otherwise.
+        // host visible memory comes back from the allocator persistently mapped. coherent memory means no explicit flushes are needed.
+        _device->memory_allocator->allocate(memory_requirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ResourceTiling::Linear, _allocation);
+        VV_CHECK_SUCCESS(vkBindBufferMemory(_device->logical_device, buffer, _allocation.memory, _allocation.offset));
+
+        is_device_local = (_device->physical_device_memory_properties.memoryTypes[_allocation.memory_type].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0;
+        _mapped_data = static_cast<uint8_t *>(_allocation.mapped_data);
+
+        beginFrame(0);
+    }
+
+
+    void VulkanRingBuffer::shutDown()
+    {
+        vkDestroyBuffer(_device->logical_device, buffer, nullptr);
+        _device->memory_allocator->free(_allocation);
+        _mapped_data = nullptr;
+    }
+
+
+    void VulkanRingBuffer::beginFrame(uint32_t frame_index)
+    {
+        _frame_begin = _frame_size * frame_index;
+        _head = _frame_begin;
+    }
+
+
+    void* VulkanRingBuffer::allocate(VkDeviceSize size, VkDeviceSize &offset)
+    {
+        VkDeviceSize aligned_size = (size + _alignment - 1) & ~(_alignment - 1);
+
+        if (_head + aligned_size > _frame_begin + _frame_size)
+            throw std::runtime_error("Ring buffer frame region exhausted. Increase Settings' uniform ring buffer size.");
+
+        offset = _head;
+        _head += aligned_size;
+        return _mapped_data + offset;
+    }
+
+
+    VkDeviceSize VulkanRingBuffer::write(const void *data, VkDeviceSize size)
+    {
+        VkDeviceSize offset = 0;
+        void *destination = allocate(size, offset);
+        std::memcpy(destination, data, static_cast<size_t>(size));
+        return offset;
+    }
+
+
+    VkDeviceSize VulkanRingBuffer::getFrameUsage() const
+    {
+        return _head - _frame_begin;
+    }
+
+
+    VkDeviceSize VulkanRingBuffer::getFrameSize() const
+    {
+        return _frame_size;
+    }
+
+
+    ///////////////////////////////////////////////////////////////////////////////////////////// Private
+}
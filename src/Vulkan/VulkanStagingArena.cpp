@@ -0,0 +1,100 @@
+#include <algorithm>
+
+#include "VulkanStagingArena.h"
+#include "VulkanDevice.h"
+
+namespace vv
+{
+    ///////////////////////////////////////////////////////////////////////////////////////////// Public
+    VulkanStagingArena::VulkanStagingArena()
+    {
+    }
+
+
+    VulkanStagingArena::~VulkanStagingArena()
+    {
+    }
+
+
+    void VulkanStagingArena::create(VulkanDevice *device, VkDeviceSize size)
+    {
+        VV_ASSERT(device != VK_NULL_HANDLE, "VulkanDevice not present");
+        _device = device;
+        this->size = size;
+
+        VkBufferCreateInfo buffer_create_info = {};
+        buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        buffer_create_info.size = size;
+        buffer_create_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE; // only ever read by the upload queue
+
+        VV_CHECK_SUCCESS(vkCreateBuffer(_device->logical_device, &buffer_create_info, nullptr, &buffer));
+
+        VkMemoryRequirements memory_requirements = {};
+        vkGetBufferMemoryRequirements(_device->logical_device, buffer, &memory_requirements);
+
+        _device->memory_allocator->allocate(memory_requirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0,
+                                            ResourceTiling::Linear, _allocation);
+        VV_CHECK_SUCCESS(vkBindBufferMemory(_device->logical_device, buffer, _allocation.memory, _allocation.offset));
+        _mapped_data = static_cast<uint8_t *>(_allocation.mapped_data);
+    }
+
+
+    void VulkanStagingArena::shutDown()
+    {
+        vkDestroyBuffer(_device->logical_device, buffer, nullptr);
+        _device->memory_allocator->free(_allocation);
+        _mapped_data = nullptr;
+    }
+
+
+    void* VulkanStagingArena::allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset)
+    {
+        if (size > this->size)
+            return nullptr;
+
+        if (_empty)
+        {
+            _head = 0;
+            _tail = 0;
+        }
+
+        alignment = std::max(alignment, static_cast<VkDeviceSize>(1));
+        VkDeviceSize start = (_head + alignment - 1) / alignment * alignment;
+
+        if (_empty || _head > _tail)
+        {
+            // free space is [_head, size) followed by [0, _tail)
+            if (start + size > this->size)
+            {
+                if (size > _tail)
+                    return nullptr;
+                start = 0;
+            }
+        }
+        else if (start + size > _tail)
+            return nullptr; // free space is only [_head, _tail)
+
+        offset = start;
+        _head = start + size;
+        _empty = false;
+        return _mapped_data + start;
+    }
+
+
+    VkDeviceSize VulkanStagingArena::getHead() const
+    {
+        return _head;
+    }
+
+
+    void VulkanStagingArena::release(VkDeviceSize end)
+    {
+        _tail = end;
+        if (_tail == _head)
+            _empty = true;
+    }
+
+
+    ///////////////////////////////////////////////////////////////////////////////////////////// Private
+}
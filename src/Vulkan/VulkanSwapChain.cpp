@@ -159,7 +159,13 @@ namespace vv
     	}
 
     	depth_image = new VulkanImage();
-        depth_image->createDepthAttachment(device, extent, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+
+        // gpu culling samples the depth of the last frame to build its depth pyramid
+        if (Settings::inst()->isGpuCullingEnabled())
+            depth_image->createDepthAttachment(device, extent, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT |
+                                               VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT, VK_IMAGE_USAGE_SAMPLED_BIT);
+        else
+            depth_image->createDepthAttachment(device, extent, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
     	depth_image_view = new VulkanImageView();
     	depth_image_view->create(device, depth_image, VK_IMAGE_VIEW_TYPE_2D, 0);
     }
@@ -0,0 +1,518 @@
+#include <cstring>
+
+#include "VulkanUploadQueue.h"
+#include "VulkanDevice.h"
+#include "Settings.h"
+
+namespace vv
+{
+    ///////////////////////////////////////////////////////////////////////////////////////////// Public
+    VulkanUploadQueue::VulkanUploadQueue()
+    {
+    }
+
+
+    VulkanUploadQueue::~VulkanUploadQueue()
+    {
+    }
+
+
+    void VulkanUploadQueue::create(VulkanDevice *device)
+    {
+        VV_ASSERT(device != VK_NULL_HANDLE, "VulkanDevice not present");
+        _device = device;
+
+        _graphics_family = static_cast<uint32_t>(_device->graphics_family_index);
+        _transfer_ownership = _device->transfer_family_index != -1 && _device->transfer_family_index != _device->graphics_family_index;
+        _transfer_family = _transfer_ownership ? static_cast<uint32_t>(_device->transfer_family_index) : _graphics_family;
+        _transfer_queue = _transfer_ownership ? _device->transfer_queue : _device->graphics_queue;
+
+        // batches are recycled individually, so their command buffers need to be resettable on their own
+        VkCommandPoolCreateFlags pool_flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        _device->createCommandPool("upload", _transfer_family, pool_flags);
+        _transfer_command_pool = _device->command_pools["upload"];
+
+        if (_transfer_ownership)
+        {
+            _device->createCommandPool("upload_acquire", _graphics_family, pool_flags);
+            _acquire_command_pool = _device->command_pools["upload_acquire"];
+        }
+
+        _staging_arena = new VulkanStagingArena();
+        _staging_arena->create(_device, Settings::inst()->getStagingArenaSize());
+    }
+
+
+    void VulkanUploadQueue::shutDown()
+    {
+        std::vector<std::function<void()> > callbacks;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            while (!_in_flight_batches.empty())
+            {
+                auto retired = retireCompletedBatches(true);
+                callbacks.insert(callbacks.end(), retired.begin(), retired.end());
+            }
+
+            // never submitted. resources it referenced may already be gone, so only its callbacks are honoured.
+            if (_open_batch)
+            {
+                callbacks.insert(callbacks.end(), _open_batch->callbacks.begin(), _open_batch->callbacks.end());
+                _free_batches.push_back(_open_batch);
+                _open_batch = nullptr;
+            }
+
+            // command buffers are released along with the pools owned by the device
+            for (auto &batch : _free_batches)
+            {
+                if (batch->transfer_complete != VK_NULL_HANDLE)
+                    util::destroyVulkanSemaphore(_device->logical_device, batch->transfer_complete);
+                util::destroyVulkanFence(_device->logical_device, batch->fence);
+                delete batch;
+            }
+            _free_batches.clear();
+
+            _staging_arena->shutDown();
+            delete _staging_arena;
+            _staging_arena = nullptr;
+        }
+
+        for (auto &callback : callbacks)
+            callback();
+    }
+
+
+    void VulkanUploadQueue::uploadBuffer(const void *data, VkDeviceSize size, VkBuffer dst, VkDeviceSize dst_offset, VkBufferUsageFlags dst_usage)
+    {
+        std::vector<std::function<void()> > callbacks;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            VkBuffer src = VK_NULL_HANDLE;
+            VkDeviceSize src_offset = 0;
+            void *staging_data = allocateStaging(size, 16, src, src_offset, callbacks);
+            std::memcpy(staging_data, data, static_cast<size_t>(size));
+
+            UploadBatch *batch = getOpenBatch();
+
+            VkBufferCopy buffer_copy = {};
+            buffer_copy.srcOffset = src_offset;
+            buffer_copy.dstOffset = dst_offset;
+            buffer_copy.size = size;
+            vkCmdCopyBuffer(batch->transfer_command_buffer, src, dst, 1, &buffer_copy);
+
+            VkPipelineStageFlags consumer_stages = 0;
+            VkAccessFlags consumer_access = 0;
+            determineBufferConsumers(dst_usage, consumer_stages, consumer_access);
+            batch->consumer_stages |= consumer_stages;
+
+            VkBufferMemoryBarrier barrier = {};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = consumer_access;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.buffer = dst;
+            barrier.offset = dst_offset;
+            barrier.size = size;
+
+            if (_transfer_ownership)
+            {
+                // release half. access on the destination side is defined by the matching acquire.
+                barrier.srcQueueFamilyIndex = _transfer_family;
+                barrier.dstQueueFamilyIndex = _graphics_family;
+                barrier.dstAccessMask = 0;
+                batch->buffer_releases.push_back(barrier);
+
+                barrier.srcAccessMask = 0;
+                barrier.dstAccessMask = consumer_access;
+                batch->buffer_acquires.push_back(barrier);
+            }
+            else
+                batch->buffer_releases.push_back(barrier);
+
+            batch->byte_count += size;
+            if (batch->byte_count >= Settings::inst()->getUploadBatchSize())
+                submitOpenBatch();
+        }
+
+        for (auto &callback : callbacks)
+            callback();
+    }
+
+
+    void VulkanUploadQueue::uploadImage(const void *data, VkDeviceSize size, VkDeviceSize alignment, VkImage dst, std::vector<VkBufferImageCopy> regions,
+                                        VkImageSubresourceRange subresource_range, VkImageLayout old_layout)
+    {
+        std::vector<std::function<void()> > callbacks;
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        VkBuffer src = VK_NULL_HANDLE;
+        VkDeviceSize src_offset = 0;
+        void *staging_data = allocateStaging(size, alignment, src, src_offset, callbacks);
+        std::memcpy(staging_data, data, static_cast<size_t>(size));
+
+        for (auto &region : regions)
+            region.bufferOffset += src_offset;
+
+        UploadBatch *batch = getOpenBatch();
+
+        // contents are overwritten entirely, so whatever was there before can be discarded
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = (old_layout == VK_IMAGE_LAYOUT_PREINITIALIZED) ? old_layout : VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = dst;
+        barrier.subresourceRange = subresource_range;
+        vkCmdPipelineBarrier(batch->transfer_command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        vkCmdCopyBufferToImage(batch->transfer_command_buffer, src, dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               static_cast<uint32_t>(regions.size()), regions.data());
+
+        // the layout transition is part of both halves of an ownership transfer and has to match exactly
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        batch->consumer_stages |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+        if (_transfer_ownership)
+        {
+            barrier.srcQueueFamilyIndex = _transfer_family;
+            barrier.dstQueueFamilyIndex = _graphics_family;
+            barrier.dstAccessMask = 0;
+            batch->image_releases.push_back(barrier);
+
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            batch->image_acquires.push_back(barrier);
+        }
+        else
+            batch->image_releases.push_back(barrier);
+
+        batch->byte_count += size;
+        if (batch->byte_count >= Settings::inst()->getUploadBatchSize())
+            submitOpenBatch();
+
+        lock.unlock();
+        for (auto &callback : callbacks)
+            callback();
+    }
+
+
+    void VulkanUploadQueue::onComplete(std::function<void()> callback)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        getOpenBatch()->callbacks.push_back(callback);
+    }
+
+
+    uint64_t VulkanUploadQueue::flush()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (_open_batch)
+            submitOpenBatch();
+
+        return _last_submitted_batch_id;
+    }
+
+
+    void VulkanUploadQueue::collect()
+    {
+        std::vector<std::function<void()> > callbacks;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            callbacks = retireCompletedBatches(false);
+        }
+
+        for (auto &callback : callbacks)
+            callback();
+    }
+
+
+    bool VulkanUploadQueue::isComplete(uint64_t batch_id)
+    {
+        collect();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        return batch_id <= _last_completed_batch_id;
+    }
+
+
+    void VulkanUploadQueue::wait(uint64_t batch_id)
+    {
+        std::vector<std::function<void()> > callbacks;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            if (_open_batch && _open_batch->id <= batch_id)
+                submitOpenBatch();
+
+            while (_last_completed_batch_id < batch_id && !_in_flight_batches.empty())
+            {
+                auto retired = retireCompletedBatches(true);
+                callbacks.insert(callbacks.end(), retired.begin(), retired.end());
+            }
+        }
+
+        for (auto &callback : callbacks)
+            callback();
+    }
+
+
+    void VulkanUploadQueue::waitIdle()
+    {
+        wait(flush());
+    }
+
+
+    ///////////////////////////////////////////////////////////////////////////////////////////// Private
+    VulkanUploadQueue::UploadBatch* VulkanUploadQueue::getOpenBatch()
+    {
+        if (_open_batch)
+            return _open_batch;
+
+        UploadBatch *batch = nullptr;
+        if (!_free_batches.empty())
+        {
+            batch = _free_batches.back();
+            _free_batches.pop_back();
+
+            VV_CHECK_SUCCESS(vkResetCommandBuffer(batch->transfer_command_buffer, 0));
+            if (batch->acquire_command_buffer != VK_NULL_HANDLE)
+                VV_CHECK_SUCCESS(vkResetCommandBuffer(batch->acquire_command_buffer, 0));
+            VV_CHECK_SUCCESS(vkResetFences(_device->logical_device, 1, &batch->fence));
+        }
+        else
+        {
+            batch = new UploadBatch();
+
+            VkCommandBufferAllocateInfo allocate_info = {};
+            allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocate_info.commandPool = _transfer_command_pool;
+            allocate_info.commandBufferCount = 1;
+            VV_CHECK_SUCCESS(vkAllocateCommandBuffers(_device->logical_device, &allocate_info, &batch->transfer_command_buffer));
+
+            if (_transfer_ownership)
+            {
+                allocate_info.commandPool = _acquire_command_pool;
+                VV_CHECK_SUCCESS(vkAllocateCommandBuffers(_device->logical_device, &allocate_info, &batch->acquire_command_buffer));
+                batch->transfer_complete = util::createVulkanSemaphore(_device->logical_device);
+            }
+
+            batch->fence = util::createVulkanFence(_device->logical_device, false);
+        }
+
+        batch->id = _next_batch_id++;
+        batch->byte_count = 0;
+        batch->consumer_stages = 0;
+
+        VkCommandBufferBeginInfo begin_info = {};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        VV_CHECK_SUCCESS(vkBeginCommandBuffer(batch->transfer_command_buffer, &begin_info));
+
+        _open_batch = batch;
+        return batch;
+    }
+
+
+    void VulkanUploadQueue::submitOpenBatch()
+    {
+        UploadBatch *batch = _open_batch;
+        _open_batch = nullptr;
+
+        // one barrier call for the whole batch instead of one per resource
+        if (!batch->buffer_releases.empty() || !batch->image_releases.empty())
+        {
+            // a transfer only queue cannot name graphics stages. the acquire on the graphics queue carries the real consumers.
+            VkPipelineStageFlags dst_stages = _transfer_ownership ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : batch->consumer_stages;
+            vkCmdPipelineBarrier(batch->transfer_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stages, 0, 0, nullptr,
+                                 static_cast<uint32_t>(batch->buffer_releases.size()), batch->buffer_releases.data(),
+                                 static_cast<uint32_t>(batch->image_releases.size()), batch->image_releases.data());
+        }
+        VV_CHECK_SUCCESS(vkEndCommandBuffer(batch->transfer_command_buffer));
+
+        VkSubmitInfo submit_info = {};
+        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers = &batch->transfer_command_buffer;
+
+        if (!_transfer_ownership)
+        {
+            VV_CHECK_SUCCESS(vkQueueSubmit(_transfer_queue, 1, &submit_info, batch->fence));
+        }
+        else
+        {
+            submit_info.signalSemaphoreCount = 1;
+            submit_info.pSignalSemaphores = &batch->transfer_complete;
+            VV_CHECK_SUCCESS(vkQueueSubmit(_transfer_queue, 1, &submit_info, VK_NULL_HANDLE));
+
+            VkCommandBufferBeginInfo begin_info = {};
+            begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            VV_CHECK_SUCCESS(vkBeginCommandBuffer(batch->acquire_command_buffer, &begin_info));
+
+            if (!batch->buffer_acquires.empty() || !batch->image_acquires.empty())
+            {
+                vkCmdPipelineBarrier(batch->acquire_command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, batch->consumer_stages, 0, 0, nullptr,
+                                     static_cast<uint32_t>(batch->buffer_acquires.size()), batch->buffer_acquires.data(),
+                                     static_cast<uint32_t>(batch->image_acquires.size()), batch->image_acquires.data());
+            }
+            VV_CHECK_SUCCESS(vkEndCommandBuffer(batch->acquire_command_buffer));
+
+            // rendering submitted after this point is ordered behind the acquire barriers
+            VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            VkSubmitInfo acquire_submit_info = {};
+            acquire_submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            acquire_submit_info.waitSemaphoreCount = 1;
+            acquire_submit_info.pWaitSemaphores = &batch->transfer_complete;
+            acquire_submit_info.pWaitDstStageMask = &wait_stage;
+            acquire_submit_info.commandBufferCount = 1;
+            acquire_submit_info.pCommandBuffers = &batch->acquire_command_buffer;
+            VV_CHECK_SUCCESS(vkQueueSubmit(_device->graphics_queue, 1, &acquire_submit_info, batch->fence));
+        }
+
+        _last_submitted_batch_id = batch->id;
+        _in_flight_batches.push_back(batch);
+    }
+
+
+    void* VulkanUploadQueue::allocateStaging(VkDeviceSize size, VkDeviceSize alignment, VkBuffer &src, VkDeviceSize &src_offset,
+                                             std::vector<std::function<void()> > &callbacks)
+    {
+        while (true)
+        {
+            void *staging_data = _staging_arena->allocate(size, alignment, src_offset);
+            if (staging_data)
+            {
+                UploadBatch *batch = getOpenBatch();
+                batch->uses_staging = true;
+                batch->staging_end = _staging_arena->getHead();
+                src = _staging_arena->buffer;
+                return staging_data;
+            }
+
+            // arena space held by the open batch only frees up once it has been submitted and executed
+            if (_open_batch && _open_batch->uses_staging)
+                submitOpenBatch();
+
+            if (_in_flight_batches.empty())
+                break;
+
+            auto retired = retireCompletedBatches(true);
+            callbacks.insert(callbacks.end(), retired.begin(), retired.end());
+        }
+
+        // larger than the whole arena. use a one off buffer that is released along with the batch.
+        VkBufferCreateInfo buffer_create_info = {};
+        buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        buffer_create_info.size = size;
+        buffer_create_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        VV_CHECK_SUCCESS(vkCreateBuffer(_device->logical_device, &buffer_create_info, nullptr, &src));
+
+        VkMemoryRequirements memory_requirements = {};
+        vkGetBufferMemoryRequirements(_device->logical_device, src, &memory_requirements);
+
+        VulkanAllocation allocation;
+        _device->memory_allocator->allocate(memory_requirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0,
+                                            ResourceTiling::Linear, allocation);
+        VV_CHECK_SUCCESS(vkBindBufferMemory(_device->logical_device, src, allocation.memory, allocation.offset));
+
+        VulkanDevice *device = _device;
+        VkBuffer staging_buffer = src;
+        getOpenBatch()->callbacks.push_back([device, staging_buffer, allocation]() mutable {
+            vkDestroyBuffer(device->logical_device, staging_buffer, nullptr);
+            device->memory_allocator->free(allocation);
+        });
+
+        src_offset = 0;
+        return allocation.mapped_data;
+    }
+
+
+    std::vector<std::function<void()> > VulkanUploadQueue::retireCompletedBatches(bool block)
+    {
+        std::vector<std::function<void()> > callbacks;
+
+        if (block && !_in_flight_batches.empty())
+            VV_CHECK_SUCCESS(vkWaitForFences(_device->logical_device, 1, &_in_flight_batches.front()->fence, VK_TRUE, UINT64_MAX));
+
+        while (!_in_flight_batches.empty())
+        {
+            UploadBatch *batch = _in_flight_batches.front();
+            if (vkGetFenceStatus(_device->logical_device, batch->fence) != VK_SUCCESS)
+                break;
+
+            callbacks.insert(callbacks.end(), batch->callbacks.begin(), batch->callbacks.end());
+            batch->callbacks.clear();
+
+            if (batch->uses_staging)
+                _staging_arena->release(batch->staging_end);
+            batch->uses_staging = false;
+            batch->buffer_releases.clear();
+            batch->image_releases.clear();
+            batch->buffer_acquires.clear();
+            batch->image_acquires.clear();
+
+            _last_completed_batch_id = batch->id;
+            _in_flight_batches.pop_front();
+            _free_batches.push_back(batch);
+        }
+
+        return callbacks;
+    }
+
+
+    void VulkanUploadQueue::determineBufferConsumers(VkBufferUsageFlags usage, VkPipelineStageFlags &stages, VkAccessFlags &access) const
+    {
+        stages = 0;
+        access = 0;
+
+        if (usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)
+        {
+            stages |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+            access |= VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+        }
+
+        if (usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT)
+        {
+            stages |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+            access |= VK_ACCESS_INDEX_READ_BIT;
+        }
+
+        if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+        {
+            stages |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            access |= VK_ACCESS_UNIFORM_READ_BIT;
+        }
+
+        if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+        {
+            stages |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+            access |= VK_ACCESS_SHADER_READ_BIT;
+        }
+
+        if (usage & VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)
+        {
+            stages |= VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+            access |= VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        }
+
+        // unknown consumer. be conservative.
+        if (stages == 0)
+        {
+            stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            access = VK_ACCESS_MEMORY_READ_BIT;
+        }
+    }
+}
@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <chrono>
 #include <array>
+#include <exception>
 
 #include "VulkanRenderer.h"
 #include "Settings.h"
@@ -71,11 +72,10 @@ namespace vv
 
 			createFrameBuffers();
 
-			image_ready_semaphore_ = util::createVulkanSemaphore(this->physical_device_->logical_device);
-			rendering_complete_semaphore_ = util::createVulkanSemaphore(this->physical_device_->logical_device);
+			createFrameSyncObjects();
 
             scene_ = new Scene();
-            scene_->create(physical_device_, render_pass_);
+            scene_->create(physical_device_, render_pass_, swap_chain_);
 		}
 		catch (const std::runtime_error& e)
 		{
@@ -87,10 +87,21 @@ namespace vv
 	void VulkanRenderer::shutDown()
 	{
 		// accounts for the issue of a logical device that might be executing commands when a terminating command is issued.
+		physical_device_->upload_queue->waitIdle();
 		vkDeviceWaitIdle(physical_device_->logical_device);
 
-	  	vkDestroySemaphore(physical_device_->logical_device, image_ready_semaphore_, nullptr);
-	  	vkDestroySemaphore(physical_device_->logical_device, rendering_complete_semaphore_, nullptr);
+		for (uint32_t i = 0; i < max_frames_in_flight_; ++i)
+		{
+			util::destroyVulkanSemaphore(physical_device_->logical_device, image_ready_semaphores_[i]);
+			util::destroyVulkanSemaphore(physical_device_->logical_device, rendering_complete_semaphores_[i]);
+			util::destroyVulkanFence(physical_device_->logical_device, in_flight_fences_[i]);
+		}
+
+        if (recording_thread_pool_)
+        {
+            recording_thread_pool_->shutDown();
+            delete recording_thread_pool_;
+        }
 
         scene_->shutDown();
 
@@ -113,12 +124,22 @@ namespace vv
 		// Poll window specific updates and input.
 		window_->run();
 
-        scene_->updateUniformData(swap_chain_->extent, delta_time);
+		// Submit uploads recorded since the last frame (i.e. models added at runtime) ahead of this frame's rendering
+		// and release staging memory of the ones that finished.
+		physical_device_->upload_queue->flush();
+		physical_device_->upload_queue->collect();
+
+		// Wait until the gpu is done with every resource owned by this frame slot before touching any of it.
+		VV_CHECK_SUCCESS(vkWaitForFences(physical_device_->logical_device, 1, &in_flight_fences_[current_frame_], VK_TRUE, UINT64_MAX));
+
+        scene_->updateUniformData(swap_chain_->extent, delta_time, current_frame_);
+        frame_statistics_.visible_draws = scene_->getCullingStatistics().visible_count;
+        frame_statistics_.culled_draws = scene_->getCullingStatistics().culled_count;
 
 		// Draw Frame
 		/// Acquire an image from the swap chain
 		uint32_t image_index = 0;
-		swap_chain_->acquireNextImage(physical_device_, image_ready_semaphore_, image_index);
+		swap_chain_->acquireNextImage(physical_device_, image_ready_semaphores_[current_frame_], image_index);
 
 		VkSubmitInfo submit_info = {};
 		submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -126,26 +147,56 @@ namespace vv
 		/// tell the queue to wait until a command buffer successfully attaches a swap chain image as a color attachment (wait until its ready to begin rendering).
 		std::array<VkPipelineStageFlags, 1> wait_stages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 		submit_info.waitSemaphoreCount = 1;
-		submit_info.pWaitSemaphores = &image_ready_semaphore_;
+		submit_info.pWaitSemaphores = &image_ready_semaphores_[current_frame_];
 		submit_info.pWaitDstStageMask = wait_stages.data();
 
 		/// Set the command buffer that will be used to rendering to be the one we waited for.
+		VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+		if (record_per_frame_)
+			command_buffer = recordFrameCommandBuffer(current_frame_, image_index);
+		else
+			command_buffer = command_buffers_[current_frame_ * frame_buffers_.size() + image_index];
+
 		submit_info.commandBufferCount = 1;
-		submit_info.pCommandBuffers = &command_buffers_[image_index];
+		submit_info.pCommandBuffers = &command_buffer;
 
 		/// Detail the semaphore that marks when rendering is complete.
-		std::array<VkSemaphore, 1> signal_semaphores = { rendering_complete_semaphore_ };
+		std::array<VkSemaphore, 1> signal_semaphores = { rendering_complete_semaphores_[current_frame_] };
 		submit_info.signalSemaphoreCount = 1;
 		submit_info.pSignalSemaphores = signal_semaphores.data();
 
-		VV_CHECK_SUCCESS(vkQueueSubmit(physical_device_->graphics_queue, 1, &submit_info, VK_NULL_HANDLE));
-		swap_chain_->queuePresent(physical_device_->graphics_queue, image_index, rendering_complete_semaphore_);
+		VV_CHECK_SUCCESS(vkResetFences(physical_device_->logical_device, 1, &in_flight_fences_[current_frame_]));
+		VV_CHECK_SUCCESS(vkQueueSubmit(physical_device_->graphics_queue, 1, &submit_info, in_flight_fences_[current_frame_]));
+		swap_chain_->queuePresent(physical_device_->graphics_queue, image_index, rendering_complete_semaphores_[current_frame_]);
+
+		current_frame_ = (current_frame_ + 1) % max_frames_in_flight_;
 	}
 
 
     void VulkanRenderer::recordCommandBuffers()
     {
-        command_buffers_.resize(frame_buffers_.size());
+        VkClearValue color_value, depth_value;
+        color_value.color = { 0.3f, 0.5f, 0.5f, 1.0f };
+        depth_value.depthStencil = {1.0f, 0};
+        clear_values_.clear();
+        clear_values_.push_back(color_value);
+        clear_values_.push_back(depth_value);
+
+        // ring buffer offsets get baked into pre-recorded command buffers, so every draw needs one up front
+        for (uint32_t i = 0; i < max_frames_in_flight_; ++i)
+            scene_->writeFrameUniforms(i);
+
+        // command buffers will be recorded inside of run() instead
+        record_per_frame_ = Settings::inst()->isPerFrameRecordingEnabled();
+        if (record_per_frame_)
+        {
+            createFrameCommandPools();
+            return;
+        }
+
+        // every frame in flight gets its own copy of the swap chain command buffers since each one binds that frame's uniform data.
+        const std::size_t image_count = frame_buffers_.size();
+        command_buffers_.resize(max_frames_in_flight_ * image_count);
 
         VkCommandBufferAllocateInfo command_buffer_allocate_info = {};
         command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -157,36 +208,51 @@ namespace vv
 
         VV_CHECK_SUCCESS(vkAllocateCommandBuffers(physical_device_->logical_device, &command_buffer_allocate_info, command_buffers_.data()));
 
-        std::vector<VkClearValue> clear_values;
-        VkClearValue color_value, depth_value;
-        color_value.color = { 0.3f, 0.5f, 0.5f, 1.0f };
-        depth_value.depthStencil = {1.0f, 0};
-        clear_values.push_back(color_value);
-        clear_values.push_back(depth_value);
+        for (uint32_t frame = 0; frame < max_frames_in_flight_; ++frame)
+		{
+            for (std::size_t i = 0; i < image_count; ++i)
+            {
+                recordCommandBuffer(command_buffers_[frame * image_count + i], frame, static_cast<uint32_t>(i),
+                                    VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT); // <- tells how long this buffer will be executed
+            }
+		}
+    }
 
-        scene_->allocateSceneDescriptorSets();
 
-		for (std::size_t i = 0; i < command_buffers_.size(); ++i)
-		{
-            VkCommandBufferBeginInfo command_buffer_begin_info = {};
-            command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-            command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT; // <- tells how long this buffer will be executed
-            command_buffer_begin_info.pInheritanceInfo = nullptr; // for if this is a secondary buffer
-            VV_CHECK_SUCCESS(vkBeginCommandBuffer(command_buffers_[i], &command_buffer_begin_info));
+    Scene* VulkanRenderer::getScene() const
+    {
+        return scene_;
+    }
 
-            render_pass_->beginRenderPass(command_buffers_[i], VK_SUBPASS_CONTENTS_INLINE, frame_buffers_[i], swap_chain_->extent, clear_values);
 
-            scene_->render(command_buffers_[i]);
+    const FrameStatistics& VulkanRenderer::getFrameStatistics() const
+    {
+        return frame_statistics_;
+    }
 
-            render_pass_->endRenderPass(command_buffers_[i]);
-            VV_CHECK_SUCCESS(vkEndCommandBuffer(command_buffers_[i]));
-		}
+
+    MemoryStatistics VulkanRenderer::getMemoryStatistics() const
+    {
+        return physical_device_->memory_allocator->getStatistics();
     }
 
 
-    Scene* VulkanRenderer::getScene() const
+    HostMemoryStatistics VulkanRenderer::getHostMemoryStatistics() const
     {
-        return scene_;
+        return scene_->getHostMemoryStatistics();
+    }
+
+
+    const ImportStatistics& VulkanRenderer::getImportStatistics() const
+    {
+        return scene_->getImportStatistics();
+    }
+
+
+    void VulkanRenderer::resetFrameStatistics()
+    {
+        frame_statistics_.frames_over_budget = 0;
+        frame_statistics_.max_record_time = 0.0;
     }
 
 
@@ -212,7 +278,15 @@ namespace vv
 		app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 		app_info.pEngineName = engine_name.c_str();
 		app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-		app_info.apiVersion = VK_API_VERSION_1_0;
+		// 1.1 is needed to query optional features such as descriptor indexing. 1.0 loaders don't know vkEnumerateInstanceVersion.
+		auto enumerate_instance_version = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
+		if (enumerate_instance_version)
+		{
+			uint32_t loader_version = VK_API_VERSION_1_0;
+			VV_CHECK_SUCCESS(enumerate_instance_version(&loader_version));
+			instance_api_version_ = (loader_version >= VK_API_VERSION_1_1) ? VK_API_VERSION_1_1 : VK_API_VERSION_1_0;
+		}
+		app_info.apiVersion = instance_api_version_;
 
 		// Ensure required extensions are found.
 		VV_ASSERT(checkInstanceExtensionSupport(), "Extensions requested, but are not available on this system.");
@@ -370,7 +444,7 @@ namespace vv
 		for (const auto& device : physical_devices)
 		{
             physical_device_ = new VulkanDevice;
-            physical_device_->create(device);
+            physical_device_->create(device, instance_api_version_);
 			VulkanSurfaceDetailsHandle surface_details_handle = {};
 			if (physical_device_->isSuitable(window_->surface, surface_details_handle))
 			{
@@ -390,6 +464,230 @@ namespace vv
 	}
 
 
+	void VulkanRenderer::createFrameSyncObjects()
+	{
+		max_frames_in_flight_ = Settings::inst()->getMaxFramesInFlight();
+		VV_ASSERT(max_frames_in_flight_ > 0, "ERROR: at least one frame in flight is required");
+
+		image_ready_semaphores_.resize(max_frames_in_flight_);
+		rendering_complete_semaphores_.resize(max_frames_in_flight_);
+		in_flight_fences_.resize(max_frames_in_flight_);
+
+		for (uint32_t i = 0; i < max_frames_in_flight_; ++i)
+		{
+			image_ready_semaphores_[i] = util::createVulkanSemaphore(physical_device_->logical_device);
+			rendering_complete_semaphores_[i] = util::createVulkanSemaphore(physical_device_->logical_device);
+
+			// created signaled so the very first wait on each frame slot returns immediately.
+			in_flight_fences_[i] = util::createVulkanFence(physical_device_->logical_device, true);
+		}
+	}
+
+
+	void VulkanRenderer::createFrameCommandPools()
+	{
+		frame_command_pools_.resize(max_frames_in_flight_);
+		frame_command_buffers_.resize(max_frames_in_flight_);
+
+		for (uint32_t i = 0; i < max_frames_in_flight_; ++i)
+		{
+			// pools are owned (and destroyed) by the device. transient tells the driver these buffers are short lived.
+			std::string name = "graphics_frame_" + std::to_string(i);
+			physical_device_->createCommandPool(name, physical_device_->graphics_family_index, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+			frame_command_pools_[i] = physical_device_->command_pools[name];
+
+			VkCommandBufferAllocateInfo command_buffer_allocate_info = {};
+			command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			command_buffer_allocate_info.commandPool = frame_command_pools_[i];
+			command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			command_buffer_allocate_info.commandBufferCount = 1;
+
+			VV_CHECK_SUCCESS(vkAllocateCommandBuffers(physical_device_->logical_device, &command_buffer_allocate_info, &frame_command_buffers_[i]));
+		}
+
+		uint32_t thread_count = Settings::inst()->getRecordingThreadCount();
+		if (thread_count <= 1)
+			return;
+
+		recording_thread_pool_ = new ThreadPool();
+		recording_thread_pool_->create(thread_count);
+
+		secondary_command_pools_.resize(max_frames_in_flight_);
+		secondary_command_buffers_.resize(max_frames_in_flight_);
+
+		for (uint32_t i = 0; i < max_frames_in_flight_; ++i)
+		{
+			secondary_command_pools_[i].resize(thread_count);
+			secondary_command_buffers_[i].resize(thread_count);
+
+			for (uint32_t j = 0; j < thread_count; ++j)
+			{
+				std::string name = "graphics_frame_" + std::to_string(i) + "_chunk_" + std::to_string(j);
+				physical_device_->createCommandPool(name, physical_device_->graphics_family_index, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+				secondary_command_pools_[i][j] = physical_device_->command_pools[name];
+
+				VkCommandBufferAllocateInfo command_buffer_allocate_info = {};
+				command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+				command_buffer_allocate_info.commandPool = secondary_command_pools_[i][j];
+				command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+				command_buffer_allocate_info.commandBufferCount = 1;
+
+				VV_CHECK_SUCCESS(vkAllocateCommandBuffers(physical_device_->logical_device, &command_buffer_allocate_info, &secondary_command_buffers_[i][j]));
+			}
+		}
+	}
+
+
+	void VulkanRenderer::recordCommandBuffer(VkCommandBuffer command_buffer, uint32_t frame_index, uint32_t image_index,
+                                             VkCommandBufferUsageFlags usage_flags)
+	{
+		VkCommandBufferBeginInfo command_buffer_begin_info = {};
+		command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		command_buffer_begin_info.flags = usage_flags;
+		command_buffer_begin_info.pInheritanceInfo = nullptr; // for if this is a secondary buffer
+		VV_CHECK_SUCCESS(vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info));
+
+		// instance counts of the indirect draws are written by the gpu before the render pass starts
+		scene_->recordCulling(command_buffer, frame_index);
+
+		// secondary command buffers are only used when recording every frame
+		if (record_per_frame_ && recording_thread_pool_)
+		{
+			render_pass_->beginRenderPass(command_buffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, frame_buffers_[image_index], swap_chain_->extent, clear_values_);
+			recordSecondaryCommandBuffers(command_buffer, frame_index, image_index);
+		}
+		else
+		{
+			render_pass_->beginRenderPass(command_buffer, VK_SUBPASS_CONTENTS_INLINE, frame_buffers_[image_index], swap_chain_->extent, clear_values_);
+
+			VulkanCommandEncoder encoder;
+			encoder.begin(command_buffer);
+			scene_->render(encoder, frame_index);
+
+			frame_statistics_.issued_state_calls = encoder.getStatistics().issued_calls;
+			frame_statistics_.elided_state_calls = encoder.getStatistics().elided_calls;
+		}
+
+		render_pass_->endRenderPass(command_buffer);
+		scene_->recordDepthPyramid(command_buffer);
+		VV_CHECK_SUCCESS(vkEndCommandBuffer(command_buffer));
+	}
+
+
+	void VulkanRenderer::recordSecondaryCommandBuffers(VkCommandBuffer primary_command_buffer, uint32_t frame_index, uint32_t image_index)
+	{
+		const auto &pools = secondary_command_pools_[frame_index];
+		const auto &command_buffers = secondary_command_buffers_[frame_index];
+
+		const std::size_t chunk_count = command_buffers.size();
+		const std::size_t bucket_count = scene_->_draw_buckets.size();
+		const std::size_t chunk_size = (bucket_count + chunk_count - 1) / chunk_count;
+
+		// secondary buffers continue the primary's render pass, so they need to know which one they are executed in.
+		VkCommandBufferInheritanceInfo inheritance_info = {};
+		inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritance_info.renderPass = render_pass_->render_pass;
+		inheritance_info.subpass = 0;
+		inheritance_info.framebuffer = frame_buffers_[image_index];
+
+		// every chunk writes only its own entry, summed up once all of them are done
+		std::vector<CommandEncoderStatistics> chunk_statistics(chunk_count);
+
+		// an exception escaping a worker would terminate the process, so it is carried back to this thread instead
+		std::vector<std::exception_ptr> chunk_errors(chunk_count);
+
+		for (std::size_t chunk = 0; chunk < chunk_count; ++chunk)
+		{
+			std::size_t first_bucket = std::min(chunk * chunk_size, bucket_count);
+			std::size_t chunk_bucket_count = std::min(chunk_size, bucket_count - first_bucket);
+			VkCommandPool pool = pools[chunk];
+			VkCommandBuffer command_buffer = command_buffers[chunk];
+
+			recording_thread_pool_->enqueue([=, &inheritance_info, &chunk_statistics, &chunk_errors]()
+			{
+				try
+				{
+					// each chunk exclusively owns its pool, so no locking is needed around any of these calls
+					VV_CHECK_SUCCESS(vkResetCommandPool(physical_device_->logical_device, pool, 0));
+
+					VkCommandBufferBeginInfo begin_info = {};
+					begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+					begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+					begin_info.pInheritanceInfo = &inheritance_info;
+					VV_CHECK_SUCCESS(vkBeginCommandBuffer(command_buffer, &begin_info));
+
+					// secondary command buffers don't inherit any bound state, so each chunk tracks its own
+					VulkanCommandEncoder encoder;
+					encoder.begin(command_buffer);
+
+					// every bucket's depth has to be down before any of them is shaded, so the first chunk records all of it.
+					// skybox goes next so it keeps rendering behind everything else
+					if (chunk == 0)
+					{
+						if (scene_->isDepthPrePassEnabled())
+							scene_->renderDepthPrePass(encoder, frame_index, 0, bucket_count);
+						scene_->renderSkyBox(encoder, frame_index);
+					}
+
+					if (chunk_bucket_count > 0)
+						scene_->renderModels(encoder, frame_index, first_bucket, chunk_bucket_count);
+
+					chunk_statistics[chunk] = encoder.getStatistics();
+					VV_CHECK_SUCCESS(vkEndCommandBuffer(command_buffer));
+				}
+				catch (...)
+				{
+					chunk_errors[chunk] = std::current_exception();
+				}
+			});
+		}
+
+		recording_thread_pool_->wait();
+
+		for (const auto &error : chunk_errors)
+			if (error)
+				std::rethrow_exception(error);
+
+		frame_statistics_.issued_state_calls = 0;
+		frame_statistics_.elided_state_calls = 0;
+		for (const auto &statistics : chunk_statistics)
+		{
+			frame_statistics_.issued_state_calls += statistics.issued_calls;
+			frame_statistics_.elided_state_calls += statistics.elided_calls;
+		}
+
+		// executing in chunk order preserves the single threaded draw order
+		vkCmdExecuteCommands(primary_command_buffer, static_cast<uint32_t>(chunk_count), command_buffers.data());
+	}
+
+
+	VkCommandBuffer VulkanRenderer::recordFrameCommandBuffer(uint32_t frame_index, uint32_t image_index)
+	{
+		auto start_time = std::chrono::high_resolution_clock::now();
+
+		// the fence for this frame has already been waited on, so nothing allocated from this pool is still in use.
+		// resetting the whole pool recycles its memory without the cost of freeing individual command buffers.
+		VV_CHECK_SUCCESS(vkResetCommandPool(physical_device_->logical_device, frame_command_pools_[frame_index], 0));
+
+		VkCommandBuffer command_buffer = frame_command_buffers_[frame_index];
+		recordCommandBuffer(command_buffer, frame_index, image_index, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start_time;
+		double record_time = elapsed.count();
+
+		frame_statistics_.frame_count++;
+		frame_statistics_.last_record_time = record_time;
+		frame_statistics_.max_record_time = std::max(frame_statistics_.max_record_time, record_time);
+		frame_statistics_.average_record_time = (frame_statistics_.frame_count == 1) ? record_time :
+			frame_statistics_.average_record_time * 0.95 + record_time * 0.05;
+
+		if (record_time > Settings::inst()->getRecordingBudget())
+			frame_statistics_.frames_over_budget++;
+
+		return command_buffer;
+	}
+
+
 	void VulkanRenderer::createFrameBuffers()
 	{
 		frame_buffers_.resize(swap_chain_->color_image_views.size());
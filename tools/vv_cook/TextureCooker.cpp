@@ -0,0 +1,228 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#include "TextureCooker.h"
+
+namespace vv
+{
+    // halves an rgba8 image. odd edges reuse their last texel instead of reading past the end.
+    static void downsample(const std::vector<uint8_t> &source, uint32_t width, uint32_t height, std::vector<uint8_t> &result)
+    {
+        uint32_t result_width = std::max(1u, width / 2);
+        uint32_t result_height = std::max(1u, height / 2);
+        result.resize(result_width * result_height * 4);
+
+        for (uint32_t y = 0; y < result_height; ++y)
+        {
+            uint32_t y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+            for (uint32_t x = 0; x < result_width; ++x)
+            {
+                uint32_t x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+                for (uint32_t c = 0; c < 4; ++c)
+                {
+                    uint32_t sum = source[(y0 * width + x0) * 4 + c] + source[(y0 * width + x1) * 4 + c] +
+                                   source[(y1 * width + x0) * 4 + c] + source[(y1 * width + x1) * 4 + c];
+                    result[(y * result_width + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+                }
+            }
+        }
+    }
+
+
+    static uint16_t packRGB565(const uint8_t *color)
+    {
+        return static_cast<uint16_t>(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+    }
+
+
+    static void unpackRGB565(uint16_t packed, int *color)
+    {
+        int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+
+    // 8 bytes of bc1 color data. always in four color mode, which is also how bc3 reads its color block.
+    static void compressColorBlock(const uint8_t *texels, uint8_t *output)
+    {
+        uint8_t min[3] = { 255, 255, 255 };
+        uint8_t max[3] = { 0, 0, 0 };
+        for (int i = 0; i < 16; ++i)
+            for (int c = 0; c < 3; ++c)
+            {
+                min[c] = std::min(min[c], texels[i * 4 + c]);
+                max[c] = std::max(max[c], texels[i * 4 + c]);
+            }
+
+        // pulling the endpoints in by 1/16th of the range lowers the error of the colors in between
+        for (int c = 0; c < 3; ++c)
+        {
+            uint8_t inset = static_cast<uint8_t>((max[c] - min[c]) >> 4);
+            min[c] = static_cast<uint8_t>(min[c] + inset);
+            max[c] = static_cast<uint8_t>(max[c] - inset);
+        }
+
+        uint16_t color0 = packRGB565(max);
+        uint16_t color1 = packRGB565(min);
+        if (color0 < color1)
+            std::swap(color0, color1);
+
+        int palette[4][3];
+        unpackRGB565(color0, palette[0]);
+        unpackRGB565(color1, palette[1]);
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        uint32_t indices = 0;
+        for (int i = 0; i < 16 && color0 != color1; ++i)
+        {
+            int best = 0, best_distance = INT_MAX;
+            for (int p = 0; p < 4; ++p)
+            {
+                int distance = 0;
+                for (int c = 0; c < 3; ++c)
+                    distance += (texels[i * 4 + c] - palette[p][c]) * (texels[i * 4 + c] - palette[p][c]);
+
+                if (distance < best_distance)
+                {
+                    best = p;
+                    best_distance = distance;
+                }
+            }
+            indices |= static_cast<uint32_t>(best) << (2 * i);
+        }
+
+        output[0] = static_cast<uint8_t>(color0 & 0xFF);
+        output[1] = static_cast<uint8_t>(color0 >> 8);
+        output[2] = static_cast<uint8_t>(color1 & 0xFF);
+        output[3] = static_cast<uint8_t>(color1 >> 8);
+        for (int i = 0; i < 4; ++i)
+            output[4 + i] = static_cast<uint8_t>(indices >> (8 * i));
+    }
+
+
+    // 8 bytes of bc3 alpha data, interpolating 8 values between the smallest and largest alpha
+    static void compressAlphaBlock(const uint8_t *texels, uint8_t *output)
+    {
+        int alpha0 = 0, alpha1 = 255;
+        for (int i = 0; i < 16; ++i)
+        {
+            alpha0 = std::max<int>(alpha0, texels[i * 4 + 3]);
+            alpha1 = std::min<int>(alpha1, texels[i * 4 + 3]);
+        }
+
+        uint64_t indices = 0;
+        for (int i = 0; i < 16 && alpha0 != alpha1; ++i)
+        {
+            // index 0 and 1 are the endpoints, 2 to 7 step from alpha0 towards alpha1
+            int a = texels[i * 4 + 3];
+            int step = ((alpha0 - a) * 7 + (alpha0 - alpha1) / 2) / (alpha0 - alpha1);
+            int index = (step == 0) ? 0 : (step == 7) ? 1 : step + 1;
+            indices |= static_cast<uint64_t>(index) << (3 * i);
+        }
+
+        output[0] = static_cast<uint8_t>(alpha0);
+        output[1] = static_cast<uint8_t>(alpha1);
+        for (int i = 0; i < 6; ++i)
+            output[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+    }
+
+
+    static void compressLevel(const std::vector<uint8_t> &texels, uint32_t width, uint32_t height, VkFormat format, char *output)
+    {
+        const uint32_t block_size = (format == VK_FORMAT_BC3_UNORM_BLOCK) ? 16 : 8;
+        uint8_t block[64];
+
+        for (uint32_t by = 0; by < height; by += 4)
+        {
+            for (uint32_t bx = 0; bx < width; bx += 4)
+            {
+                // blocks hanging over the edge repeat the last row and column
+                for (uint32_t i = 0; i < 16; ++i)
+                {
+                    uint32_t x = std::min(bx + i % 4, width - 1);
+                    uint32_t y = std::min(by + i / 4, height - 1);
+                    std::memcpy(block + i * 4, &texels[(y * width + x) * 4], 4);
+                }
+
+                uint8_t *block_output = reinterpret_cast<uint8_t *>(output);
+                if (format == VK_FORMAT_BC3_UNORM_BLOCK)
+                {
+                    compressAlphaBlock(block, block_output);
+                    compressColorBlock(block, block_output + 8);
+                }
+                else
+                    compressColorBlock(block, block_output);
+
+                output += block_size;
+            }
+        }
+    }
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////// Public
+	TextureCooker::TextureCooker()
+	{
+	}
+
+
+	TextureCooker::~TextureCooker()
+	{
+	}
+
+
+    bool TextureCooker::cook(const std::string &path, const std::string &name, TextureCache &cache, std::string &error)
+    {
+        int width, height, channels;
+        unsigned char *decoded = stbi_load((path + name).c_str(), &width, &height, &channels, STBI_rgb_alpha);
+        if (!decoded)
+        {
+            error = "Could not decode " + path + name + ": " + stbi_failure_reason();
+            return false;
+        }
+
+        std::vector<uint8_t> level(decoded, decoded + width * height * 4);
+        stbi_image_free(decoded);
+
+        bool opaque = true;
+        for (std::size_t i = 3; i < level.size() && opaque; i += 4)
+            opaque = level[i] == 255;
+
+        cache.format = opaque ? VK_FORMAT_BC1_RGB_UNORM_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+        cache.width = static_cast<uint32_t>(width);
+        cache.height = static_cast<uint32_t>(height);
+        cache.mip_levels = 1;
+        while ((std::max(cache.width, cache.height) >> cache.mip_levels) > 0)
+            ++cache.mip_levels;
+
+        cache.data.resize(static_cast<std::size_t>(cache.getSize(cache.mip_levels)));
+        char *output = cache.data.data();
+
+        uint32_t level_width = cache.width, level_height = cache.height;
+        std::vector<uint8_t> next_level;
+        for (uint32_t i = 0; i < cache.mip_levels; ++i)
+        {
+            compressLevel(level, level_width, level_height, cache.format, output);
+            output += TextureCache::getLevelSize(cache.format, cache.width, cache.height, i);
+
+            if (i + 1 < cache.mip_levels)
+            {
+                downsample(level, level_width, level_height, next_level);
+                level.swap(next_level);
+                level_width = std::max(1u, level_width / 2);
+                level_height = std::max(1u, level_height / 2);
+            }
+        }
+
+        return true;
+    }
+}
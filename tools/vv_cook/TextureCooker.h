@@ -0,0 +1,31 @@
+#ifndef VIRTUALVISTA_TEXTURECOOKER_H
+#define VIRTUALVISTA_TEXTURECOOKER_H
+
+#include <string>
+
+#include "TextureCache.h"
+
+namespace vv
+{
+	/*
+	 * Turns png and jpeg images into the runtime ready textures TextureManager maps. The full mip chain is built with a
+	 * box filter and every level is block compressed: BC1 if the image is opaque, BC3 if it uses alpha.
+	 *
+	 * note: the compressor fits endpoints to the bounding box of each block. That is fast and good enough for albedo
+	 *       and material maps, but not the best possible quality.
+	 */
+	class TextureCooker
+	{
+	public:
+		TextureCooker();
+		~TextureCooker();
+
+        /*
+         * Decodes path + name and fills cache with its compressed mip chain. Returns false and fills error if the image
+         * can't be decoded. Safe to call for several images at once.
+         */
+        bool cook(const std::string &path, const std::string &name, TextureCache &cache, std::string &error);
+	};
+}
+
+#endif // VIRTUALVISTA_TEXTURECOOKER_H
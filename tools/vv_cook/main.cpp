@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+    #define NOMINMAX
+    #include <Windows.h>
+#else
+    #include <dirent.h>
+    #include <sys/stat.h>
+#endif
+
+#include "Settings.h"
+#include "ThreadPool.h"
+#include "MeshCache.h"
+#include "Shader.h"
+#include "TextureCooker.h"
+
+using namespace vv;
+
+/*
+ * Offline asset cooker. Imports every model, texture and shader under the asset directory once and writes the
+ * runtime ready files next to them: .vvmesh for models, .vvtex for textures and .vvshader for shader reflection.
+ * ModelManager, TextureManager and Shader pick those up instead of their sources as long as they are current.
+ *
+ * note: shaders have to be compiled with CompileShaders.sh first. Cooking only reads their .spv files.
+ */
+
+// Appends every file below directory + relative to files, relative to directory.
+static void listFiles(const std::string &directory, const std::string &relative, std::vector<std::string> &files)
+{
+#ifdef _WIN32
+    WIN32_FIND_DATAA entry;
+    HANDLE find = FindFirstFileA((directory + relative + "*").c_str(), &entry);
+    if (find == INVALID_HANDLE_VALUE)
+        return;
+
+    do
+    {
+        std::string name = entry.cFileName;
+        if (name == "." || name == "..")
+            continue;
+
+        if (entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            listFiles(directory, relative + name + "/", files);
+        else
+            files.push_back(relative + name);
+    } while (FindNextFileA(find, &entry));
+
+    FindClose(find);
+#else
+    DIR *dir = opendir((directory + relative).c_str());
+    if (!dir)
+        return;
+
+    while (dirent *entry = readdir(dir))
+    {
+        std::string name = entry->d_name;
+        if (name == "." || name == "..")
+            continue;
+
+        struct stat file_stats;
+        if (stat((directory + relative + name).c_str(), &file_stats) != 0)
+            continue;
+
+        if (S_ISDIR(file_stats.st_mode))
+            listFiles(directory, relative + name + "/", files);
+        else
+            files.push_back(relative + name);
+    }
+
+    closedir(dir);
+#endif
+}
+
+
+static bool endsWith(const std::string &value, const std::string &suffix)
+{
+    return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+
+static void splitPath(const std::string &directory, const std::string &relative, std::string &path, std::string &name)
+{
+    std::size_t slash = relative.find_last_of('/');
+    path = directory + relative.substr(0, (slash == std::string::npos) ? 0 : slash + 1);
+    name = (slash == std::string::npos) ? relative : relative.substr(slash + 1);
+}
+
+
+static bool cookModels(ThreadPool &thread_pool)
+{
+    bool success = true;
+    std::string directory = Settings::inst()->getModelDirectory();
+    std::vector<std::string> files;
+    listFiles(directory, "", files);
+
+    // one at a time. each import already spreads its parsing over the pool.
+    for (const auto &file : files)
+    {
+        if (!endsWith(file, ".obj"))
+            continue;
+
+        std::string path, name, error;
+        splitPath(directory, file, path, name);
+
+        MeshCache cache;
+        ImportStatistics statistics;
+        if (!cache.importOBJ(path, name, &thread_pool, statistics, error))
+        {
+            std::cerr << "model | " << file << " failed: " << error << std::endl;
+            success = false;
+        }
+        else if (!cache.write(path, name + ".vvmesh", ObjImporter::version))
+        {
+            std::cerr << "model | " << file << " failed: could not write " << path << name << ".vvmesh" << std::endl;
+            success = false;
+        }
+        else
+            std::cout << "model | " << file << " submeshes: " << cache.submeshes.size() << " vertices: " << cache.vertices.size()
+                      << " indices: " << cache.indices.size() << std::endl;
+
+        cache.shutDown();
+    }
+
+    return success;
+}
+
+
+static bool cookTextures(ThreadPool &thread_pool)
+{
+    bool success = true;
+    std::mutex mutex;
+    std::string directory = Settings::inst()->getAssetDirectory();
+    std::vector<std::string> files;
+    listFiles(directory, "", files);
+
+    // images are independent of each other, so every one is a task of its own
+    for (const auto &file : files)
+    {
+        if (!endsWith(file, ".png") && !endsWith(file, ".jpg"))
+            continue;
+
+        thread_pool.enqueue([&, file]()
+        {
+            std::string path, name, error;
+            splitPath(directory, file, path, name);
+
+            TextureCooker cooker;
+            TextureCache cache;
+            bool cooked = cooker.cook(path, name, cache, error);
+            if (cooked && !cache.write(path, name))
+            {
+                error = "could not write " + path + name + ".vvtex";
+                cooked = false;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (cooked)
+                std::cout << "texture | " << file << " " << cache.width << "x" << cache.height << " levels: " << cache.mip_levels
+                          << ((cache.format == VK_FORMAT_BC3_UNORM_BLOCK) ? " bc3" : " bc1") << std::endl;
+            else
+            {
+                std::cerr << "texture | " << file << " failed: " << error << std::endl;
+                success = false;
+            }
+        });
+    }
+
+    thread_pool.wait();
+    return success;
+}
+
+
+static bool cookShaders()
+{
+    bool success = true;
+    std::string directory = Settings::inst()->getShaderDirectory();
+    std::vector<std::string> files;
+    listFiles(directory, "", files);
+
+    // every compiled vertex + fragment pair is a template Shader::create can load
+    for (const auto &file : files)
+    {
+        if (!endsWith(file, "_frag.spv") || endsWith(file, "_bindless_frag.spv"))
+            continue;
+
+        std::string name = file.substr(0, file.size() - std::string("_frag.spv").size());
+        if (std::find(files.begin(), files.end(), name + "_vert.spv") == files.end())
+            continue;
+
+        bool has_bindless_variant = std::find(files.begin(), files.end(), name + "_bindless_frag.spv") != files.end();
+        for (int bindless = 0; bindless <= (has_bindless_variant ? 1 : 0); ++bindless)
+        {
+            std::string variant = name + (bindless ? " (bindless)" : "");
+            try
+            {
+                Shader shader;
+                if (shader.cook(name, bindless != 0))
+                    std::cout << "shader | " << variant << " descriptors: " << shader.material_descriptor_orderings.size()
+                              << " push constant ranges: " << shader.push_constant_ranges.size() << std::endl;
+                else
+                {
+                    std::cerr << "shader | " << variant << " failed: could not write its .vvshader" << std::endl;
+                    success = false;
+                }
+            }
+            catch (const std::runtime_error &e)
+            {
+                // programs that don't follow the material template layout are never loaded through Shader::create
+                std::cout << "shader | " << variant << " skipped: " << e.what() << std::endl;
+            }
+        }
+    }
+
+    return success;
+}
+
+
+int main()
+{
+    ThreadPool thread_pool;
+    thread_pool.create(Settings::inst()->getImportThreadCount());
+
+    bool success = cookModels(thread_pool);
+    success = cookTextures(thread_pool) && success;
+    success = cookShaders() && success;
+
+    thread_pool.shutDown();
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}